@@ -0,0 +1,605 @@
+// Benchmark das etapas da rotina: roda as funções da biblioteca (as mesmas do
+// bin/out) sobre uma varredura de formas, precisões, domínios e números de
+// threads e informa, por etapa, mínimo, mediana e percentil 90 do tempo, além de
+// GFLOP/s e GB/s pela mediana. Substitui os antigos Tests/Step_*.c.
+//
+// FLOPs e bytes vêm do mesmo modelo da instrumentação (profile_model): 5 N log2 N
+// nas FFTs complexas (2.5 N log2 N nas reais), contagens por elemento nas etapas
+// pontuais e o tráfego mínimo de uma passada, então o GB/s é um limite inferior.
+//
+// make bench ARGS="--shapes 1024x1024,4096x2048 --threads 1,8 --json bench.json"
+//
+// Com --pages 4k,thp,2m,1g, compara as páginas dos buffers grandes (alloc.h) nas
+// etapas A e D: para cada política aloca dados novos e informa as páginas que
+// eles receberam de fato, as faltas de página menores da alocação até a última
+// repetição, os misses do dTLB por chamada (contadores de hardware) e a
+// mediana do tempo.
+
+#include "../include/utils.h"
+#include "../include/fourier.h"
+
+#define BENCH_MAX_SHAPES 32
+#define BENCH_MAX_THREADS 32
+#define BENCH_PAGE_STAGES 2
+
+// Buffers de uma forma: input guarda a imagem original, copiada para I_t antes
+// de cada repetição (fora da medida) para que as etapas in-place não acumulem
+typedef struct
+{
+    size_t rows, columns, spectral_size;
+    opsd_layout layout;
+    opsd_domain domain;
+    void *input, *I_t, *W, *S, *R, *C;
+} bench_data;
+
+typedef struct
+{
+    opsd_stage stage;
+    const char *precision;
+    const char *domain;
+    size_t rows, columns;
+    int threads;
+    double min, median, p90, gflops, gbs;
+} bench_result;
+
+static int compare_times(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil pelo posto mais próximo de amostras já ordenadas
+static double percentile(const double *sorted, size_t count, double p)
+{
+    size_t rank = (size_t)ceil(p / 100.0 * count);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+//CVECTOR STAGES
+
+static void run_cstage(opsd_stage stage, bench_data *data)
+{
+    size_t rows = data->rows, columns = data->columns;
+    opsd_layout layout = data->layout;
+    MKL_Complex8 *I_t = data->I_t, *W = data->W, *S = data->S, *R = data->R, *C = data->C;
+
+    if (data->domain == OPSD_REAL)
+    {
+        switch (stage)
+        {
+        case OPSD_STAGE_A_FFT2D: compute_cfft2d_real(I_t, rows, columns, layout); break;
+        case OPSD_STAGE_B_BORDER: compute_cperiodic_border_B_real(I_t, S, rows, columns, layout); break;
+        case OPSD_STAGE_B_EDGES: compute_cborder_edges_real(I_t, R, C, rows, columns, layout); break;
+        case OPSD_STAGE_C_FFT_BORDER: compute_cfft2d_of_border_B_real(S, rows, columns, layout); break;
+        case OPSD_STAGE_D_SMOOTH: compute_csmooth_component_S_real(I_t, rows, columns, layout); break;
+        case OPSD_STAGE_E_PERIODIC: compute_cperiodic_component_P_real(I_t, S, rows, columns, layout); break;
+        case OPSD_STAGE_CDE_FUSED: compute_cperiodic_component_P_fused_real(I_t, R, C, NULL, rows, columns, layout); break;
+        case OPSD_STAGE_A_FFT2D_SHIFTED: compute_cfft2d_real_shifted(I_t, W, rows, columns, layout); break;
+        case OPSD_STAGE_CDE_FUSED_SHIFTED: compute_cperiodic_component_P_fused_real_shifted(I_t, R, C, NULL, rows, columns, layout); break;
+        case OPSD_STAGE_FFTSHIFT: compute_cfftshift_real(I_t, W, rows, columns, layout); break;
+        case OPSD_STAGE_IFFT2D: compute_cifft2d_real(I_t, rows, columns, layout); break;
+        default: break;
+        }
+        return;
+    }
+
+    switch (stage)
+    {
+    case OPSD_STAGE_A_FFT2D: compute_cfft2d(I_t, rows, columns, layout); break;
+    case OPSD_STAGE_B_BORDER: compute_cperiodic_border_B(I_t, S, rows, columns, layout); break;
+    case OPSD_STAGE_B_EDGES: compute_cborder_edges(I_t, R, C, rows, columns, layout); break;
+    case OPSD_STAGE_C_FFT_BORDER: compute_cfft2d_of_border_B(S, rows, columns, layout); break;
+    case OPSD_STAGE_D_SMOOTH: compute_csmooth_component_S(I_t, rows, columns, layout); break;
+    case OPSD_STAGE_E_PERIODIC: compute_cperiodic_component_P(I_t, S, rows, columns, layout); break;
+    case OPSD_STAGE_CDE_FUSED: compute_cperiodic_component_P_fused(I_t, R, C, NULL, rows, columns, layout); break;
+    case OPSD_STAGE_A_FFT2D_SHIFTED: compute_cfft2d_shifted(I_t, W, rows, columns, layout); break;
+    case OPSD_STAGE_CDE_FUSED_SHIFTED: compute_cperiodic_component_P_fused_shifted(I_t, R, C, NULL, rows, columns, layout); break;
+    case OPSD_STAGE_FFTSHIFT: compute_cfftshift(I_t, W, rows, columns, layout); break;
+    case OPSD_STAGE_IFFT2D: compute_cifft2d(I_t, rows, columns, layout); break;
+    default: break;
+    }
+}
+
+static void init_cdata(bench_data *data)
+{
+    size_t rows = data->rows, columns = data->columns, size = rows * columns;
+    size_t lines = data->layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    MKL_Complex8 *input = NULL, *I_t = NULL, *W = NULL, *S = NULL, *R = NULL, *C = NULL;
+
+    data->spectral_size = data->domain == OPSD_REAL ? lines * (length / 2 + 1) : size;
+    init_cvector(&input, data->spectral_size);
+    init_cvector(&I_t, data->spectral_size);
+    init_cvector(&W, data->spectral_size);
+    init_cvector(&S, data->spectral_size);
+    init_cvector(&R, columns);
+    init_cvector(&C, rows);
+
+    if (data->domain == OPSD_REAL)
+    {
+        fill_fmatrix((float *)input, rows, columns, 1);
+        pad_fvector_rows((float *)input, lines, length);
+        compute_cborder_edges_real(input, R, C, rows, columns, data->layout);
+    }
+    else
+    {
+        fill_cmatrix(input, rows, columns, 1);
+        compute_cborder_edges(input, R, C, rows, columns, data->layout);
+    }
+    memset(S, 0, data->spectral_size * sizeof(MKL_Complex8));
+
+    data->input = input;
+    data->I_t = I_t;
+    data->W = W;
+    data->S = S;
+    data->R = R;
+    data->C = C;
+}
+
+static void free_cdata(bench_data *data)
+{
+    free_cvector(data->C);
+    free_cvector(data->R);
+    free_cvector(data->S);
+    free_cvector(data->W);
+    free_cvector(data->I_t);
+    free_cvector(data->input);
+}
+
+static void restore_cdata(bench_data *data)
+{
+    cblas_ccopy(data->spectral_size, data->input, 1, data->I_t, 1);
+}
+
+//ZVECTOR STAGES
+
+static void run_zstage(opsd_stage stage, bench_data *data)
+{
+    size_t rows = data->rows, columns = data->columns;
+    opsd_layout layout = data->layout;
+    MKL_Complex16 *I_t = data->I_t, *W = data->W, *S = data->S, *R = data->R, *C = data->C;
+
+    if (data->domain == OPSD_REAL)
+    {
+        switch (stage)
+        {
+        case OPSD_STAGE_A_FFT2D: compute_zfft2d_real(I_t, rows, columns, layout); break;
+        case OPSD_STAGE_B_BORDER: compute_zperiodic_border_B_real(I_t, S, rows, columns, layout); break;
+        case OPSD_STAGE_B_EDGES: compute_zborder_edges_real(I_t, R, C, rows, columns, layout); break;
+        case OPSD_STAGE_C_FFT_BORDER: compute_zfft2d_of_border_B_real(S, rows, columns, layout); break;
+        case OPSD_STAGE_D_SMOOTH: compute_zsmooth_component_S_real(I_t, rows, columns, layout); break;
+        case OPSD_STAGE_E_PERIODIC: compute_zperiodic_component_P_real(I_t, S, rows, columns, layout); break;
+        case OPSD_STAGE_CDE_FUSED: compute_zperiodic_component_P_fused_real(I_t, R, C, NULL, rows, columns, layout); break;
+        case OPSD_STAGE_A_FFT2D_SHIFTED: compute_zfft2d_real_shifted(I_t, W, rows, columns, layout); break;
+        case OPSD_STAGE_CDE_FUSED_SHIFTED: compute_zperiodic_component_P_fused_real_shifted(I_t, R, C, NULL, rows, columns, layout); break;
+        case OPSD_STAGE_FFTSHIFT: compute_zfftshift_real(I_t, W, rows, columns, layout); break;
+        case OPSD_STAGE_IFFT2D: compute_zifft2d_real(I_t, rows, columns, layout); break;
+        default: break;
+        }
+        return;
+    }
+
+    switch (stage)
+    {
+    case OPSD_STAGE_A_FFT2D: compute_zfft2d(I_t, rows, columns, layout); break;
+    case OPSD_STAGE_B_BORDER: compute_zperiodic_border_B(I_t, S, rows, columns, layout); break;
+    case OPSD_STAGE_B_EDGES: compute_zborder_edges(I_t, R, C, rows, columns, layout); break;
+    case OPSD_STAGE_C_FFT_BORDER: compute_zfft2d_of_border_B(S, rows, columns, layout); break;
+    case OPSD_STAGE_D_SMOOTH: compute_zsmooth_component_S(I_t, rows, columns, layout); break;
+    case OPSD_STAGE_E_PERIODIC: compute_zperiodic_component_P(I_t, S, rows, columns, layout); break;
+    case OPSD_STAGE_CDE_FUSED: compute_zperiodic_component_P_fused(I_t, R, C, NULL, rows, columns, layout); break;
+    case OPSD_STAGE_A_FFT2D_SHIFTED: compute_zfft2d_shifted(I_t, W, rows, columns, layout); break;
+    case OPSD_STAGE_CDE_FUSED_SHIFTED: compute_zperiodic_component_P_fused_shifted(I_t, R, C, NULL, rows, columns, layout); break;
+    case OPSD_STAGE_FFTSHIFT: compute_zfftshift(I_t, W, rows, columns, layout); break;
+    case OPSD_STAGE_IFFT2D: compute_zifft2d(I_t, rows, columns, layout); break;
+    default: break;
+    }
+}
+
+static void init_zdata(bench_data *data)
+{
+    size_t rows = data->rows, columns = data->columns, size = rows * columns;
+    size_t lines = data->layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    MKL_Complex16 *input = NULL, *I_t = NULL, *W = NULL, *S = NULL, *R = NULL, *C = NULL;
+
+    data->spectral_size = data->domain == OPSD_REAL ? lines * (length / 2 + 1) : size;
+    init_zvector(&input, data->spectral_size);
+    init_zvector(&I_t, data->spectral_size);
+    init_zvector(&W, data->spectral_size);
+    init_zvector(&S, data->spectral_size);
+    init_zvector(&R, columns);
+    init_zvector(&C, rows);
+
+    if (data->domain == OPSD_REAL)
+    {
+        fill_dmatrix((double *)input, rows, columns, 1);
+        pad_dvector_rows((double *)input, lines, length);
+        compute_zborder_edges_real(input, R, C, rows, columns, data->layout);
+    }
+    else
+    {
+        fill_zmatrix(input, rows, columns, 1);
+        compute_zborder_edges(input, R, C, rows, columns, data->layout);
+    }
+    memset(S, 0, data->spectral_size * sizeof(MKL_Complex16));
+
+    data->input = input;
+    data->I_t = I_t;
+    data->W = W;
+    data->S = S;
+    data->R = R;
+    data->C = C;
+}
+
+static void free_zdata(bench_data *data)
+{
+    free_zvector(data->C);
+    free_zvector(data->R);
+    free_zvector(data->S);
+    free_zvector(data->W);
+    free_zvector(data->I_t);
+    free_zvector(data->input);
+}
+
+static void restore_zdata(bench_data *data)
+{
+    cblas_zcopy(data->spectral_size, data->input, 1, data->I_t, 1);
+}
+
+//BENCHMARK
+
+// Uma repetição fora da medida cria os planos da forma e aquece os caches
+static void measure(opsd_stage stage, bench_data *data, int precision, int repeat, double *times)
+{
+    for (int r = -1; r < repeat; r++)
+    {
+        if (precision)
+            restore_zdata(data);
+        else
+            restore_cdata(data);
+
+        double start = omp_get_wtime();
+        if (precision)
+            run_zstage(stage, data);
+        else
+            run_cstage(stage, data);
+        double elapsed = omp_get_wtime() - start;
+
+        // Os contadores do --pages deixam a repetição de aquecimento de fora
+        if (r < 0)
+            profile_reset();
+        else
+            times[r] = elapsed;
+    }
+    qsort(times, repeat, sizeof(double), compare_times);
+}
+
+static long minor_faults(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+// Maior página que os buffers grandes liberados desde before receberam de
+// fato, com a fração dos bytes nela ("thp 62%": o resto caiu em páginas
+// menores); "-" quando a forma não tem nenhum buffer grande
+static void pages_got(const opsd_memory *before, char *got, size_t length)
+{
+    opsd_memory after;
+    size_t total = 0;
+    memory_stats(&after);
+    for (int pages = 0; pages < OPSD_PAGES_COUNT; pages++)
+        total += after.paged[pages] - before->paged[pages];
+
+    snprintf(got, length, "-");
+    for (int pages = OPSD_PAGES_COUNT - 1; pages >= 0; pages--)
+    {
+        size_t bytes = after.paged[pages] - before->paged[pages];
+        if (bytes)
+        {
+            snprintf(got, length, "%s %.0f%%", memory_pages_name(pages), 100.0 * bytes / total);
+            break;
+        }
+    }
+}
+
+// --pages: as etapas A e D de cada forma com cada política de páginas
+static void run_pages(const size_t *shapes, size_t shape_count, const int *precisions, const int *domains,
+                      const size_t *threads, size_t thread_count, opsd_layout layout, const opsd_pages *pages,
+                      size_t page_count, int repeat, double *times)
+{
+    const opsd_stage stages[BENCH_PAGE_STAGES] = {OPSD_STAGE_A_FFT2D, OPSD_STAGE_D_SMOOTH};
+    int dtlb = counters_enable() && counter_available(OPSD_COUNTER_DTLB_MISSES);
+
+    printf("%-18s %-6s %-7s %11s %7s %-5s %-9s %11s %13s %11s\n",
+           "stage", "prec", "domain", "shape", "threads", "pages", "got", "faults", "dTLB/call", "median (s)");
+
+    for (size_t s = 0; s < shape_count; s++)
+    {
+        for (int precision = 0; precision < 2; precision++)
+        {
+            for (int domain = 0; domain < 2; domain++)
+            {
+                if (!precisions[precision] || !domains[domain])
+                    continue;
+
+                for (size_t t = 0; t < thread_count; t++)
+                {
+                    omp_set_num_threads(threads[t]);
+                    mkl_set_num_threads(threads[t]);
+
+                    for (int k = 0; k < BENCH_PAGE_STAGES; k++)
+                    {
+                        for (size_t p = 0; p < page_count; p++)
+                        {
+                            // Dados e planos novos: as faltas contam a alocação e o primeiro toque
+                            bench_data data = {shapes[2 * s], shapes[2 * s + 1], 0, layout, domain ? OPSD_REAL : OPSD_COMPLEX};
+                            opsd_memory before;
+                            opsd_stage_stats stats;
+                            memory_set_pages(pages[p]);
+                            memory_stats(&before);
+                            long faults = minor_faults();
+
+                            if (precision)
+                                init_zdata(&data);
+                            else
+                                init_cdata(&data);
+                            measure(stages[k], &data, precision, repeat, times);
+                            faults = minor_faults() - faults;
+                            profile_stats(stages[k], &stats);
+
+                            // As páginas recebidas são contadas quando os buffers são liberados
+                            char got[16];
+                            if (precision)
+                                free_zdata(&data);
+                            else
+                                free_cdata(&data);
+                            destroy_plans();
+                            pages_got(&before, got, sizeof(got));
+
+                            printf("%-18s %-6s %-7s %5zux%-5zu %7zu %-5s %-9s %11ld ", profile_stage_name(stages[k]),
+                                   precision ? "double" : "single", domain ? "real" : "complex", data.rows, data.columns,
+                                   threads[t], memory_pages_name(pages[p]), got, faults);
+                            if (dtlb && stats.calls)
+                                printf("%13.0f", stats.counters[OPSD_COUNTER_DTLB_MISSES] / stats.calls);
+                            else
+                                printf("%13s", "-");
+                            printf(" %11.6f\n", percentile(times, repeat, 50.0));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+static size_t parse_list(const char *list, size_t *values, size_t capacity, int shapes)
+{
+    size_t count = 0;
+    const char *cursor = list;
+    while (*cursor != '\0' && count < capacity)
+    {
+        char *end;
+        values[count] = strtoul(cursor, &end, 10);
+        if (shapes)
+            values[count + 1] = *end == 'x' ? strtoul(end + 1, &end, 10) : values[count];
+        if (end == cursor || values[count] == 0 || (shapes && values[count + 1] == 0))
+            return 0;
+
+        count += shapes ? 2 : 1;
+        cursor = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0')
+            return 0;
+    }
+    return shapes ? count / 2 : count;
+}
+
+static void write_json(const char *filename, const bench_result *results, size_t count, int repeat, const char *layout)
+{
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        perror("Erro ao abrir o arquivo para escrita");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(file, "[\n");
+    for (size_t k = 0; k < count; k++)
+    {
+        const bench_result *r = &results[k];
+        fprintf(file, "  {\"stage\": \"%s\", \"precision\": \"%s\", \"domain\": \"%s\", \"layout\": \"%s\", "
+                      "\"rows\": %zu, \"columns\": %zu, \"threads\": %d, \"repeat\": %d, "
+                      "\"min_s\": %.9f, \"median_s\": %.9f, \"p90_s\": %.9f, \"gflops\": %.3f, \"gbs\": %.3f}%s\n",
+                profile_stage_name(r->stage), r->precision, r->domain, layout, r->rows, r->columns, r->threads, repeat,
+                r->min, r->median, r->p90, r->gflops, r->gbs, k + 1 < count ? "," : "");
+    }
+    fprintf(file, "]\n");
+    fclose(file);
+}
+
+static void write_csv(const char *filename, const bench_result *results, size_t count, int repeat, const char *layout)
+{
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        perror("Erro ao abrir o arquivo para escrita");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(file, "stage,precision,domain,layout,rows,columns,threads,repeat,min_s,median_s,p90_s,gflops,gbs\n");
+    for (size_t k = 0; k < count; k++)
+    {
+        const bench_result *r = &results[k];
+        fprintf(file, "%s,%s,%s,%s,%zu,%zu,%d,%d,%.9f,%.9f,%.9f,%.3f,%.3f\n",
+                profile_stage_name(r->stage), r->precision, r->domain, layout, r->rows, r->columns, r->threads, repeat,
+                r->min, r->median, r->p90, r->gflops, r->gbs);
+    }
+    fclose(file);
+}
+
+static void usage(const char *bin)
+{
+    printf("Use: %s [--shapes MxN,...] [--precision single,double] [--domain complex,real] [--threads T,...]\n", bin);
+    printf("     [--layout row|column] [--repeat R] [--json file] [--csv file] [--pages 4k,thp,2m,1g]\n");
+}
+
+int main(int argc, char const *argv[])
+{
+    const char *shapes_arg = "512x512,1024x1024,2048x2048", *precision_arg = "single,double", *domain_arg = "complex,real";
+    const char *json = NULL, *csv = NULL, *layout_arg = "row", *pages_arg = NULL;
+    char threads_arg[32];
+    int repeat = 20;
+    snprintf(threads_arg, sizeof(threads_arg), "%d", omp_get_max_threads());
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value != NULL && !strcmp(argv[i], "--shapes"))
+            shapes_arg = value;
+        else if (value != NULL && !strcmp(argv[i], "--precision"))
+            precision_arg = value;
+        else if (value != NULL && !strcmp(argv[i], "--domain"))
+            domain_arg = value;
+        else if (value != NULL && !strcmp(argv[i], "--threads"))
+            snprintf(threads_arg, sizeof(threads_arg), "%s", value);
+        else if (value != NULL && !strcmp(argv[i], "--layout"))
+            layout_arg = value;
+        else if (value != NULL && !strcmp(argv[i], "--repeat"))
+            repeat = atoi(value);
+        else if (value != NULL && !strcmp(argv[i], "--json"))
+            json = value;
+        else if (value != NULL && !strcmp(argv[i], "--csv"))
+            csv = value;
+        else if (value != NULL && !strcmp(argv[i], "--pages"))
+            pages_arg = value;
+        else
+        {
+            usage(argv[0]);
+            return -1;
+        }
+        i++;
+    }
+
+    size_t shapes[2 * BENCH_MAX_SHAPES], threads[BENCH_MAX_THREADS];
+    size_t shape_count = parse_list(shapes_arg, shapes, 2 * BENCH_MAX_SHAPES, 1);
+    size_t thread_count = parse_list(threads_arg, threads, BENCH_MAX_THREADS, 0);
+    int precisions[2] = {strstr(precision_arg, "single") != NULL, strstr(precision_arg, "double") != NULL};
+    int domains[2] = {strstr(domain_arg, "complex") != NULL, strstr(domain_arg, "real") != NULL};
+    opsd_layout layout = !strcmp(layout_arg, "column") ? OPSD_COLUMN_MAJOR : OPSD_ROW_MAJOR;
+
+    opsd_pages pages[OPSD_PAGES_COUNT];
+    size_t page_count = 0;
+    for (const char *cursor = pages_arg; cursor != NULL && *cursor != '\0' && page_count < OPSD_PAGES_COUNT;)
+    {
+        char name[8];
+        size_t length = strcspn(cursor, ",");
+        snprintf(name, sizeof(name), "%.*s", (int)length, cursor);
+        if (!memory_parse_pages(name, &pages[page_count++]))
+        {
+            usage(argv[0]);
+            return -1;
+        }
+        cursor += cursor[length] == ',' ? length + 1 : length;
+    }
+
+    if (!shape_count || !thread_count || repeat < 1 || !(precisions[0] || precisions[1]) || !(domains[0] || domains[1]) ||
+        (strcmp(layout_arg, "row") && strcmp(layout_arg, "column")) || (pages_arg != NULL && !page_count))
+    {
+        usage(argv[0]);
+        return -1;
+    }
+
+    if (page_count)
+    {
+        double *times = malloc(repeat * sizeof(double));
+        if (times == NULL)
+        {
+            printf("Allocation error!\n");
+            return -1;
+        }
+        run_pages(shapes, shape_count, precisions, domains, threads, thread_count, layout, pages, page_count, repeat,
+                  times);
+        free(times);
+        return 0;
+    }
+
+    size_t capacity = shape_count * thread_count * 2 * 2 * OPSD_STAGE_LOAD, count = 0;
+    bench_result *results = malloc(capacity * sizeof(bench_result));
+    double *times = malloc(repeat * sizeof(double));
+    if (results == NULL || times == NULL)
+    {
+        printf("Allocation error!\n");
+        return -1;
+    }
+
+    printf("%-18s %-6s %-7s %11s %7s %11s %11s %11s %9s %9s\n",
+           "stage", "prec", "domain", "shape", "threads", "min (s)", "median (s)", "p90 (s)", "GFLOP/s", "GB/s");
+
+    for (size_t s = 0; s < shape_count; s++)
+    {
+        for (int precision = 0; precision < 2; precision++)
+        {
+            for (int domain = 0; domain < 2; domain++)
+            {
+                if (!precisions[precision] || !domains[domain])
+                    continue;
+
+                bench_data data = {shapes[2 * s], shapes[2 * s + 1], 0, layout, domain ? OPSD_REAL : OPSD_COMPLEX};
+                if (precision)
+                    init_zdata(&data);
+                else
+                    init_cdata(&data);
+
+                // O modelo recebe a forma row-major, como as etapas a veem
+                size_t model_rows = layout == OPSD_ROW_MAJOR ? data.rows : data.columns;
+                size_t model_columns = layout == OPSD_ROW_MAJOR ? data.columns : data.rows;
+
+                for (size_t t = 0; t < thread_count; t++)
+                {
+                    omp_set_num_threads(threads[t]);
+                    mkl_set_num_threads(threads[t]);
+
+                    // As etapas de computação vêm antes de load e save no enum
+                    for (int stage = 0; stage < OPSD_STAGE_LOAD; stage++)
+                    {
+                        double read, written, flops;
+                        measure(stage, &data, precision, repeat, times);
+                        profile_model(stage, precision ? OPSD_DOUBLE : OPSD_SINGLE, data.domain, model_rows, model_columns,
+                                      &read, &written, &flops);
+
+                        bench_result *r = &results[count++];
+                        r->stage = stage;
+                        r->precision = precision ? "double" : "single";
+                        r->domain = domain ? "real" : "complex";
+                        r->rows = data.rows;
+                        r->columns = data.columns;
+                        r->threads = threads[t];
+                        r->min = times[0];
+                        r->median = percentile(times, repeat, 50.0);
+                        r->p90 = percentile(times, repeat, 90.0);
+                        r->gflops = flops / r->median / 1e9;
+                        r->gbs = (read + written) / r->median / 1e9;
+
+                        printf("%-18s %-6s %-7s %5zux%-5zu %7d %11.6f %11.6f %11.6f %9.2f %9.2f\n",
+                               profile_stage_name(stage), r->precision, r->domain, r->rows, r->columns, r->threads,
+                               r->min, r->median, r->p90, r->gflops, r->gbs);
+                    }
+                }
+
+                if (precision)
+                    free_zdata(&data);
+                else
+                    free_cdata(&data);
+                destroy_plans();
+            }
+        }
+    }
+
+    if (json != NULL)
+        write_json(json, results, count, repeat, layout_arg);
+    if (csv != NULL)
+        write_csv(csv, results, count, repeat, layout_arg);
+
+    free(times);
+    free(results);
+
+    return 0;
+}
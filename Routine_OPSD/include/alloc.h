@@ -0,0 +1,62 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include "common.h"
+#include "numa.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/resource.h>
+
+// Every buffer starts on a cache line, which is also the widest SIMD load
+// (AVX-512) of MKL's kernels
+#define OPSD_ALIGNMENT 64
+// Buffers from this size up get pages of their own (the policy below) and are
+// placed by the NUMA policy of numa.h; plan tables, edges and queue entries
+// stay on malloc
+#define OPSD_LARGE_BYTES ((size_t)2 << 20)
+
+// Pages behind the large buffers, set at load time from OPSD_PAGES: "4k",
+// "thp" (default: a 2M-aligned mapping offered to transparent huge pages),
+// "2m" or "1g" (explicit pages from the hugetlbfs pool, vm.nr_hugepages).
+// When the pool runs short a buffer falls back to the next smaller size, down
+// to THP, and the kernel itself falls back to 4K pages, so a buffer never
+// fails for lack of huge pages. The pages a THP buffer really got are read
+// from /proc/self/smaps when it is freed.
+typedef enum
+{
+    OPSD_PAGES_4K,
+    OPSD_PAGES_THP,
+    OPSD_PAGES_2M,
+    OPSD_PAGES_1G,
+    OPSD_PAGES_COUNT
+} opsd_pages;
+
+// Tracked heap: every buffer of the library (init_*vector, plans, writer
+// snapshots) goes through opsd_malloc/opsd_free, which keep the bytes live and
+// their high-water mark. MKL's own DFTI workspace is not seen here, only in
+// the peak RSS.
+typedef struct
+{
+    size_t live, peak;                // bytes
+    size_t allocations;               // opsd_malloc/opsd_calloc/opsd_realloc calls
+    size_t peak_rss;                  // bytes, from getrusage
+    size_t paged[OPSD_PAGES_COUNT];   // bytes of large buffers on each page size, counted when freed
+} opsd_memory;
+
+void *opsd_malloc(size_t bytes);
+void *opsd_calloc(size_t count, size_t bytes);
+void *opsd_realloc(void *pointer, size_t bytes);
+void opsd_free(void *pointer);
+void memory_stats(opsd_memory *memory);
+
+void memory_set_pages(opsd_pages pages);
+opsd_pages memory_pages(void);
+const char *memory_pages_name(opsd_pages pages);
+int memory_parse_pages(const char *name, opsd_pages *pages); // 0 when name is not a page policy
+
+// A window keeps the most bytes live between its open and close, whichever
+// thread allocated them. Returns -1 when every window is taken.
+int memory_window_open(void);
+size_t memory_window_close(int window);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "pipeline.h"
+#include <dirent.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+// Images per batched FFT: as many as fit OPSD_BATCH_BYTES of spectra, at most
+// OPSD_BATCH_IMAGES. Larger images go one at a time.
+#define OPSD_BATCH_IMAGES 64
+#define OPSD_BATCH_BYTES (32 << 20)
+
+// Batch mode: job->dir names a source inside ../bin holding same-shape images
+// (see list_images), processed with shared plans while the next group of
+// images is read in the background.
+void run_cbatch(const opsd_job *job);
+void run_zbatch(const opsd_job *job);
+
+#endif
@@ -17,5 +17,8 @@
 #include "omp.h"
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #endif
\ No newline at end of file
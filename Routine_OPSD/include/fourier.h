@@ -2,25 +2,82 @@
 #define FOURIER_H
 
 #include "common.h"
+#include "plan.h"
+#include "utils.h"
+#include "profile.h"
 
-void compute_cfft2d(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns);
-void compute_cifft2d(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns);
-void compute_cfft2d_column_row(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns);
-void compute_cperiodic_border_B(MKL_Complex8 *I_t, MKL_Complex8 *B_t, size_t rows, size_t columns);
-void compute_cfft2d_of_border_B(MKL_Complex8 *B_t_B_w, size_t rows, size_t columns);
-void compute_csmooth_component_S(MKL_Complex8 *B_S, size_t rows, size_t columns);
-void compute_csmooth_component_S_2(MKL_Complex8 *B_S, size_t rows, size_t columns);
-void compute_cperiodic_component_P(MKL_Complex8 *I_w, MKL_Complex8 *S, size_t rows, size_t columns);
-void compute_cfftshift(MKL_Complex8 *vector, size_t rows, size_t columns);
+void compute_cfft2d(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_cifft2d(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfft2d_batch(MKL_Complex8 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout);
+void compute_cifft2d_batch(MKL_Complex8 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfft2d_column_row(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_cperiodic_border_B(MKL_Complex8 *I_t, MKL_Complex8 *B_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfft2d_of_border_B(MKL_Complex8 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfft2d_of_border_B_batch(MKL_Complex8 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_csmooth_component_S(MKL_Complex8 *B_S, size_t rows, size_t columns, opsd_layout layout);
+void compute_cperiodic_component_P(MKL_Complex8 *I_w, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_cborder_edges(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout);
+void compute_cborder_edges_modulated(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout);
+void compute_cperiodic_component_P_fused(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfftshift(MKL_Complex8 *in, MKL_Complex8 *out, size_t rows, size_t columns, opsd_layout layout);
+MKL_Complex8 *compute_cfft2d_shifted(MKL_Complex8 *I_t, MKL_Complex8 *work, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfft2d_modulated(MKL_Complex8 *I_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_cperiodic_component_P_fused_shifted(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_cedge_spectra(MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_domain domain);
+void compute_cperiodic_component_P_fused_columns(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns,
+                                                 size_t first, size_t count, opsd_domain domain);
 
-void compute_zfft2d(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns);
-void compute_zifft2d(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns);
-void compute_zfft2d_column_row(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns);
-void compute_zperiodic_border_B(MKL_Complex16 *I_t, MKL_Complex16 *B_t, size_t rows, size_t columns);
-void compute_zfft2d_of_border_B(MKL_Complex16 *B_t_B_w, size_t rows, size_t columns);
-void compute_zsmooth_component_S(MKL_Complex16 *B_S, size_t rows, size_t columns);
-void compute_zsmooth_component_S_2(MKL_Complex16 *B_S, size_t rows, size_t columns);
-void compute_zperiodic_component_P(MKL_Complex16 *I_w, MKL_Complex16 *S, size_t rows, size_t columns);
-void compute_zfftshift(MKL_Complex16 *vector, size_t rows, size_t columns);
+void compute_cfft2d_real(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_cifft2d_real(MKL_Complex8 *I_w_I_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfft2d_real_batch(MKL_Complex8 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout);
+void compute_cifft2d_real_batch(MKL_Complex8 *I_w_I_t, size_t count, size_t rows, size_t columns, opsd_layout layout);
+void compute_cperiodic_border_B_real(MKL_Complex8 *I_t, MKL_Complex8 *B_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfft2d_of_border_B_real(MKL_Complex8 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_csmooth_component_S_real(MKL_Complex8 *B_S, size_t rows, size_t columns, opsd_layout layout);
+void compute_cperiodic_component_P_real(MKL_Complex8 *I_w, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_cborder_edges_real(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout);
+void compute_cborder_edges_real_modulated(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout);
+void compute_cperiodic_component_P_fused_real(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfftshift_real(MKL_Complex8 *in, MKL_Complex8 *out, size_t rows, size_t columns, opsd_layout layout);
+MKL_Complex8 *compute_cfft2d_real_shifted(MKL_Complex8 *I_t, MKL_Complex8 *work, size_t rows, size_t columns, opsd_layout layout);
+void compute_cfft2d_real_modulated(MKL_Complex8 *I_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_cperiodic_component_P_fused_real_shifted(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout);
+
+void compute_zfft2d(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_zifft2d(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfft2d_batch(MKL_Complex16 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout);
+void compute_zifft2d_batch(MKL_Complex16 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfft2d_column_row(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_zperiodic_border_B(MKL_Complex16 *I_t, MKL_Complex16 *B_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfft2d_of_border_B(MKL_Complex16 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfft2d_of_border_B_batch(MKL_Complex16 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_zsmooth_component_S(MKL_Complex16 *B_S, size_t rows, size_t columns, opsd_layout layout);
+void compute_zperiodic_component_P(MKL_Complex16 *I_w, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_zborder_edges(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout);
+void compute_zborder_edges_modulated(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout);
+void compute_zperiodic_component_P_fused(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfftshift(MKL_Complex16 *in, MKL_Complex16 *out, size_t rows, size_t columns, opsd_layout layout);
+MKL_Complex16 *compute_zfft2d_shifted(MKL_Complex16 *I_t, MKL_Complex16 *work, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfft2d_modulated(MKL_Complex16 *I_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_zperiodic_component_P_fused_shifted(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_zedge_spectra(MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_domain domain);
+void compute_zperiodic_component_P_fused_columns(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns,
+                                                 size_t first, size_t count, opsd_domain domain);
+
+void compute_zfft2d_real(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_zifft2d_real(MKL_Complex16 *I_w_I_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfft2d_real_batch(MKL_Complex16 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout);
+void compute_zifft2d_real_batch(MKL_Complex16 *I_w_I_t, size_t count, size_t rows, size_t columns, opsd_layout layout);
+void compute_zperiodic_border_B_real(MKL_Complex16 *I_t, MKL_Complex16 *B_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfft2d_of_border_B_real(MKL_Complex16 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout);
+void compute_zsmooth_component_S_real(MKL_Complex16 *B_S, size_t rows, size_t columns, opsd_layout layout);
+void compute_zperiodic_component_P_real(MKL_Complex16 *I_w, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_zborder_edges_real(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout);
+void compute_zborder_edges_real_modulated(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout);
+void compute_zperiodic_component_P_fused_real(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfftshift_real(MKL_Complex16 *in, MKL_Complex16 *out, size_t rows, size_t columns, opsd_layout layout);
+MKL_Complex16 *compute_zfft2d_real_shifted(MKL_Complex16 *I_t, MKL_Complex16 *work, size_t rows, size_t columns, opsd_layout layout);
+void compute_zfft2d_real_modulated(MKL_Complex16 *I_t, size_t rows, size_t columns, opsd_layout layout);
+void compute_zperiodic_component_P_fused_real_shifted(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include "common.h"
+#include <pthread.h>
+
+#define OPSD_NUMA_MAX_NODES 64
+
+// NUMA policy, set at load time from OPSD_NUMA: "0" turns it off, "1" forces
+// it on a single-node host, unset enables it when the host has several nodes.
+// While it is on, the large buffers of alloc.h (fresh pages from mmap) are
+// touched first by the OpenMP team in static chunks, the partition of the row
+// and column loops of the stages, so each page lands on the node of the thread
+// that works on it.
+// Unless OMP_PLACES, OMP_PROC_BIND, GOMP_CPU_AFFINITY or KMP_AFFINITY set a
+// policy already, the team is pinned spread over the allowed CPUs in node
+// order. MKL's threads are the same team: at load time the library selects the
+// MKL threading layer of its own OpenMP runtime (GNU under gcc) unless
+// MKL_THREADING_LAYER is set, and opsd_shared_team tells whether they share it.
+extern int opsd_numa;
+extern int opsd_shared_team;
+
+int numa_nodes(void);
+
+// First touch of a fresh mapping, one write per page of the given size
+void numa_touch(void *data, size_t bytes, size_t page);
+
+// Restricts the process to its share of the allowed CPUs, in node order, e.g.
+// one MPI rank out of parts on the same host. Call it before any large buffer.
+void numa_bind_share(int part, int parts);
+
+// Node of a sample of the pages of every large buffer when it is freed, with
+// or without the policy; placement[node] gets the bytes on each node.
+void numa_sample(const void *pointer, size_t bytes);
+int numa_placement(double *placement);
+
+#endif
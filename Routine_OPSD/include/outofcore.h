@@ -0,0 +1,38 @@
+#ifndef OUTOFCORE_H
+#define OUTOFCORE_H
+
+#include "pipeline.h"
+
+// Out-of-core mode for images larger than memory: the 2D FFT runs as slabs over
+// an on-disk scratch holding the transposed spectrum, in three passes. Row
+// slabs take the row FFTs and the edge differences, column slabs read back
+// contiguously take the column FFTs and Steps C-E, and for ccr row slabs again
+// take the inverse row FFTs. Every product is written straight into its file.
+// The slabs are sized so that the tracked buffers stay within budget bytes.
+// Reads ../bin/<dir>/data.bin.
+void run_coutofcore(const opsd_job *job, size_t budget);
+void run_zoutofcore(const opsd_job *job, size_t budget);
+
+// File helpers, also used by the MPI build. transfer_block moves a block_rows x
+// block_width block, row-major in memory, to or from a row-major file_rows x
+// file_width matrix of 'element'-byte values: block row r is file row
+// (r + row_shift) mod file_rows and starts at column (column + column_shift)
+// mod file_width, wrapping around to column 0 the way an fftshift does.
+// open_product opens ../bin/<dir>/<name>.bin of the product with that bit index,
+// creating it with bytes bytes when create is set, and close_products syncs
+// and closes the 7 product files (-1 is skipped).
+void transfer_block(int fd, void *block, size_t block_rows, size_t block_width, size_t element, size_t file_rows,
+                    size_t file_width, size_t column, size_t row_shift, size_t column_shift, int write);
+int open_product(const opsd_job *job, int product, size_t bytes, int create);
+void close_products(int *outputs);
+
+// Slab steps shared with the MPI build: the edge differences of a row slab
+// and the plain and centered products of a transposed column slab
+void gather_cedges(const float *raw, MKL_Complex8 *R, MKL_Complex8 *C, size_t first, size_t count, size_t rows, size_t columns);
+void save_ccolumns(int plain, int shifted, MKL_Complex8 *slab, MKL_Complex8 *T, size_t rows, size_t width, size_t first,
+                   size_t count, size_t column_shift);
+void gather_zedges(const double *raw, MKL_Complex16 *R, MKL_Complex16 *C, size_t first, size_t count, size_t rows, size_t columns);
+void save_zcolumns(int plain, int shifted, MKL_Complex16 *slab, MKL_Complex16 *T, size_t rows, size_t width, size_t first,
+                   size_t count, size_t column_shift);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "common.h"
+#include "plan.h"
+#include "utils.h"
+#include "fourier.h"
+#include "writer.h"
+
+// Products of one run, saved as ../bin/<dir>/<name>.bin
+typedef enum
+{
+    OPSD_SPECTRUM = 1 << 0,
+    OPSD_SMOOTH = 1 << 1,
+    OPSD_PERIODIC = 1 << 2,
+    OPSD_SPECTRUM_SHIFTED = 1 << 3,
+    OPSD_SMOOTH_SHIFTED = 1 << 4,
+    OPSD_PERIODIC_SHIFTED = 1 << 5,
+    OPSD_FILTERED = 1 << 6
+} opsd_product;
+
+#define OPSD_PLAIN_PRODUCTS (OPSD_SPECTRUM | OPSD_SMOOTH | OPSD_PERIODIC | OPSD_FILTERED)
+#define OPSD_SHIFTED_PRODUCTS (OPSD_SPECTRUM_SHIFTED | OPSD_SMOOTH_SHIFTED | OPSD_PERIODIC_SHIFTED)
+
+// One image and everything requested from it. The forward FFT and the edge
+// spectra are computed once; every product is derived from shared buffers.
+typedef struct
+{
+    size_t rows, columns;
+    opsd_domain domain;
+    opsd_layout layout;
+    unsigned products; // opsd_product mask
+    int save;          // write the products, otherwise only compute them
+    const char *input; // "rb" reads ../bin/<dir>/data.bin, "fm" fills the matrix
+    const char *dir;
+    int seed;
+    int mmap;          // --mmap: data.bin and the products are mapped instead of read/written
+    opsd_writer *writer; // background writer for the products, NULL writes them in place
+    size_t count;        // images processed together, sharing the batched FFTs
+    const char **dirs;   // directory of each image, NULL: every image uses dir
+} opsd_job;
+
+// Full-size buffers of run_*images besides I_t: the centered spectrum W, the
+// smooth component S and the real copy of the complex filtered image. They
+// belong to the owner of I_t, which keeps them from one image or batch group
+// to the next; init_*workspace sizes them for job->count images and leaves
+// the ones the job does not need NULL. modulated tells the loaders of I_t to
+// apply the sign that centers a single even spectrum in place.
+typedef struct
+{
+    void *W, *S;    // MKL_Complex8 / MKL_Complex16
+    void *filtered; // float / double
+    int modulated;
+} opsd_workspace;
+
+unsigned parse_routines(const char *routines, opsd_domain *domain);
+void run_cpipeline(const opsd_job *job);
+void run_zpipeline(const opsd_job *job);
+void init_cworkspace(const opsd_job *job, opsd_workspace *workspace);
+void init_zworkspace(const opsd_job *job, opsd_workspace *workspace);
+void free_cworkspace(opsd_workspace *workspace);
+void free_zworkspace(opsd_workspace *workspace);
+void run_cimages(const opsd_job *job, MKL_Complex8 *I_t, opsd_workspace *workspace);
+void run_zimages(const opsd_job *job, MKL_Complex16 *I_t, opsd_workspace *workspace);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef PLAN_H
+#define PLAN_H
+
+#include "common.h"
+#include "alloc.h"
+
+typedef enum
+{
+    OPSD_SINGLE,
+    OPSD_DOUBLE
+} opsd_precision;
+
+// OPSD_REAL plans run R2C/C2R transforms on padded real images: each row holds
+// 2 * (columns / 2 + 1) reals and its spectrum keeps only the columns / 2 + 1
+// non-redundant columns (CCE storage).
+typedef enum
+{
+    OPSD_COMPLEX,
+    OPSD_REAL
+} opsd_domain;
+
+typedef enum
+{
+    OPSD_FORWARD,
+    OPSD_BACKWARD
+} opsd_direction;
+
+// Memory order of the rows x columns matrices handed to the stages: row-major
+// images (j + i * columns) or column-major traces (i + j * rows). Plans are
+// keyed by the row-major shape, so a column-major rows x columns problem
+// shares the plan of the row-major columns x rows one. For real input the
+// CCE storage halves the contiguous dimension: columns in row-major, rows in
+// column-major.
+typedef enum
+{
+    OPSD_ROW_MAJOR,
+    OPSD_COLUMN_MAJOR
+} opsd_layout;
+
+// Scratch arena of a plan: the per-call temporaries of the stages and of the
+// pipeline are carved from one block, as a stack. A request the block cannot
+// hold spills to a separate buffer; when everything is released the block
+// grows to the largest depth reached, so from the second image of a shape on
+// the temporaries never touch the heap.
+typedef struct
+{
+    char *data;
+    size_t capacity, top, peak; // bytes
+    void *spilled;              // buffers above capacity, newest first
+} opsd_scratch;
+
+// Everything that depends only on the shape of the problem: committed DFTI
+// descriptors and the per-shape tables of Steps C and D. Plans are created on
+// first use, cached for the whole process and released by destroy_plans().
+// Batch plans (count > 1) only hold fft2d, run over count images stored one
+// after another.
+typedef struct opsd_plan
+{
+    opsd_precision precision;
+    opsd_domain domain;
+    size_t rows, columns;
+    opsd_direction direction;
+    size_t count;
+
+    DFTI_DESCRIPTOR_HANDLE fft2d;       // 2D transform (Step A / inverse)
+    DFTI_DESCRIPTOR_HANDLE fft_columns; // all columns, stride columns (complex forward only)
+    DFTI_DESCRIPTOR_HANDLE fft_rows;    // all rows, distance columns (complex forward only)
+    DFTI_DESCRIPTOR_HANDLE fft_column;  // column 0 of the border (complex forward only)
+    DFTI_DESCRIPTOR_HANDLE fft_edge_row;    // contiguous row edge, columns points (forward only)
+    DFTI_DESCRIPTOR_HANDLE fft_edge_column; // contiguous column edge, rows points (forward only)
+
+    void *v_rows;        // Step C: 1 - W_M^-k, rows elements (MKL_Complex8 / MKL_Complex16)
+    void *v_columns;     // Step C: 1 - W_N^-l, columns elements
+    void *denom_rows;    // Step D: -4sin²(PI*i/rows), rows elements (float / double)
+    void *denom_columns; // Step D: -4sin²(PI*j/columns), columns elements
+    opsd_scratch scratch;
+
+    struct opsd_plan *next;
+} opsd_plan;
+
+opsd_plan *get_plan(opsd_precision precision, opsd_domain domain, size_t rows, size_t columns, opsd_direction direction);
+opsd_plan *get_batch_plan(opsd_precision precision, opsd_domain domain, size_t rows, size_t columns, opsd_direction direction,
+                          size_t count);
+void destroy_plans(void);
+
+// Temporaries from the plan's scratch, 64-byte aligned. The stages run one at a
+// time on the plan, so no lock is taken: scratch_release(plan, mark) gives back
+// everything taken since scratch_mark, in stack order.
+void *scratch_alloc(opsd_plan *plan, size_t bytes);
+size_t scratch_mark(const opsd_plan *plan);
+void scratch_release(opsd_plan *plan, size_t mark);
+DFTI_DESCRIPTOR_HANDLE create_slab_fft(opsd_precision precision, opsd_domain domain, size_t length, size_t count,
+                                       opsd_direction direction);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include "pipeline.h"
+#include "profile.h"
+
+// One line of the CSV written by bench --csv: the median time of a compute
+// stage on one shape, precision, domain, layout and thread count
+typedef struct
+{
+    opsd_stage stage;
+    opsd_precision precision;
+    opsd_domain domain;
+    opsd_layout layout;
+    size_t rows, columns;
+    int threads;
+    double median; // seconds
+} opsd_calibration;
+
+// Machine profile: every measure of a benchmark run
+typedef struct
+{
+    opsd_calibration *entries;
+    size_t count;
+} opsd_machine;
+
+// Cost of a job before running it. The peak mirrors the buffers the pipeline
+// allocates (the tracked heap of --profile, with every writer snapshot still
+// queued), not MKL's DFTI workspace. Stage times are scaled from the nearest
+// calibrated shape by the FLOPs (FFTs) or bytes (pointwise stages) of
+// profile_model; -1 when the machine profile has no measure of the stage.
+typedef struct
+{
+    size_t peak;          // bytes
+    double read, written; // bytes of data.bin and of the products
+    size_t calls[OPSD_STAGE_LOAD];
+    double time[OPSD_STAGE_LOAD]; // seconds per compute stage
+    double total;                 // seconds, -1 when a stage is not calibrated
+} opsd_estimate;
+
+void machine_load(opsd_machine *machine, const char *filename);
+void machine_free(opsd_machine *machine);
+double machine_stage_time(const opsd_machine *machine, opsd_stage stage, opsd_precision precision, opsd_domain domain,
+                          opsd_layout layout, size_t rows, size_t columns, int threads);
+void estimate_job(const opsd_job *job, opsd_precision precision, const opsd_machine *machine, opsd_estimate *estimate);
+
+// --dry-run: prints the estimate of the job and of its variants (r routines,
+// --mmap, plain and centered products in separate runs) and recommends the
+// fastest one whose peak fits in budget bytes. machine may be NULL.
+void run_dry_run(const opsd_job *job, opsd_precision precision, const char *machine_file, double budget);
+
+#endif
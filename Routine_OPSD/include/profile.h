@@ -0,0 +1,193 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "common.h"
+#include "plan.h"
+#include "alloc.h"
+#include <pthread.h>
+#ifdef OPSD_ITT
+#include <ittnotify.h>
+#endif
+
+// Stages recorded by the library: the compute stages follow the Steps of the
+// routine, load and save cover data.bin and the products.
+typedef enum
+{
+    OPSD_STAGE_A_FFT2D,
+    OPSD_STAGE_B_BORDER,
+    OPSD_STAGE_B_EDGES,
+    OPSD_STAGE_C_FFT_BORDER,
+    OPSD_STAGE_D_SMOOTH,
+    OPSD_STAGE_E_PERIODIC,
+    OPSD_STAGE_CDE_FUSED,
+    OPSD_STAGE_A_FFT2D_SHIFTED,
+    OPSD_STAGE_CDE_FUSED_SHIFTED,
+    OPSD_STAGE_FFTSHIFT,
+    OPSD_STAGE_IFFT2D,
+    OPSD_STAGE_LOAD,
+    OPSD_STAGE_SAVE,
+    OPSD_STAGE_COUNT
+} opsd_stage;
+
+// Hardware counters read around the compute stages
+typedef enum
+{
+    OPSD_COUNTER_CYCLES,
+    OPSD_COUNTER_INSTRUCTIONS,
+    OPSD_COUNTER_LLC_MISSES,
+    OPSD_COUNTER_DTLB_MISSES,
+    OPSD_COUNTER_NODE_LOADS,  // loads served by memory, any node
+    OPSD_COUNTER_NODE_MISSES, // of those, the ones served by another node
+    OPSD_COUNTER_COUNT
+} opsd_counter;
+
+typedef struct
+{
+    size_t calls;
+    double time; // wall seconds
+    double bytes_read, bytes_written;
+    double flops;
+    int threads; // most threads a call ran with
+    double counters[OPSD_COUNTER_COUNT];
+    size_t memory_live; // tracked bytes live when the last call returned
+    size_t memory_peak; // most tracked bytes live during a call
+} opsd_stage_stats;
+
+// Bits of opsd_profiling
+#define OPSD_PROFILE_STATS 1    // per-stage table printed at exit
+#define OPSD_PROFILE_TRACE 2    // timeline of stages, DFTI calls and OpenMP chunks
+#define OPSD_PROFILE_COUNTERS 4 // perf_event_open counters per compute stage
+
+// Set at load time from OPSD_PROFILE (anything but "0"), OPSD_TRACE (the trace
+// file) and OPSD_COUNTERS, or by profile_enable(), trace_enable() and
+// counters_enable(). While it is 0 every probe is one load and a branch.
+extern int opsd_profiling;
+
+void profile_enable(void);
+void trace_enable(const char *path);
+int counters_enable(void);
+int counter_available(opsd_counter counter);
+void profile_stage_begin(void);
+void profile_stage_end(opsd_stage stage);
+void trace_event(const char *name, const char *category, double start, double end);
+const char *profile_stage_name(opsd_stage stage);
+void profile_model(opsd_stage stage, opsd_precision precision, opsd_domain domain, size_t rows, size_t columns,
+                   double *read, double *written, double *flops);
+void profile_add(opsd_stage stage, double seconds, double read, double written, double flops, int threads);
+void profile_stats(opsd_stage stage, opsd_stage_stats *stats);
+void profile_reset(void);
+void profile_report(FILE *file);
+
+#ifdef OPSD_ITT
+// ITT domain "OPSD" and one task name per stage, created at load time. With
+// no collector attached every ITT call returns after a flag test.
+extern __itt_domain *opsd_itt_domain;
+extern __itt_string_handle *opsd_itt_stages[OPSD_STAGE_COUNT];
+#endif
+
+// VTune tasks: every stage, load and save becomes a task of the OPSD domain
+static inline void profile_task_begin(opsd_stage stage)
+{
+#ifdef OPSD_ITT
+    __itt_task_begin(opsd_itt_domain, __itt_null, __itt_null, opsd_itt_stages[stage]);
+#else
+    (void)stage;
+#endif
+}
+
+static inline void profile_task_end(void)
+{
+#ifdef OPSD_ITT
+    __itt_task_end(opsd_itt_domain);
+#endif
+}
+
+// VTune frames: one image (or batch group, or stream frame, or server job)
+static inline void profile_frame_begin(void)
+{
+#ifdef OPSD_ITT
+    __itt_frame_begin_v3(opsd_itt_domain, NULL);
+#endif
+}
+
+static inline void profile_frame_end(void)
+{
+#ifdef OPSD_ITT
+    __itt_frame_end_v3(opsd_itt_domain, NULL);
+#endif
+}
+
+// Every profile_begin is closed by a profile_end or profile_end_io on the same
+// thread, so that the ITT tasks nest
+static inline double profile_begin(opsd_stage stage)
+{
+    profile_task_begin(stage);
+    if (!opsd_profiling)
+        return 0.0;
+
+    if (stage < OPSD_STAGE_LOAD)
+        profile_stage_begin();
+    return omp_get_wtime();
+}
+
+// count images of the row-major rows x columns shape went through the stage
+static inline void profile_end(opsd_stage stage, double start, opsd_precision precision, opsd_domain domain,
+                               size_t rows, size_t columns, size_t count)
+{
+    profile_task_end();
+    if (opsd_profiling)
+    {
+        profile_stage_end(stage);
+
+        double read, written, flops;
+        profile_model(stage, precision, domain, rows, columns, &read, &written, &flops);
+        double end = omp_get_wtime();
+        profile_add(stage, end - start, count * read, count * written, count * flops, omp_get_max_threads());
+        if (opsd_profiling & OPSD_PROFILE_TRACE)
+            trace_event(profile_stage_name(stage), "stage", start, end);
+    }
+}
+
+static inline void profile_end_io(opsd_stage stage, double start, double read, double written)
+{
+    profile_task_end();
+    if (opsd_profiling)
+    {
+        double end = omp_get_wtime();
+        profile_add(stage, end - start, read, written, 0.0, 1);
+        if (opsd_profiling & OPSD_PROFILE_TRACE)
+            trace_event(profile_stage_name(stage), "io", start, end);
+    }
+}
+
+static inline double trace_begin(void)
+{
+    return opsd_profiling & OPSD_PROFILE_TRACE ? omp_get_wtime() : 0.0;
+}
+
+// Closes a span opened by trace_begin on the calling thread, e.g. the chunk of
+// a worksharing loop one OpenMP thread ran before waiting at the barrier
+static inline void trace_end(const char *name, const char *category, double start)
+{
+    if (opsd_profiling & OPSD_PROFILE_TRACE)
+        trace_event(name, category, start, omp_get_wtime());
+}
+
+// In-place DFTI calls, each one a span named after its descriptor
+static inline MKL_LONG trace_forward(DFTI_DESCRIPTOR_HANDLE descriptor, void *data, const char *name)
+{
+    double start = trace_begin();
+    MKL_LONG status = DftiComputeForward(descriptor, data);
+    trace_end(name, "dfti", start);
+    return status;
+}
+
+static inline MKL_LONG trace_backward(DFTI_DESCRIPTOR_HANDLE descriptor, void *data, const char *name)
+{
+    double start = trace_begin();
+    MKL_LONG status = DftiComputeBackward(descriptor, data);
+    trace_end(name, "dfti", start);
+    return status;
+}
+
+#endif
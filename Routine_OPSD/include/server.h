@@ -0,0 +1,33 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "stream.h"
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Daemon mode: the server keeps the plans and the edge buffers of the last
+// shape warm between jobs. A job is one frame, as in stream mode: the client
+// places it in a memfd laid out as raw | I_t | W and passes the descriptor
+// with the request, the product is computed inside that memory and only the
+// request and its reply cross the socket.
+typedef struct
+{
+    uint64_t rows, columns;
+    uint32_t domain, layout, products;
+    uint32_t precision; // 0: single, 1: double
+} opsd_request;
+
+typedef struct
+{
+    int32_t status;         // 0, or -1 for a malformed job or a short memfd
+    uint64_t offset, bytes; // product inside the memfd
+    double compute_time;    // seconds the server spent on the job
+} opsd_reply;
+
+int run_server(const char *path);
+int run_client(const opsd_job *job, int precision, const char *path);
+
+#endif
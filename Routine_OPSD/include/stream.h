@@ -0,0 +1,23 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "pipeline.h"
+#include <pthread.h>
+
+// Stream mode: raw rows x columns frames (float / double, in the job layout)
+// arrive on stdin and one product per frame leaves on stdout: data_filtered
+// for ccr, periodic for cts and periodic_shifted for css (CCE spectra for the
+// r routines). Frame k + 1 is read while frame k is computed and frame k - 1
+// is written, over three buffers allocated once with the plans.
+void run_cstream(const opsd_job *job);
+void run_zstream(const opsd_job *job);
+
+// One frame: elements of I_t and of W (0 when the centered spectrum is made in
+// place), the name of its product and the product itself, computed from raw
+// and returned in raw, I_t or W
+void frame_sizes(const opsd_job *job, size_t *spectral_size, size_t *centered_size);
+const char *frame_product(const opsd_job *job);
+void *compute_cframe(const opsd_job *job, float *raw, MKL_Complex8 *I_t, MKL_Complex8 *W, MKL_Complex8 *R, MKL_Complex8 *C);
+void *compute_zframe(const opsd_job *job, double *raw, MKL_Complex16 *I_t, MKL_Complex16 *W, MKL_Complex16 *R, MKL_Complex16 *C);
+
+#endif
@@ -2,8 +2,9 @@
 #define UTIL_H
 
 #include "common.h"
+#include "alloc.h"
 
-int check_args(const char *BIN, const char *ROUTINE, const char *PRECISION, const char *SAVE_VECTORS, const char *INPUT);
+int check_args(const char *BIN, const char *PRECISION, const char *SAVE_VECTORS, const char *INPUT);
 void ensure_directory_exists(const char *path);
 
 void init_cvector(MKL_Complex8 **vector, size_t size);
@@ -28,14 +29,34 @@ void init_fvector(float **vector, size_t size);
 void free_fvector(float *vector);
 void read_fvector_bin(const char *filename, float *vector, size_t size);
 void save_fvector_on_bin(const char *filename, float *vector, size_t size);
+void fill_fmatrix(float *matrix, size_t rows, size_t columns, unsigned int seed);
+void pad_fvector_rows(float *vector, size_t rows, size_t columns);
+void compact_fvector_rows(float *vector, size_t rows, size_t columns);
+void pad_fvector_rows_from(float *vector, const float *source, size_t rows, size_t columns);
+void pad_fvector_rows_modulated(float *vector, size_t rows, size_t columns);
+void pad_fvector_rows_from_modulated(float *vector, const float *source, size_t rows, size_t columns);
+void compact_fvector_rows_to(float *target, const float *vector, size_t rows, size_t columns);
 void copy_fvector_to_cvector(MKL_Complex8 *cvector, float *fvector, size_t size);
+void copy_fvector_to_cvector_modulated(MKL_Complex8 *cvector, const float *fvector, size_t rows, size_t columns);
 void copy_fvector_to_zvector(MKL_Complex16 *zvector, float *fvector, size_t size);
 
 void init_dvector(double **vector, size_t size);
 void free_dvector(double *vector);
 void read_dvector_bin(const char *filename, double *vector, size_t size);
 void save_dvector_on_bin(const char *filename, double *vector, size_t size);
+void fill_dmatrix(double *matrix, size_t rows, size_t columns, unsigned int seed);
+void pad_dvector_rows(double *vector, size_t rows, size_t columns);
+void compact_dvector_rows(double *vector, size_t rows, size_t columns);
+void pad_dvector_rows_from(double *vector, const double *source, size_t rows, size_t columns);
+void pad_dvector_rows_modulated(double *vector, size_t rows, size_t columns);
+void pad_dvector_rows_from_modulated(double *vector, const double *source, size_t rows, size_t columns);
+void compact_dvector_rows_to(double *target, const double *vector, size_t rows, size_t columns);
 void copy_dvector_to_cvector(MKL_Complex8 *cvector, double *dvector, size_t size);
 void copy_dvector_to_zvector(MKL_Complex16 *zvector, double *dvector, size_t size);
+void copy_dvector_to_zvector_modulated(MKL_Complex16 *zvector, const double *dvector, size_t rows, size_t columns);
+
+void *map_input_file(const char *filename, size_t bytes);
+void *map_output_file(const char *filename, size_t bytes);
+void unmap_file(void *map, size_t bytes);
 
 #endif
\ No newline at end of file
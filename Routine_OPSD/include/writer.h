@@ -0,0 +1,52 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include "common.h"
+#include "profile.h"
+#include <pthread.h>
+
+// Queued writes beyond which writer_submit blocks, bounding the snapshot memory
+#define OPSD_WRITER_DEPTH 8
+
+// writer_submit flags
+#define OPSD_WRITE_SNAPSHOT 1 // the caller keeps modifying the buffer: copy it now
+
+typedef struct opsd_write opsd_write;
+
+// One queued product, tracked until written, then kept as a spare with its
+// snapshot buffer for a later product of the same size
+struct opsd_write
+{
+    char filename[1024];
+    void *data;
+    size_t bytes;
+    void *snapshot;  // copy of data owned by the entry, capacity bytes
+    size_t capacity;
+    opsd_write *next;
+};
+
+// Output queue drained by one thread, so the pipeline keeps computing while
+// its products reach the disk. Buffers submitted without OPSD_WRITE_SNAPSHOT
+// are borrowed and must stay untouched until writer_drain.
+typedef struct
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t queued, written;
+    opsd_write *head, *tail;
+    size_t pending;
+    opsd_write *spare; // written entries, at most OPSD_WRITER_DEPTH
+    size_t spares;
+    int stop;
+
+    size_t bytes;
+    double write_time; // seconds spent writing and syncing, in the background
+    double wait_time;  // seconds the pipeline spent blocked on the queue
+} opsd_writer;
+
+void writer_start(opsd_writer *writer);
+void writer_submit(opsd_writer *writer, const char *filename, void *data, size_t bytes, int flags);
+void writer_drain(opsd_writer *writer);
+void writer_stop(opsd_writer *writer);
+
+#endif
@@ -0,0 +1,815 @@
+// OPSD distribuído com MPI: cada processo guarda uma faixa de linhas da imagem
+// e, depois da transposição global, uma faixa de colunas do espectro. A FFT 2D
+// vira FFTs das linhas na faixa de linhas, um MPI_Alltoallv e FFTs das colunas
+// na faixa de colunas. O espectro da borda só depende da primeira e da última
+// linha e coluna: as diferenças das bordas (rows + columns elementos) são
+// somadas com um MPI_Allreduce e cada processo calcula as FFTs das bordas e as
+// etapas C-E nas suas colunas. Os produtos são escritos por todos os processos,
+// cada um nas suas colunas dos arquivos; o data_filtered faz o caminho inverso.
+//
+// --scaling repete o cálculo (sem leitura nem escrita) em 1, 2, 4, ... e todos
+// os processos e informa tempo, speedup e eficiência de escalabilidade forte.
+//
+// make mpi NP=4 ARGS="8192 8192 ccr,css single yes rb example 0 --scaling"
+
+#include <mpi.h>
+#include <limits.h>
+#include "../include/utils.h"
+#include "../include/fourier.h"
+#include "../include/pipeline.h"
+#include "../include/outofcore.h"
+
+#define MPI_REPEAT 3
+
+// Fases medidas em cada processo; o relatório mostra o maior tempo entre eles.
+// As inversas do data_filtered contam nas fases das FFTs e das transposições.
+typedef enum
+{
+    PHASE_LOAD,
+    PHASE_ROWS,
+    PHASE_TRANSPOSE,
+    PHASE_EDGES,
+    PHASE_COLUMNS,
+    PHASE_SAVE,
+    PHASE_COUNT
+} mpi_phase;
+
+static const char *phase_names[] = {"load", "row FFTs", "transposes", "edges", "column FFTs + C-E", "save"};
+
+// Faixas de um processo: linhas [row_first, row_first + row_count) da imagem
+// rows x columns e colunas [column_first, column_first + column_count) do
+// espectro rows x width (width = columns / 2 + 1 no domínio real). As
+// contagens do MPI_Alltoallv são as da transposição direta, em elementos
+// complexos; a inversa troca envio e recebimento.
+typedef struct
+{
+    MPI_Comm comm;
+    int rank, ranks;
+    size_t rows, columns, width;
+    size_t row_first, row_count, column_first, column_count;
+    int *send_counts, *send_displs, *recv_counts, *recv_displs;
+    DFTI_DESCRIPTOR_HANDLE fft_rows, ifft_rows, fft_columns;
+    double phases[PHASE_COUNT];
+} mpi_slabs;
+
+// Primeiro elemento do bloco do processo rank com length elementos divididos
+// entre ranks processos; os length % ranks primeiros levam um a mais
+static size_t block_first(size_t length, int ranks, int rank)
+{
+    size_t extra = length % ranks;
+    return (size_t)rank * (length / ranks) + ((size_t)rank < extra ? (size_t)rank : extra);
+}
+
+static size_t block_count(size_t length, int ranks, int rank)
+{
+    return block_first(length, ranks, rank + 1) - block_first(length, ranks, rank);
+}
+
+static double phase_begin(void)
+{
+    return MPI_Wtime();
+}
+
+static void phase_end(mpi_slabs *slabs, mpi_phase phase, double start)
+{
+    slabs->phases[phase] += MPI_Wtime() - start;
+}
+
+// Divide o job entre os processos de comm e cria os descritores das faixas.
+// Retorna -1 (sem criar nada) quando algum processo ficaria sem linhas ou
+// colunas, ou quando as contagens não cabem no int do MPI_Alltoallv.
+static int init_slabs(mpi_slabs *slabs, const opsd_job *job, opsd_precision precision, MPI_Comm comm)
+{
+    memset(slabs, 0, sizeof(*slabs));
+    slabs->comm = comm;
+    MPI_Comm_rank(comm, &slabs->rank);
+    MPI_Comm_size(comm, &slabs->ranks);
+
+    // Column-major data.bin é a imagem row-major transposta, como no --out-of-core
+    slabs->rows = job->layout == OPSD_ROW_MAJOR ? job->rows : job->columns;
+    slabs->columns = job->layout == OPSD_ROW_MAJOR ? job->columns : job->rows;
+    slabs->width = job->domain == OPSD_REAL ? slabs->columns / 2 + 1 : slabs->columns;
+
+    size_t rows = slabs->rows, width = slabs->width;
+    int ranks = slabs->ranks, rank = slabs->rank;
+    if (rows < (size_t)ranks || width < (size_t)ranks || block_count(rows, ranks, 0) * width > INT_MAX ||
+        block_count(width, ranks, 0) * rows > INT_MAX)
+        return -1;
+
+    slabs->row_first = block_first(rows, ranks, rank);
+    slabs->row_count = block_count(rows, ranks, rank);
+    slabs->column_first = block_first(width, ranks, rank);
+    slabs->column_count = block_count(width, ranks, rank);
+
+    slabs->send_counts = malloc(4 * ranks * sizeof(int));
+    if (slabs->send_counts == NULL)
+    {
+        printf("Allocation error!\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    slabs->send_displs = slabs->send_counts + ranks;
+    slabs->recv_counts = slabs->send_counts + 2 * ranks;
+    slabs->recv_displs = slabs->send_counts + 3 * ranks;
+
+    // Para o processo q vão as colunas dele das minhas linhas; de r vêm as
+    // minhas colunas das linhas dele
+    for (int q = 0, send = 0, recv = 0; q < ranks; q++)
+    {
+        slabs->send_counts[q] = slabs->row_count * block_count(width, ranks, q);
+        slabs->recv_counts[q] = block_count(rows, ranks, q) * slabs->column_count;
+        slabs->send_displs[q] = send;
+        slabs->recv_displs[q] = recv;
+        send += slabs->send_counts[q];
+        recv += slabs->recv_counts[q];
+    }
+
+    slabs->fft_rows = create_slab_fft(precision, job->domain, slabs->columns, slabs->row_count, OPSD_FORWARD);
+    if (job->products & OPSD_FILTERED)
+        slabs->ifft_rows = create_slab_fft(precision, job->domain, slabs->columns, slabs->row_count, OPSD_BACKWARD);
+    slabs->fft_columns = create_slab_fft(precision, OPSD_COMPLEX, rows, slabs->column_count, OPSD_FORWARD);
+    return 0;
+}
+
+static void free_slabs(mpi_slabs *slabs)
+{
+    DftiFreeDescriptor(&slabs->fft_rows);
+    if (slabs->ifft_rows != NULL)
+        DftiFreeDescriptor(&slabs->ifft_rows);
+    DftiFreeDescriptor(&slabs->fft_columns);
+    free(slabs->send_counts);
+}
+
+// Tamanho em elementos complexos dos dois buffers de trabalho: cada um recebe
+// tanto a faixa de linhas quanto a de colunas
+static size_t slab_size(const mpi_slabs *slabs)
+{
+    size_t row_slab = slabs->row_count * slabs->width, column_slab = slabs->column_count * slabs->rows;
+    return row_slab > column_slab ? row_slab : column_slab;
+}
+
+// Os processos fora de um teste de escalabilidade esperam dormindo, para não
+// disputar os núcleos com o MPI_Barrier em espera ativa
+static void idle_barrier(MPI_Comm comm)
+{
+    MPI_Request request;
+    int done = 0;
+    MPI_Ibarrier(comm, &request);
+    while (MPI_Test(&request, &done, MPI_STATUS_IGNORE) == MPI_SUCCESS && !done)
+        usleep(1000);
+}
+
+static int compare_times(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+//CVECTOR SLABS
+
+// Mesma sequência e posições de fill_fmatrix, guardando só os floats
+// [first, first + count) do data.bin gerado
+static void fill_fslab(float *raw, const opsd_job *job, size_t first, size_t count)
+{
+    srand(job->seed);
+    for (size_t i = 0; i < job->rows; i++)
+    {
+        for (size_t j = 0; j < job->columns; j++)
+        {
+            float value = (float)rand() / RAND_MAX_F * 4 + 1;
+            size_t offset = i + j * job->rows;
+            if (offset >= first && offset < first + count)
+                raw[offset - first] = value;
+        }
+    }
+}
+
+static void load_cslab(const opsd_job *job, mpi_slabs *slabs, float *raw)
+{
+    double start = phase_begin();
+    size_t columns = slabs->columns;
+
+    if (!strcmp(job->input, "rb"))
+    {
+        char filepath[1024];
+        snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", job->dir);
+        int input = open(filepath, O_RDONLY);
+        if (input < 0) {
+            perror("Error opening file");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        transfer_block(input, raw, 1, slabs->row_count * columns, sizeof(float), 1, slabs->rows * columns,
+                       slabs->row_first * columns, 0, 0, 0);
+        close(input);
+    }
+    else
+    {
+        fill_fslab(raw, job, slabs->row_first * columns, slabs->row_count * columns);
+    }
+    phase_end(slabs, PHASE_LOAD, start);
+}
+
+// Transposição global entre a faixa de linhas (row_count x width, em A) e a
+// faixa de colunas guardada transposta (column_count x rows, em B), o formato
+// de compute_cperiodic_component_P_fused_columns. A direta leva A para B e a
+// inversa B para A; o outro buffer serve de envio ou recebimento.
+static void transpose_cslabs(mpi_slabs *slabs, MKL_Complex8 *A, MKL_Complex8 *B, int inverse)
+{
+    double start = phase_begin();
+    MKL_Complex8 one = {1.0f, 0.0f};
+    size_t rows = slabs->rows, width = slabs->width, row_count = slabs->row_count, column_count = slabs->column_count;
+    int ranks = slabs->ranks;
+
+    if (!inverse)
+    {
+        for (int q = 0; q < ranks; q++)
+            mkl_comatcopy('R', 'T', row_count, block_count(width, ranks, q), one, A + block_first(width, ranks, q), width,
+                          B + slabs->send_displs[q], row_count);
+        MPI_Alltoallv(B, slabs->send_counts, slabs->send_displs, MPI_C_FLOAT_COMPLEX, A, slabs->recv_counts,
+                      slabs->recv_displs, MPI_C_FLOAT_COMPLEX, slabs->comm);
+        for (int r = 0; r < ranks; r++)
+            mkl_comatcopy('R', 'N', column_count, block_count(rows, ranks, r), one, A + slabs->recv_displs[r],
+                          block_count(rows, ranks, r), B + block_first(rows, ranks, r), rows);
+    }
+    else
+    {
+        for (int r = 0; r < ranks; r++)
+            mkl_comatcopy('R', 'N', column_count, block_count(rows, ranks, r), one, B + block_first(rows, ranks, r), rows,
+                          A + slabs->recv_displs[r], block_count(rows, ranks, r));
+        MPI_Alltoallv(A, slabs->recv_counts, slabs->recv_displs, MPI_C_FLOAT_COMPLEX, B, slabs->send_counts,
+                      slabs->send_displs, MPI_C_FLOAT_COMPLEX, slabs->comm);
+        for (int q = 0; q < ranks; q++)
+            mkl_comatcopy('R', 'T', block_count(width, ranks, q), row_count, one, B + slabs->send_displs[q], row_count,
+                          A + block_first(width, ranks, q), width);
+    }
+    phase_end(slabs, PHASE_TRANSPOSE, start);
+}
+
+// Todas as etapas a partir da faixa de linhas em raw, que não é alterada.
+// outputs traz os arquivos dos produtos, -1 para os que não são escritos.
+static void run_cslabs(const opsd_job *job, mpi_slabs *slabs, const float *raw, int *outputs)
+{
+    size_t rows = slabs->rows, columns = slabs->columns, width = slabs->width;
+    size_t row_first = slabs->row_first, row_count = slabs->row_count;
+    size_t column_first = slabs->column_first, column_count = slabs->column_count;
+    size_t column_shift = job->domain == OPSD_REAL ? 0 : columns / 2;
+    int smooth = outputs[1] >= 0 || outputs[4] >= 0;
+    MKL_Complex8 *A = NULL, *B = NULL, *S = NULL, *R = NULL, *C = NULL;
+    init_cvector(&A, slab_size(slabs));
+    init_cvector(&B, slab_size(slabs));
+    init_cvector(&R, columns);
+    init_cvector(&C, rows);
+    if (smooth)
+        init_cvector(&S, column_count * rows);
+
+    // Bordas: cada processo contribui com as suas linhas, o resto fica em zero
+    double start = phase_begin();
+    memset(R, 0, columns * sizeof(MKL_Complex8));
+    memset(C, 0, rows * sizeof(MKL_Complex8));
+    gather_cedges(raw, R, C, row_first, row_count, rows, columns);
+    MPI_Allreduce(MPI_IN_PLACE, R, columns, MPI_C_FLOAT_COMPLEX, MPI_SUM, slabs->comm);
+    MPI_Allreduce(MPI_IN_PLACE, C, rows, MPI_C_FLOAT_COMPLEX, MPI_SUM, slabs->comm);
+    compute_cedge_spectra(R, C, rows, columns, job->domain);
+    phase_end(slabs, PHASE_EDGES, start);
+
+    start = phase_begin();
+    if (job->domain == OPSD_REAL)
+        pad_fvector_rows_from((float *)A, raw, row_count, columns);
+    else
+        copy_fvector_to_cvector(A, (float *)raw, row_count * columns);
+    trace_forward(slabs->fft_rows, A, "fft_slab_rows");
+    phase_end(slabs, PHASE_ROWS, start);
+
+    transpose_cslabs(slabs, A, B, 0);
+
+    start = phase_begin();
+    trace_forward(slabs->fft_columns, B, "fft_slab_columns");
+    phase_end(slabs, PHASE_COLUMNS, start);
+
+    start = phase_begin();
+    save_ccolumns(outputs[0], outputs[3], B, A, rows, width, column_first, column_count, column_shift);
+    phase_end(slabs, PHASE_SAVE, start);
+
+    start = phase_begin();
+    compute_cperiodic_component_P_fused_columns(B, R, C, S, rows, columns, column_first, column_count, job->domain);
+    phase_end(slabs, PHASE_COLUMNS, start);
+
+    start = phase_begin();
+    if (S != NULL)
+        save_ccolumns(outputs[1], outputs[4], S, A, rows, width, column_first, column_count, column_shift);
+    save_ccolumns(outputs[2], outputs[5], B, A, rows, width, column_first, column_count, column_shift);
+    phase_end(slabs, PHASE_SAVE, start);
+
+    if (job->products & OPSD_FILTERED)
+    {
+        start = phase_begin();
+        trace_backward(slabs->fft_columns, B, "fft_slab_columns");
+        phase_end(slabs, PHASE_COLUMNS, start);
+
+        transpose_cslabs(slabs, A, B, 1);
+
+        // A faixa de linhas filtrada volta para B, que já não é usado
+        start = phase_begin();
+        float *filtered = (float *)B;
+        trace_backward(slabs->ifft_rows, A, "fft_slab_rows");
+        if (job->domain == OPSD_REAL)
+            compact_fvector_rows_to(filtered, (float *)A, row_count, columns);
+        else
+            copy_cvector_to_real_fvector(A, filtered, row_count * columns);
+        phase_end(slabs, PHASE_ROWS, start);
+
+        start = phase_begin();
+        if (outputs[6] >= 0)
+            transfer_block(outputs[6], filtered, 1, row_count * columns, sizeof(float), 1, rows * columns, row_first * columns,
+                           0, 0, 1);
+        phase_end(slabs, PHASE_SAVE, start);
+    }
+
+    if (S != NULL)
+        free_cvector(S);
+    free_cvector(C);
+    free_cvector(R);
+    free_cvector(B);
+    free_cvector(A);
+}
+
+// Execução completa em MPI_COMM_WORLD: leitura, cálculo e escrita dos produtos,
+// com o tempo de cada fase no processo 0
+static int run_cmpi(const opsd_job *job)
+{
+    mpi_slabs slabs;
+    if (init_slabs(&slabs, job, OPSD_SINGLE, MPI_COMM_WORLD))
+    {
+        if (slabs.rank == 0)
+            printf("Cannot split %zu x %zu among %d ranks\n", slabs.rows, slabs.width, slabs.ranks);
+        return -6;
+    }
+
+    float *raw = NULL;
+    init_fvector(&raw, slabs.row_count * slabs.columns);
+
+    // O processo 0 cria os arquivos com o tamanho final, os demais só os abrem
+    int outputs[7];
+    unsigned products = job->save ? job->products : 0;
+    for (int create = 1; create >= 0; create--)
+    {
+        if ((slabs.rank == 0) == create)
+        {
+            for (int p = 0; p < 7; p++)
+            {
+                size_t bytes = p == 6 ? slabs.rows * slabs.columns * sizeof(float) : slabs.rows * slabs.width * sizeof(MKL_Complex8);
+                outputs[p] = products & (1u << p) ? open_product(job, p, bytes, create) : -1;
+            }
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    double start = MPI_Wtime();
+    load_cslab(job, &slabs, raw);
+    run_cslabs(job, &slabs, raw, outputs);
+    double begin = phase_begin();
+    close_products(outputs);
+    phase_end(&slabs, PHASE_SAVE, begin);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double elapsed = MPI_Wtime() - start, phases[PHASE_COUNT];
+
+    MPI_Reduce(slabs.phases, phases, PHASE_COUNT, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (slabs.rank == 0)
+    {
+        printf("MPI: %d ranks x %d threads, %zu-row and %zu-column slabs of %zu x %zu, %.3f s\n", slabs.ranks,
+               omp_get_max_threads(), block_count(slabs.rows, slabs.ranks, 0), block_count(slabs.width, slabs.ranks, 0),
+               slabs.rows, slabs.width, elapsed);
+        for (int p = 0; p < PHASE_COUNT; p++)
+            printf("  %-18s %9.3f s\n", phase_names[p], phases[p]);
+    }
+
+    free_fvector(raw);
+    free_slabs(&slabs);
+    return 0;
+}
+
+// Mediana de repeat execuções do cálculo nos processos de comm, com os dados
+// já carregados e sem escrita; a primeira cria os planos e fica fora da medida.
+// transposes recebe a mediana do tempo das transposições; -1 quando o job não
+// pode ser dividido entre esses processos.
+static double time_cmpi(const opsd_job *job, MPI_Comm comm, int repeat, double *transposes)
+{
+    mpi_slabs slabs;
+    *transposes = -1.0;
+    if (init_slabs(&slabs, job, OPSD_SINGLE, comm))
+        return -1.0;
+
+    float *raw = NULL;
+    init_fvector(&raw, slabs.row_count * slabs.columns);
+    load_cslab(job, &slabs, raw);
+
+    int outputs[7] = {-1, -1, -1, -1, -1, -1, -1};
+    double *times = malloc(2 * repeat * sizeof(double)), result;
+    if (times == NULL)
+    {
+        printf("Allocation error!\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (int r = -1; r < repeat; r++)
+    {
+        slabs.phases[PHASE_TRANSPOSE] = 0.0;
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        run_cslabs(job, &slabs, raw, outputs);
+        double elapsed[2] = {MPI_Wtime() - start, slabs.phases[PHASE_TRANSPOSE]};
+        MPI_Allreduce(MPI_IN_PLACE, elapsed, 2, MPI_DOUBLE, MPI_MAX, comm);
+        if (r >= 0)
+        {
+            times[r] = elapsed[0];
+            times[repeat + r] = elapsed[1];
+        }
+    }
+
+    qsort(times, repeat, sizeof(double), compare_times);
+    qsort(times + repeat, repeat, sizeof(double), compare_times);
+    result = times[repeat / 2];
+    *transposes = times[repeat + repeat / 2];
+
+    free(times);
+    free_fvector(raw);
+    free_slabs(&slabs);
+    return result;
+}
+
+//ZVECTOR SLABS
+
+static void fill_dslab(double *raw, const opsd_job *job, size_t first, size_t count)
+{
+    srand(job->seed);
+    for (size_t i = 0; i < job->rows; i++)
+    {
+        for (size_t j = 0; j < job->columns; j++)
+        {
+            double value = (double)rand() / RAND_MAX_D * 4 + 1;
+            size_t offset = i + j * job->rows;
+            if (offset >= first && offset < first + count)
+                raw[offset - first] = value;
+        }
+    }
+}
+
+static void load_zslab(const opsd_job *job, mpi_slabs *slabs, double *raw)
+{
+    double start = phase_begin();
+    size_t columns = slabs->columns;
+
+    if (!strcmp(job->input, "rb"))
+    {
+        char filepath[1024];
+        snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", job->dir);
+        int input = open(filepath, O_RDONLY);
+        if (input < 0) {
+            perror("Error opening file");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        transfer_block(input, raw, 1, slabs->row_count * columns, sizeof(double), 1, slabs->rows * columns,
+                       slabs->row_first * columns, 0, 0, 0);
+        close(input);
+    }
+    else
+    {
+        fill_dslab(raw, job, slabs->row_first * columns, slabs->row_count * columns);
+    }
+    phase_end(slabs, PHASE_LOAD, start);
+}
+
+static void transpose_zslabs(mpi_slabs *slabs, MKL_Complex16 *A, MKL_Complex16 *B, int inverse)
+{
+    double start = phase_begin();
+    MKL_Complex16 one = {1.0, 0.0};
+    size_t rows = slabs->rows, width = slabs->width, row_count = slabs->row_count, column_count = slabs->column_count;
+    int ranks = slabs->ranks;
+
+    if (!inverse)
+    {
+        for (int q = 0; q < ranks; q++)
+            mkl_zomatcopy('R', 'T', row_count, block_count(width, ranks, q), one, A + block_first(width, ranks, q), width,
+                          B + slabs->send_displs[q], row_count);
+        MPI_Alltoallv(B, slabs->send_counts, slabs->send_displs, MPI_C_DOUBLE_COMPLEX, A, slabs->recv_counts,
+                      slabs->recv_displs, MPI_C_DOUBLE_COMPLEX, slabs->comm);
+        for (int r = 0; r < ranks; r++)
+            mkl_zomatcopy('R', 'N', column_count, block_count(rows, ranks, r), one, A + slabs->recv_displs[r],
+                          block_count(rows, ranks, r), B + block_first(rows, ranks, r), rows);
+    }
+    else
+    {
+        for (int r = 0; r < ranks; r++)
+            mkl_zomatcopy('R', 'N', column_count, block_count(rows, ranks, r), one, B + block_first(rows, ranks, r), rows,
+                          A + slabs->recv_displs[r], block_count(rows, ranks, r));
+        MPI_Alltoallv(A, slabs->recv_counts, slabs->recv_displs, MPI_C_DOUBLE_COMPLEX, B, slabs->send_counts,
+                      slabs->send_displs, MPI_C_DOUBLE_COMPLEX, slabs->comm);
+        for (int q = 0; q < ranks; q++)
+            mkl_zomatcopy('R', 'T', block_count(width, ranks, q), row_count, one, B + slabs->send_displs[q], row_count,
+                          A + block_first(width, ranks, q), width);
+    }
+    phase_end(slabs, PHASE_TRANSPOSE, start);
+}
+
+static void run_zslabs(const opsd_job *job, mpi_slabs *slabs, const double *raw, int *outputs)
+{
+    size_t rows = slabs->rows, columns = slabs->columns, width = slabs->width;
+    size_t row_first = slabs->row_first, row_count = slabs->row_count;
+    size_t column_first = slabs->column_first, column_count = slabs->column_count;
+    size_t column_shift = job->domain == OPSD_REAL ? 0 : columns / 2;
+    int smooth = outputs[1] >= 0 || outputs[4] >= 0;
+    MKL_Complex16 *A = NULL, *B = NULL, *S = NULL, *R = NULL, *C = NULL;
+    init_zvector(&A, slab_size(slabs));
+    init_zvector(&B, slab_size(slabs));
+    init_zvector(&R, columns);
+    init_zvector(&C, rows);
+    if (smooth)
+        init_zvector(&S, column_count * rows);
+
+    double start = phase_begin();
+    memset(R, 0, columns * sizeof(MKL_Complex16));
+    memset(C, 0, rows * sizeof(MKL_Complex16));
+    gather_zedges(raw, R, C, row_first, row_count, rows, columns);
+    MPI_Allreduce(MPI_IN_PLACE, R, columns, MPI_C_DOUBLE_COMPLEX, MPI_SUM, slabs->comm);
+    MPI_Allreduce(MPI_IN_PLACE, C, rows, MPI_C_DOUBLE_COMPLEX, MPI_SUM, slabs->comm);
+    compute_zedge_spectra(R, C, rows, columns, job->domain);
+    phase_end(slabs, PHASE_EDGES, start);
+
+    start = phase_begin();
+    if (job->domain == OPSD_REAL)
+        pad_dvector_rows_from((double *)A, raw, row_count, columns);
+    else
+        copy_dvector_to_zvector(A, (double *)raw, row_count * columns);
+    trace_forward(slabs->fft_rows, A, "fft_slab_rows");
+    phase_end(slabs, PHASE_ROWS, start);
+
+    transpose_zslabs(slabs, A, B, 0);
+
+    start = phase_begin();
+    trace_forward(slabs->fft_columns, B, "fft_slab_columns");
+    phase_end(slabs, PHASE_COLUMNS, start);
+
+    start = phase_begin();
+    save_zcolumns(outputs[0], outputs[3], B, A, rows, width, column_first, column_count, column_shift);
+    phase_end(slabs, PHASE_SAVE, start);
+
+    start = phase_begin();
+    compute_zperiodic_component_P_fused_columns(B, R, C, S, rows, columns, column_first, column_count, job->domain);
+    phase_end(slabs, PHASE_COLUMNS, start);
+
+    start = phase_begin();
+    if (S != NULL)
+        save_zcolumns(outputs[1], outputs[4], S, A, rows, width, column_first, column_count, column_shift);
+    save_zcolumns(outputs[2], outputs[5], B, A, rows, width, column_first, column_count, column_shift);
+    phase_end(slabs, PHASE_SAVE, start);
+
+    if (job->products & OPSD_FILTERED)
+    {
+        start = phase_begin();
+        trace_backward(slabs->fft_columns, B, "fft_slab_columns");
+        phase_end(slabs, PHASE_COLUMNS, start);
+
+        transpose_zslabs(slabs, A, B, 1);
+
+        start = phase_begin();
+        double *filtered = (double *)B;
+        trace_backward(slabs->ifft_rows, A, "fft_slab_rows");
+        if (job->domain == OPSD_REAL)
+            compact_dvector_rows_to(filtered, (double *)A, row_count, columns);
+        else
+            copy_zvector_to_real_dvector(A, filtered, row_count * columns);
+        phase_end(slabs, PHASE_ROWS, start);
+
+        start = phase_begin();
+        if (outputs[6] >= 0)
+            transfer_block(outputs[6], filtered, 1, row_count * columns, sizeof(double), 1, rows * columns, row_first * columns,
+                           0, 0, 1);
+        phase_end(slabs, PHASE_SAVE, start);
+    }
+
+    if (S != NULL)
+        free_zvector(S);
+    free_zvector(C);
+    free_zvector(R);
+    free_zvector(B);
+    free_zvector(A);
+}
+
+static int run_zmpi(const opsd_job *job)
+{
+    mpi_slabs slabs;
+    if (init_slabs(&slabs, job, OPSD_DOUBLE, MPI_COMM_WORLD))
+    {
+        if (slabs.rank == 0)
+            printf("Cannot split %zu x %zu among %d ranks\n", slabs.rows, slabs.width, slabs.ranks);
+        return -6;
+    }
+
+    double *raw = NULL;
+    init_dvector(&raw, slabs.row_count * slabs.columns);
+
+    int outputs[7];
+    unsigned products = job->save ? job->products : 0;
+    for (int create = 1; create >= 0; create--)
+    {
+        if ((slabs.rank == 0) == create)
+        {
+            for (int p = 0; p < 7; p++)
+            {
+                size_t bytes = p == 6 ? slabs.rows * slabs.columns * sizeof(double) : slabs.rows * slabs.width * sizeof(MKL_Complex16);
+                outputs[p] = products & (1u << p) ? open_product(job, p, bytes, create) : -1;
+            }
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    double start = MPI_Wtime();
+    load_zslab(job, &slabs, raw);
+    run_zslabs(job, &slabs, raw, outputs);
+    double begin = phase_begin();
+    close_products(outputs);
+    phase_end(&slabs, PHASE_SAVE, begin);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double elapsed = MPI_Wtime() - start, phases[PHASE_COUNT];
+
+    MPI_Reduce(slabs.phases, phases, PHASE_COUNT, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (slabs.rank == 0)
+    {
+        printf("MPI: %d ranks x %d threads, %zu-row and %zu-column slabs of %zu x %zu, %.3f s\n", slabs.ranks,
+               omp_get_max_threads(), block_count(slabs.rows, slabs.ranks, 0), block_count(slabs.width, slabs.ranks, 0),
+               slabs.rows, slabs.width, elapsed);
+        for (int p = 0; p < PHASE_COUNT; p++)
+            printf("  %-18s %9.3f s\n", phase_names[p], phases[p]);
+    }
+
+    free_dvector(raw);
+    free_slabs(&slabs);
+    return 0;
+}
+
+static double time_zmpi(const opsd_job *job, MPI_Comm comm, int repeat, double *transposes)
+{
+    mpi_slabs slabs;
+    *transposes = -1.0;
+    if (init_slabs(&slabs, job, OPSD_DOUBLE, comm))
+        return -1.0;
+
+    double *raw = NULL;
+    init_dvector(&raw, slabs.row_count * slabs.columns);
+    load_zslab(job, &slabs, raw);
+
+    int outputs[7] = {-1, -1, -1, -1, -1, -1, -1};
+    double *times = malloc(2 * repeat * sizeof(double)), result;
+    if (times == NULL)
+    {
+        printf("Allocation error!\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (int r = -1; r < repeat; r++)
+    {
+        slabs.phases[PHASE_TRANSPOSE] = 0.0;
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        run_zslabs(job, &slabs, raw, outputs);
+        double elapsed[2] = {MPI_Wtime() - start, slabs.phases[PHASE_TRANSPOSE]};
+        MPI_Allreduce(MPI_IN_PLACE, elapsed, 2, MPI_DOUBLE, MPI_MAX, comm);
+        if (r >= 0)
+        {
+            times[r] = elapsed[0];
+            times[repeat + r] = elapsed[1];
+        }
+    }
+
+    qsort(times, repeat, sizeof(double), compare_times);
+    qsort(times + repeat, repeat, sizeof(double), compare_times);
+    result = times[repeat / 2];
+    *transposes = times[repeat + repeat / 2];
+
+    free(times);
+    free_dvector(raw);
+    free_slabs(&slabs);
+    return result;
+}
+
+static void usage(const char *bin)
+{
+    printf("Use: mpirun -np <ranks> %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed> [layout] [--scaling] [--repeat <n>]\n", bin);
+    printf("Options: <routine> as in bin/out, <precision> 'single' or 'double', <save_vectors> 'yes' or 'no', <input> 'rb' or 'fm', [layout] 'row' or 'column'\n");
+}
+
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc, &argv);
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    if (argc < 9)
+    {
+        if (rank == 0)
+            usage(argv[0]);
+        MPI_Finalize();
+        return -1;
+    }
+
+    size_t rows = atoi(argv[1]), columns = atoi(argv[2]);
+    const char *ROUTINE = argv[3], *PRECISION = argv[4], *SAVE_VECTORS = argv[5], *INPUT = argv[6], *DIR = argv[7];
+    int seed = atoi(argv[8]);
+
+    // --scaling mede o cálculo em 1, 2, 4, ... processos; --repeat dá o número
+    // de execuções de cada medida (mediana)
+    opsd_layout layout = OPSD_ROW_MAJOR;
+    int scaling = 0, repeat = MPI_REPEAT, err_code = 0;
+    for (int i = 9; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--scaling"))
+            scaling = 1;
+        else if (!strcmp(argv[i], "--repeat") && i + 1 < argc)
+            repeat = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "column"))
+            layout = OPSD_COLUMN_MAJOR;
+        else if (strcmp(argv[i], "row"))
+            err_code = -2;
+    }
+
+    // Mesmas opções e códigos de erro do bin/out
+    opsd_job job = {rows, columns, OPSD_COMPLEX, layout, 0, !strcmp(SAVE_VECTORS, "yes"), INPUT, DIR, seed, 0, NULL, 1, NULL};
+    job.products = parse_routines(ROUTINE, &job.domain);
+    if (!job.products || repeat < 1)
+        err_code = -2;
+    else if (strcmp(PRECISION, "single") && strcmp(PRECISION, "double"))
+        err_code = -3;
+    else if (strcmp(SAVE_VECTORS, "yes") && strcmp(SAVE_VECTORS, "no"))
+        err_code = -4;
+    else if (strcmp(INPUT, "rb") && strcmp(INPUT, "fm"))
+        err_code = -5;
+    if (err_code)
+    {
+        if (rank == 0)
+            usage(argv[0]);
+        MPI_Finalize();
+        return err_code;
+    }
+
+    // Na mesma máquina, cada processo fica com a sua parte dos núcleos, a não
+    // ser que OMP_NUM_THREADS diga outra coisa; com a política NUMA ligada, a
+    // parte é um bloco de núcleos na ordem dos nós, e não só uma contagem
+    MPI_Comm local;
+    int local_rank, local_ranks;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &local);
+    MPI_Comm_rank(local, &local_rank);
+    MPI_Comm_size(local, &local_ranks);
+    MPI_Comm_free(&local);
+    numa_bind_share(local_rank, local_ranks);
+    if (getenv("OMP_NUM_THREADS") == NULL)
+    {
+        int threads = omp_get_num_procs() / local_ranks > 0 ? omp_get_num_procs() / local_ranks : 1;
+        omp_set_num_threads(threads);
+        mkl_set_num_threads(threads);
+    }
+
+    if (rank == 0 && job.save)
+    {
+        char filepath[1024];
+        snprintf(filepath, sizeof(filepath), "../bin/%s", DIR);
+        ensure_directory_exists(filepath);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    int precision = strcmp(PRECISION, "single") != 0;
+    err_code = precision ? run_zmpi(&job) : run_cmpi(&job);
+
+    if (scaling && !err_code)
+    {
+        if (rank == 0)
+            printf("%-6s %7s %11s %8s %10s %15s\n", "ranks", "threads", "median (s)", "speedup", "efficiency", "transposes (s)");
+
+        double base = 0.0;
+        for (int count = 1; count <= ranks; count = count < ranks && 2 * count > ranks ? ranks : 2 * count)
+        {
+            MPI_Comm comm;
+            MPI_Comm_split(MPI_COMM_WORLD, rank < count ? 0 : MPI_UNDEFINED, rank, &comm);
+            if (comm != MPI_COMM_NULL)
+            {
+                double transposes = -1.0, median = precision ? time_zmpi(&job, comm, repeat, &transposes)
+                                                      : time_cmpi(&job, comm, repeat, &transposes);
+                if (rank == 0 && median < 0.0)
+                    printf("%-6d cannot split the job among %d ranks\n", count, count);
+                else if (rank == 0)
+                {
+                    base = count == 1 ? median : base;
+                    printf("%-6d %7d %11.6f %8.2f %10.2f %15.6f\n", count, omp_get_max_threads(), median, base / median,
+                           base / median / count, transposes);
+                }
+                MPI_Comm_free(&comm);
+            }
+            idle_barrier(MPI_COMM_WORLD);
+            if (count == ranks)
+                break;
+        }
+    }
+
+    destroy_plans();
+    MPI_Finalize();
+    return err_code;
+}
@@ -0,0 +1,307 @@
+#include "../include/alloc.h"
+
+// Windows open at the same time: nested stages plus the I/O threads
+#define OPSD_MEMORY_WINDOWS 64
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+// One cache line in front of the caller's data, so the data keeps the
+// alignment of the block. pages is -1 for posix_memalign blocks, otherwise
+// the opsd_pages of a mapping of length bytes.
+typedef struct
+{
+    size_t bytes;
+    size_t length;
+    int pages;
+} __attribute__((aligned(OPSD_ALIGNMENT))) alloc_header;
+
+static size_t memory_live = 0, memory_peak = 0, memory_allocations = 0;
+static size_t memory_paged[OPSD_PAGES_COUNT];
+static size_t window_peaks[OPSD_MEMORY_WINDOWS];
+static uint64_t windows_open = 0;
+static opsd_pages page_policy = OPSD_PAGES_THP;
+static int pages_warned[OPSD_PAGES_COUNT];
+static pthread_mutex_t memory_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *page_names[OPSD_PAGES_COUNT] = {"4k", "thp", "2m", "1g"};
+
+const char *memory_pages_name(opsd_pages pages)
+{
+    return (int)pages >= 0 && pages < OPSD_PAGES_COUNT ? page_names[pages] : "?";
+}
+
+int memory_parse_pages(const char *name, opsd_pages *pages)
+{
+    for (int i = 0; i < OPSD_PAGES_COUNT; i++)
+    {
+        if (!strcmp(name, page_names[i]))
+        {
+            *pages = (opsd_pages)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+__attribute__((constructor)) static void pages_from_environment(void)
+{
+    const char *value = getenv("OPSD_PAGES");
+    if (value != NULL && value[0] != '\0' && !memory_parse_pages(value, &page_policy))
+        fprintf(stderr, "OPSD_PAGES must be 4k, thp, 2m or 1g, not %s\n", value);
+}
+
+void memory_set_pages(opsd_pages pages)
+{
+    page_policy = pages;
+}
+
+opsd_pages memory_pages(void)
+{
+    return page_policy;
+}
+
+static void count_bytes(size_t added, size_t removed)
+{
+    pthread_mutex_lock(&memory_lock);
+    memory_live = memory_live + added - removed;
+    if (added)
+        memory_allocations++;
+    if (memory_live > memory_peak)
+        memory_peak = memory_live;
+
+    for (uint64_t open = windows_open; open; open &= open - 1)
+    {
+        int window = __builtin_ctzll(open);
+        if (memory_live > window_peaks[window])
+            window_peaks[window] = memory_live;
+    }
+    pthread_mutex_unlock(&memory_lock);
+}
+
+static size_t page_bytes(opsd_pages pages)
+{
+    switch (pages)
+    {
+    case OPSD_PAGES_1G:
+        return (size_t)1 << 30;
+    case OPSD_PAGES_2M:
+    case OPSD_PAGES_THP:
+        return (size_t)2 << 20;
+    default:
+        return sysconf(_SC_PAGESIZE);
+    }
+}
+
+// Explicit pages are reserved by mmap itself, so a short pool shows up here and
+// not as a SIGBUS at the first touch
+static void *map_pages(size_t bytes, opsd_pages *pages, size_t *length)
+{
+    for (opsd_pages kind = *pages; kind >= OPSD_PAGES_2M; kind--)
+    {
+        size_t size = page_bytes(kind);
+        int huge = (kind == OPSD_PAGES_1G ? 30 : 21) << MAP_HUGE_SHIFT;
+        *length = (bytes + size - 1) / size * size;
+        void *data = mmap(NULL, *length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | huge, -1, 0);
+        if (data != MAP_FAILED)
+        {
+            *pages = kind;
+            return data;
+        }
+        if (!__atomic_exchange_n(&pages_warned[kind], 1, __ATOMIC_RELAXED))
+            fprintf(stderr, "Not enough free %s huge pages (vm.nr_hugepages), falling back to smaller pages\n",
+                    page_names[kind]);
+    }
+
+    // Over-allocated by one huge page and trimmed, so that THP can back every
+    // whole 2M of the buffer
+    size_t align = page_bytes(OPSD_PAGES_THP), page = page_bytes(OPSD_PAGES_4K);
+    *length = (bytes + page - 1) / page * page;
+    char *block = mmap(NULL, *length + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED)
+        return NULL;
+
+    char *data = (char *)(((uintptr_t)block + align - 1) / align * align);
+    if (data > block)
+        munmap(block, data - block);
+    if (block + align > data)
+        munmap(data + *length, block + align - data);
+
+    // 4k asks for small pages even when THP is set to "always"
+    int thp = *pages != OPSD_PAGES_4K;
+    if (madvise(data, *length, thp ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) && thp &&
+        !__atomic_exchange_n(&pages_warned[OPSD_PAGES_THP], 1, __ATOMIC_RELAXED))
+        fprintf(stderr, "Transparent huge pages unavailable, falling back to 4k pages\n");
+    *pages = thp ? OPSD_PAGES_THP : OPSD_PAGES_4K;
+    return data;
+}
+
+void *opsd_malloc(size_t bytes)
+{
+    if (bytes > SIZE_MAX - OPSD_LARGE_BYTES)
+        return NULL;
+
+    alloc_header *header;
+    if (bytes >= OPSD_LARGE_BYTES)
+    {
+        opsd_pages pages = page_policy;
+        size_t length;
+        header = map_pages(sizeof(alloc_header) + bytes, &pages, &length);
+        if (header == NULL)
+            return NULL;
+
+        // hugetlb pages are reserved by mmap, one write places each of them;
+        // a THP range may still fault in 4k pages, so every 4k page is touched
+        if (opsd_numa)
+            numa_touch(header, length, pages >= OPSD_PAGES_2M ? page_bytes(pages) : page_bytes(OPSD_PAGES_4K));
+        header->length = length;
+        header->pages = pages;
+    }
+    else
+    {
+        void *block;
+        if (posix_memalign(&block, OPSD_ALIGNMENT, sizeof(alloc_header) + bytes))
+            return NULL;
+        header = block;
+        header->length = 0;
+        header->pages = -1;
+    }
+
+    header->bytes = bytes;
+    count_bytes(bytes, 0);
+    return header + 1;
+}
+
+void *opsd_calloc(size_t count, size_t bytes)
+{
+    if (bytes && count > SIZE_MAX / bytes)
+        return NULL;
+
+    // Mapped pages are already zero
+    void *pointer = opsd_malloc(count * bytes);
+    if (pointer != NULL && ((alloc_header *)pointer - 1)->pages < 0)
+        memset(pointer, 0, count * bytes);
+    return pointer;
+}
+
+// Always a new block: realloc would give back malloc's 16-byte alignment
+void *opsd_realloc(void *pointer, size_t bytes)
+{
+    if (pointer == NULL)
+        return opsd_malloc(bytes);
+
+    size_t old_bytes = ((alloc_header *)pointer - 1)->bytes;
+    void *moved = opsd_malloc(bytes);
+    if (moved == NULL)
+        return NULL;
+    memcpy(moved, pointer, old_bytes < bytes ? old_bytes : bytes);
+    opsd_free(pointer);
+    return moved;
+}
+
+// Bytes of a THP range the kernel really backed with huge pages: madvise
+// succeeds whether or not any fault gets one. Read from the AnonHugePages of
+// the range's mapping in /proc/self/smaps, pro rata when the kernel merged the
+// range with a neighbouring mapping.
+static size_t huge_backed(const void *data, size_t length)
+{
+    FILE *file = fopen("/proc/self/smaps", "r");
+    if (file == NULL)
+        return 0;
+
+    char line[256];
+    unsigned long first, last, start = 0, end = 0;
+    size_t kilobytes, huge = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (sscanf(line, "%lx-%lx ", &first, &last) == 2)
+        {
+            if (first <= (uintptr_t)data && (uintptr_t)data < last)
+            {
+                start = first;
+                end = last;
+            }
+            else if (end)
+                break;
+        }
+        else if (end && sscanf(line, "AnonHugePages: %zu kB", &kilobytes) == 1)
+            huge = kilobytes * 1024;
+    }
+    fclose(file);
+
+    if (end - start > length)
+        huge = (size_t)((double)huge * length / (end - start));
+    return huge < length ? huge : length;
+}
+
+void opsd_free(void *pointer)
+{
+    if (pointer == NULL)
+        return;
+
+    alloc_header *header = (alloc_header *)pointer - 1;
+    count_bytes(0, header->bytes);
+    if (header->pages < 0)
+    {
+        free(header);
+        return;
+    }
+
+    numa_sample(pointer, header->bytes);
+
+    size_t huge = header->pages == OPSD_PAGES_THP ? huge_backed(header, header->length) : 0;
+    size_t backed = huge < header->bytes ? huge : header->bytes;
+    pthread_mutex_lock(&memory_lock);
+    if (header->pages == OPSD_PAGES_THP)
+    {
+        memory_paged[OPSD_PAGES_THP] += backed;
+        memory_paged[OPSD_PAGES_4K] += header->bytes - backed;
+    }
+    else
+        memory_paged[header->pages] += header->bytes;
+    pthread_mutex_unlock(&memory_lock);
+
+    munmap(header, header->length);
+}
+
+void memory_stats(opsd_memory *memory)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    pthread_mutex_lock(&memory_lock);
+    memory->live = memory_live;
+    memory->peak = memory_peak;
+    memory->allocations = memory_allocations;
+    memcpy(memory->paged, memory_paged, sizeof(memory_paged));
+    pthread_mutex_unlock(&memory_lock);
+    memory->peak_rss = (size_t)usage.ru_maxrss * 1024;
+}
+
+int memory_window_open(void)
+{
+    int window = -1;
+
+    pthread_mutex_lock(&memory_lock);
+    if (~windows_open)
+    {
+        window = __builtin_ctzll(~windows_open);
+        windows_open |= (uint64_t)1 << window;
+        window_peaks[window] = memory_live;
+    }
+    pthread_mutex_unlock(&memory_lock);
+    return window;
+}
+
+size_t memory_window_close(int window)
+{
+    if (window < 0 || window >= OPSD_MEMORY_WINDOWS)
+        return 0;
+
+    pthread_mutex_lock(&memory_lock);
+    size_t peak = window_peaks[window];
+    windows_open &= ~((uint64_t)1 << window);
+    pthread_mutex_unlock(&memory_lock);
+    return peak;
+}
@@ -0,0 +1,399 @@
+#include "../include/batch.h"
+
+// One image of the batch: the directory of its products and, inside a stack,
+// where its data starts
+typedef struct
+{
+    char dir[1024];
+    off_t offset;
+} batch_image;
+
+// Reads a group of raw images on its own thread
+typedef struct
+{
+    pthread_t thread;
+    const char *stack; // NULL: every image reads ../bin/<dir>/data.bin
+    const batch_image *images;
+    size_t count, bytes;
+    void *raw;
+} batch_read;
+
+// snprintf into a path buffer, exiting rather than truncating: two images
+// whose directories were cut to the same prefix would share their products
+static void format_path(char *path, size_t length, const char *format, ...)
+{
+    va_list arguments;
+    va_start(arguments, format);
+    int written = vsnprintf(path, length, format, arguments);
+    va_end(arguments);
+
+    if (written < 0 || (size_t)written >= length)
+    {
+        printf("Path too long: %s...\n", path);
+        exit(1);
+    }
+}
+
+// Every image of a batch has the shape of the job: a data.bin of another size
+// would be read in part, or past its end
+static void check_image(const char *data, off_t size, size_t bytes)
+{
+    if ((size_t)size != bytes)
+    {
+        printf("%s has %lld bytes, expected %zu for the batch shape\n", data, (long long)size, bytes);
+        exit(1);
+    }
+}
+
+static void add_image(batch_image **images, size_t *count, size_t *capacity, const char *dir, off_t offset)
+{
+    if (*count == *capacity)
+    {
+        *capacity = *capacity ? 2 * *capacity : 256;
+        *images = opsd_realloc(*images, *capacity * sizeof(batch_image));
+        if (*images == NULL)
+        {
+            printf("Allocation error!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    format_path((*images)[*count].dir, sizeof((*images)[*count].dir), "%s", dir);
+    (*images)[*count].offset = offset;
+    (*count)++;
+}
+
+// Sources inside ../bin:
+//  - a directory: every subdirectory holding a data.bin, in name order;
+//  - a .txt file: one image directory per line;
+//  - any other file: a stack of images, image k saving its products in
+//    <stack name without extension>/<k>.
+// Sets *stack to the path of a stack source, NULL otherwise.
+static batch_image *list_images(const opsd_job *job, size_t bytes, size_t *count, char *stack, size_t length)
+{
+    batch_image *images = NULL;
+    size_t capacity = 0;
+    *count = 0;
+    stack[0] = '\0';
+
+    char path[1024];
+    format_path(path, sizeof(path), "../bin/%s", job->dir);
+
+    struct stat st;
+    if (stat(path, &st) == -1)
+    {
+        perror("Error opening batch source");
+        exit(1);
+    }
+
+    if (S_ISDIR(st.st_mode))
+    {
+        struct dirent **entries = NULL;
+        int n = scandir(path, &entries, NULL, alphasort);
+        for (int k = 0; k < n; k++)
+        {
+            char dir[1024], data[1024];
+            format_path(dir, sizeof(dir), "%s/%s", job->dir, entries[k]->d_name);
+            format_path(data, sizeof(data), "../bin/%s/data.bin", dir);
+            if (entries[k]->d_name[0] != '.' && stat(data, &st) == 0 && S_ISREG(st.st_mode))
+            {
+                check_image(data, st.st_size, bytes);
+                add_image(&images, count, &capacity, dir, 0);
+            }
+            free(entries[k]);
+        }
+        free(entries);
+        return images;
+    }
+
+    const char *extension = strrchr(job->dir, '.');
+    if (extension != NULL && !strcmp(extension, ".txt"))
+    {
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL)
+        {
+            perror("Error opening file");
+            exit(1);
+        }
+
+        char line[1024];
+        while (fgets(line, sizeof(line), fp) != NULL)
+        {
+            if (strchr(line, '\n') == NULL && !feof(fp))
+            {
+                printf("Path too long: %s...\n", line);
+                exit(1);
+            }
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] == '\0')
+                continue;
+
+            char data[1024];
+            format_path(data, sizeof(data), "../bin/%s/data.bin", line);
+            if (stat(data, &st) == -1)
+            {
+                perror(data);
+                exit(1);
+            }
+            check_image(data, st.st_size, bytes);
+            add_image(&images, count, &capacity, line, 0);
+        }
+        fclose(fp);
+        return images;
+    }
+
+    if ((size_t)st.st_size % bytes != 0)
+    {
+        printf("%s has %lld bytes, not a whole number of %zu-byte images\n", path, (long long)st.st_size, bytes);
+        exit(1);
+    }
+
+    char stem[1024], dir[1024];
+    size_t stem_length = extension != NULL && strchr(extension, '/') == NULL ? (size_t)(extension - job->dir) : strlen(job->dir);
+    format_path(stem, sizeof(stem), "%.*s%s", (int)stem_length, job->dir, stem_length == strlen(job->dir) ? ".out" : "");
+    format_path(stack, length, "%s", path);
+
+    format_path(dir, sizeof(dir), "../bin/%s", stem);
+    ensure_directory_exists(dir);
+
+    for (size_t k = 0; k < (size_t)st.st_size / bytes; k++)
+    {
+        format_path(dir, sizeof(dir), "%s/%zu", stem, k);
+        add_image(&images, count, &capacity, dir, (off_t)(k * bytes));
+
+        char filepath[1024];
+        format_path(filepath, sizeof(filepath), "../bin/%s", dir);
+        ensure_directory_exists(filepath);
+    }
+    return images;
+}
+
+static void *read_images(void *arg)
+{
+    batch_read *reader = arg;
+
+    for (size_t b = 0; b < reader->count; b++)
+    {
+        double start = profile_begin(OPSD_STAGE_LOAD);
+        char filepath[1024];
+        if (reader->stack != NULL)
+            snprintf(filepath, sizeof(filepath), "%s", reader->stack);
+        else
+            format_path(filepath, sizeof(filepath), "../bin/%s/data.bin", reader->images[b].dir);
+
+        FILE *fp = fopen(filepath, "rb");
+        if (fp == NULL) {
+            perror("Error opening file");
+            exit(1);
+        }
+
+        if (fseeko(fp, reader->images[b].offset, SEEK_SET) != 0 ||
+            fread((char *)reader->raw + b * reader->bytes, 1, reader->bytes, fp) != reader->bytes) {
+            fprintf(stderr, "Error: unexpected end of file\n");
+            fclose(fp);
+            exit(1);
+        }
+
+        fclose(fp);
+        profile_end_io(OPSD_STAGE_LOAD, start, reader->bytes, 0.0);
+    }
+
+    return NULL;
+}
+
+static void start_read(batch_read *reader, const char *stack, const batch_image *images, size_t count, size_t bytes, void *raw)
+{
+    reader->stack = stack;
+    reader->images = images;
+    reader->count = count;
+    reader->bytes = bytes;
+    reader->raw = raw;
+
+    if (pthread_create(&reader->thread, NULL, read_images, reader)) {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static size_t batch_group(size_t spectral_bytes, size_t total)
+{
+    size_t group = OPSD_BATCH_BYTES / spectral_bytes;
+    if (group > OPSD_BATCH_IMAGES)
+        group = OPSD_BATCH_IMAGES;
+    if (group > total)
+        group = total;
+    return group > 0 ? group : 1;
+}
+
+static void report(const opsd_job *job, size_t total, size_t group, double elapsed)
+{
+    printf("Batch: %zu images of %zu x %zu in %.3f s, %.1f images/s (%zu per batched FFT)\n",
+           total, job->rows, job->columns, elapsed, total / elapsed, group);
+}
+
+//CVECTOR BATCH
+
+void run_cbatch(const opsd_job *job)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns;
+    size_t lines = job->layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    size_t spectral_size = job->domain == OPSD_REAL ? lines * (length / 2 + 1) : size;
+
+    char stack[1024];
+    size_t total = 0;
+    batch_image *images = list_images(job, size * sizeof(float), &total, stack, sizeof(stack));
+    if (total == 0)
+    {
+        printf("No images found in ../bin/%s\n", job->dir);
+        opsd_free(images);
+        return;
+    }
+
+    size_t group = batch_group(spectral_size * sizeof(MKL_Complex8), total);
+
+    // Group g is converted from raw[g % 2] while group g + 1 is read into the other
+    MKL_Complex8 *I_t = NULL;
+    float *raw[2] = {NULL, NULL};
+    const char **dirs = opsd_malloc(group * sizeof(char *));
+    if (dirs == NULL)
+    {
+        printf("Allocation error!\n");
+        exit(EXIT_FAILURE);
+    }
+    init_cvector(&I_t, group * spectral_size);
+    init_fvector(&raw[0], group * size);
+    init_fvector(&raw[1], group * size);
+
+    opsd_job group_job = *job;
+    opsd_workspace workspace;
+    group_job.dirs = dirs;
+    group_job.count = group;
+    init_cworkspace(&group_job, &workspace);
+
+    double start = omp_get_wtime();
+
+    batch_read reader;
+    start_read(&reader, stack[0] ? stack : NULL, images, group, size * sizeof(float), raw[0]);
+
+    for (size_t first = 0, g = 0; first < total; first += group, g++)
+    {
+        size_t count = total - first < group ? total - first : group;
+        pthread_join(reader.thread, NULL);
+
+        size_t next = first + count;
+        if (next < total)
+            start_read(&reader, reader.stack, images + next, total - next < group ? total - next : group, size * sizeof(float), raw[(g + 1) % 2]);
+
+        for (size_t b = 0; b < count; b++)
+        {
+            float *image = raw[g % 2] + b * size;
+            if (job->domain == OPSD_REAL && workspace.modulated)
+                pad_fvector_rows_from_modulated((float *)(I_t + b * spectral_size), image, lines, length);
+            else if (job->domain == OPSD_REAL)
+                pad_fvector_rows_from((float *)(I_t + b * spectral_size), image, lines, length);
+            else if (workspace.modulated)
+                copy_fvector_to_cvector_modulated(I_t + b * spectral_size, image, lines, length);
+            else
+                copy_fvector_to_cvector(I_t + b * spectral_size, image, size);
+            dirs[b] = images[first + b].dir;
+        }
+
+        // One VTune frame per group: its images share every DFTI call
+        group_job.count = count;
+        profile_frame_begin();
+        run_cimages(&group_job, I_t, &workspace);
+        profile_frame_end();
+    }
+
+    report(job, total, group, omp_get_wtime() - start);
+
+    free_cworkspace(&workspace);
+    free_fvector(raw[1]);
+    free_fvector(raw[0]);
+    free_cvector(I_t);
+    opsd_free(dirs);
+    opsd_free(images);
+}
+
+//ZVECTOR BATCH
+
+void run_zbatch(const opsd_job *job)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns;
+    size_t lines = job->layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    size_t spectral_size = job->domain == OPSD_REAL ? lines * (length / 2 + 1) : size;
+
+    char stack[1024];
+    size_t total = 0;
+    batch_image *images = list_images(job, size * sizeof(double), &total, stack, sizeof(stack));
+    if (total == 0)
+    {
+        printf("No images found in ../bin/%s\n", job->dir);
+        opsd_free(images);
+        return;
+    }
+
+    size_t group = batch_group(spectral_size * sizeof(MKL_Complex16), total);
+
+    MKL_Complex16 *I_t = NULL;
+    double *raw[2] = {NULL, NULL};
+    const char **dirs = opsd_malloc(group * sizeof(char *));
+    if (dirs == NULL)
+    {
+        printf("Allocation error!\n");
+        exit(EXIT_FAILURE);
+    }
+    init_zvector(&I_t, group * spectral_size);
+    init_dvector(&raw[0], group * size);
+    init_dvector(&raw[1], group * size);
+
+    opsd_job group_job = *job;
+    opsd_workspace workspace;
+    group_job.dirs = dirs;
+    group_job.count = group;
+    init_zworkspace(&group_job, &workspace);
+
+    double start = omp_get_wtime();
+
+    batch_read reader;
+    start_read(&reader, stack[0] ? stack : NULL, images, group, size * sizeof(double), raw[0]);
+
+    for (size_t first = 0, g = 0; first < total; first += group, g++)
+    {
+        size_t count = total - first < group ? total - first : group;
+        pthread_join(reader.thread, NULL);
+
+        size_t next = first + count;
+        if (next < total)
+            start_read(&reader, reader.stack, images + next, total - next < group ? total - next : group, size * sizeof(double), raw[(g + 1) % 2]);
+
+        for (size_t b = 0; b < count; b++)
+        {
+            double *image = raw[g % 2] + b * size;
+            if (job->domain == OPSD_REAL && workspace.modulated)
+                pad_dvector_rows_from_modulated((double *)(I_t + b * spectral_size), image, lines, length);
+            else if (job->domain == OPSD_REAL)
+                pad_dvector_rows_from((double *)(I_t + b * spectral_size), image, lines, length);
+            else if (workspace.modulated)
+                copy_dvector_to_zvector_modulated(I_t + b * spectral_size, image, lines, length);
+            else
+                copy_dvector_to_zvector(I_t + b * spectral_size, image, size);
+            dirs[b] = images[first + b].dir;
+        }
+
+        // One VTune frame per group: its images share every DFTI call
+        group_job.count = count;
+        profile_frame_begin();
+        run_zimages(&group_job, I_t, &workspace);
+        profile_frame_end();
+    }
+
+    report(job, total, group, omp_get_wtime() - start);
+
+    free_zworkspace(&workspace);
+    free_dvector(raw[1]);
+    free_dvector(raw[0]);
+    free_zvector(I_t);
+    opsd_free(dirs);
+    opsd_free(images);
+}
@@ -1,50 +1,100 @@
 #include "../include/fourier.h"
 
+// A column-major rows x columns matrix is the row-major columns x rows one, and
+// every stage below is symmetric in its two axes: column-major calls run the
+// row-major code on the transposed shape, with the row and column edges
+// swapped. Returns 1 when the shape was transposed.
+static int transpose_shape(opsd_layout layout, size_t *rows, size_t *columns)
+{
+    if (layout != OPSD_COLUMN_MAJOR)
+        return 0;
+
+    size_t aux = *rows;
+    *rows = *columns;
+    *columns = aux;
+    return 1;
+}
+
+// out(k, l) = in((k - row_shift) mod rows, (l - column_shift) mod width): every
+// output row is two contiguous copies of one input row, so the rotation
+// streams through both buffers a row at a time, for odd and even sizes alike.
+static void rotate_crows(MKL_Complex8 *in, MKL_Complex8 *out, size_t rows, size_t width, size_t row_shift, size_t column_shift)
+{
+#pragma omp parallel
+    {
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t k = 0; k < rows; k++)
+        {
+            MKL_Complex8 *source = &in[((k + rows - row_shift) % rows) * width];
+            MKL_Complex8 *target = &out[k * width];
+
+            memcpy(target, source + width - column_shift, column_shift * sizeof(MKL_Complex8));
+            memcpy(target + column_shift, source, (width - column_shift) * sizeof(MKL_Complex8));
+        }
+        trace_end("rotate_crows", "omp", chunk);
+    }
+}
+
+// x(i, j) * (-1)^(i + j): for even sizes its spectrum is the centered spectrum of x
+static void modulate_crows(MKL_Complex8 *vector, size_t rows, size_t columns)
+{
+#pragma omp parallel
+    {
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t i = 0; i < rows; i++)
+        {
+            MKL_Complex8 *row = &vector[i * columns];
+            for (size_t j = (i + 1) % 2; j < columns; j += 2)
+            {
+                row[j].real = -row[j].real;
+                row[j].imag = -row[j].imag;
+            }
+        }
+        trace_end("modulate_crows", "omp", chunk);
+    }
+}
+
 //CVECTOR FFT FUNCTIONS
 
-void compute_cfft2d(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns){
+void compute_cfft2d(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout)
+{
     if (I_t_I_w == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
 
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim1 = NULL;
-    MKL_LONG status;
-    MKL_LONG dim_sizes[2] = {rows, columns};
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
 
-    status = DftiCreateDescriptor(&desc_handle_dim1, DFTI_SINGLE,
-                                  DFTI_COMPLEX, 2, dim_sizes);
-    
-    status = DftiCommitDescriptor(desc_handle_dim1);
-    status = DftiComputeForward(desc_handle_dim1, I_t_I_w);
+    transpose_shape(layout, &rows, &columns);
 
-    status = DftiFreeDescriptor(&desc_handle_dim1);
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    trace_forward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
 }
 
-void compute_cifft2d(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns){
+void compute_cifft2d(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout)
+{
     if (I_t_I_w == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
 
-    double start = omp_get_wtime();
-
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim1 = NULL;
-    MKL_LONG status;
-    MKL_LONG dim_sizes[2] = {rows, columns};
+    double start = profile_begin(OPSD_STAGE_IFFT2D);
 
-    status = DftiCreateDescriptor(&desc_handle_dim1, DFTI_SINGLE,
-                                  DFTI_COMPLEX, 2, dim_sizes);
-    
-    status = DftiCommitDescriptor(desc_handle_dim1);
-    status = DftiComputeBackward(desc_handle_dim1, I_t_I_w);
+    transpose_shape(layout, &rows, &columns);
 
-    status = DftiFreeDescriptor(&desc_handle_dim1);     
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_BACKWARD);
+    trace_backward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_IFFT2D, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
 }
 
-void compute_cfft2d_column_row(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns)
+// count images stored rows * columns apart, transformed by one batched call:
+// small images share the DFTI dispatch and threading over the whole batch
+void compute_cfft2d_batch(MKL_Complex8 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout)
 {
     if (I_t_I_w == NULL)
     {
@@ -52,41 +102,51 @@ void compute_cfft2d_column_row(MKL_Complex8 *I_t_I_w, size_t rows, size_t column
         return;
     }
 
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim1 = NULL;
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim2 = NULL;
-    MKL_LONG status;
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_batch_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD, count);
+    trace_forward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, count);
+}
+
+void compute_cifft2d_batch(MKL_Complex8 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
 
-    status = DftiCreateDescriptor(&desc_handle_dim1, DFTI_SINGLE,
-                                  DFTI_COMPLEX, 1, rows);
-    status = DftiCreateDescriptor(&desc_handle_dim2, DFTI_SINGLE,
-                                  DFTI_COMPLEX, 1, columns);
+    double start = profile_begin(OPSD_STAGE_IFFT2D);
 
-    MKL_LONG stride[2] = {0, columns};
+    transpose_shape(layout, &rows, &columns);
 
-    status = DftiSetValue(desc_handle_dim1, DFTI_NUMBER_OF_TRANSFORMS, columns);
-    status = DftiSetValue(desc_handle_dim1, DFTI_INPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim1, DFTI_OUTPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim1, DFTI_INPUT_DISTANCE, 1);
-    status = DftiSetValue(desc_handle_dim1, DFTI_OUTPUT_DISTANCE, 1);
-    status = DftiCommitDescriptor(desc_handle_dim1);
+    opsd_plan *plan = get_batch_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_BACKWARD, count);
+    trace_backward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_IFFT2D, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, count);
+}
 
-    stride[1] = 1;
+void compute_cfft2d_column_row(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
 
-    status = DftiSetValue(desc_handle_dim2, DFTI_NUMBER_OF_TRANSFORMS, rows);
-    status = DftiSetValue(desc_handle_dim2, DFTI_INPUT_DISTANCE, columns);
-    status = DftiSetValue(desc_handle_dim2, DFTI_OUTPUT_DISTANCE, columns);
-    status = DftiSetValue(desc_handle_dim2, DFTI_INPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim2, DFTI_OUTPUT_STRIDES, stride);
-    status = DftiCommitDescriptor(desc_handle_dim2);
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
 
-    status = DftiComputeForward(desc_handle_dim1, I_t_I_w);
-    status = DftiComputeForward(desc_handle_dim2, I_t_I_w);
+    transpose_shape(layout, &rows, &columns);
 
-    status = DftiFreeDescriptor(&desc_handle_dim1);
-    status = DftiFreeDescriptor(&desc_handle_dim2);
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    trace_forward(plan->fft_columns, I_t_I_w, "fft_columns");
+    trace_forward(plan->fft_rows, I_t_I_w, "fft_rows");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
 }
 
-void compute_cperiodic_border_B(MKL_Complex8 *I_t, MKL_Complex8 *B_t, size_t rows, size_t columns)
+void compute_cperiodic_border_B(MKL_Complex8 *I_t, MKL_Complex8 *B_t, size_t rows, size_t columns, opsd_layout layout)
 {
     if (I_t == NULL || B_t == NULL)
     {
@@ -94,6 +154,10 @@ void compute_cperiodic_border_B(MKL_Complex8 *I_t, MKL_Complex8 *B_t, size_t row
         return;
     }
 
+    double start = profile_begin(OPSD_STAGE_B_BORDER);
+
+    transpose_shape(layout, &rows, &columns);
+
     B_t[0].real = I_t[columns - 1].real - 2 * I_t[0].real + I_t[(rows - 1) * columns].real;
     B_t[0].imag = I_t[columns - 1].imag - 2 * I_t[0].imag + I_t[(rows - 1) * columns].imag;
 
@@ -125,9 +189,40 @@ void compute_cperiodic_border_B(MKL_Complex8 *I_t, MKL_Complex8 *B_t, size_t row
         B_t[columns - 1 + i * columns].real = B_t[i * columns].real * (-1);
         B_t[columns - 1 + i * columns].imag = B_t[i * columns].imag * (-1);
     }
+    profile_end(OPSD_STAGE_B_BORDER, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+// The border image is B = v1 + v2: v1 holds +-r on the first and last rows,
+// with r_j = I(M-1, j) - I(0, j), and v2 holds +-c on the first and last
+// columns, with c_i = I(i, N-1) - I(i, 0). Both terms are separable, so
+//     B_w(k, l) = (1 - W_M^-k) R(l) + C(k) (1 - W_N^-l),
+// where R and C are the 1D FFTs of r and c. Fills 'width' columns of B_w (the
+// full spectrum, or the CCE half of the real path) from the transformed edges.
+static void build_cborder_spectrum(MKL_Complex8 *B_w, MKL_Complex8 *R, MKL_Complex8 *C, size_t width, opsd_plan *plan)
+{
+    MKL_Complex8 *v_rows = (MKL_Complex8 *)plan->v_rows;
+    MKL_Complex8 *v_columns = (MKL_Complex8 *)plan->v_columns;
+
+#pragma omp parallel
+    {
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t k = 0; k < plan->rows; k++)
+        {
+            MKL_Complex8 vk = v_rows[k], ck = C[k];
+            MKL_Complex8 *row = &B_w[k * width];
+
+            for (size_t l = 0; l < width; l++)
+            {
+                row[l].real = vk.real * R[l].real - vk.imag * R[l].imag + ck.real * v_columns[l].real - ck.imag * v_columns[l].imag;
+                row[l].imag = vk.real * R[l].imag + vk.imag * R[l].real + ck.real * v_columns[l].imag + ck.imag * v_columns[l].real;
+            }
+        }
+        trace_end("build_cborder_spectrum", "omp", chunk);
+    }
 }
 
-void compute_cfft2d_of_border_B(MKL_Complex8 *B_t_B_w, size_t rows, size_t columns)
+void compute_cfft2d_of_border_B(MKL_Complex8 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout)
 {
     if (B_t_B_w == NULL)
     {
@@ -135,101 +230,110 @@ void compute_cfft2d_of_border_B(MKL_Complex8 *B_t_B_w, size_t rows, size_t colum
         return;
     }
 
-    // Column-one FFT
-    MKL_Complex8 *a = (MKL_Complex8 *)malloc(sizeof(MKL_Complex8));
-    a->real = B_t_B_w[0].real + B_t_B_w[columns - 1].real;
-    a->imag = B_t_B_w[0].imag + B_t_B_w[columns - 1].imag;
+    double start = profile_begin(OPSD_STAGE_C_FFT_BORDER);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
 
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim1 = NULL;
-    MKL_LONG status;
+    // Edge vectors from the plan's scratch: no heap traffic after the first call
+    size_t mark = scratch_mark(plan);
+    MKL_Complex8 *R = scratch_alloc(plan, columns * sizeof(MKL_Complex8));
+    MKL_Complex8 *C = scratch_alloc(plan, rows * sizeof(MKL_Complex8));
 
-    status = DftiCreateDescriptor(&desc_handle_dim1, DFTI_SINGLE,
-                                  DFTI_COMPLEX, 1, rows);
+    // Only B_t's first row and column are read. The corners do not separate
+    // v1 from v2, but B_w only depends on their sum, so r_0 = 0 is assumed.
+    for (size_t i = 0; i < rows; i++)
+        C[i] = B_t_B_w[i * columns];
 
-    MKL_LONG stride[2] = {0, columns};
+    for (size_t j = 0; j < columns; j++)
+        R[j] = B_t_B_w[j];
+    R[0].real = 0.0f;
+    R[0].imag = 0.0f;
+    R[columns - 1].real += C[0].real;
+    R[columns - 1].imag += C[0].imag;
 
-    status = DftiSetValue(desc_handle_dim1, DFTI_NUMBER_OF_TRANSFORMS, 1);
-    status = DftiSetValue(desc_handle_dim1, DFTI_INPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim1, DFTI_OUTPUT_STRIDES, stride);
-    status = DftiCommitDescriptor(desc_handle_dim1);
-    status = DftiComputeForward(desc_handle_dim1, B_t_B_w);
-    status = DftiFreeDescriptor(&desc_handle_dim1);
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    build_cborder_spectrum(B_t_B_w, R, C, columns, plan);
 
-    // Calcular cada elemento de v usando a fórmula W^k = exp(-i * 2 * PI * k / M)
-    MKL_Complex8 *v = (MKL_Complex8 *)malloc(rows * sizeof(MKL_Complex8));
-    if (v == NULL)
+    scratch_release(plan, mark);
+    profile_end(OPSD_STAGE_C_FFT_BORDER, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+// Reference version of Step C: strided FFT of column 0, rank-1 fill of the
+// other columns and a batch of row FFTs over the whole matrix.
+void compute_cfft2d_of_border_B_batch(MKL_Complex8 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (B_t_B_w == NULL)
     {
-        printf("Erro ao alocar memória\n");
+        printf("Matrix not found!\n");
         return;
     }
 
-    v[0].real = 0.00f;
-    v[0].imag = 0.00f;
+    double start = profile_begin(OPSD_STAGE_C_FFT_BORDER);
 
-    for (int k = 1; k < rows; k++)
-    {
-        float theta = -2.0f * PI * (rows - k) / rows;
-        v[k].real = 1.0f - cosf(theta);
-        v[k].imag = sinf(theta) * (-1);
-    }
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    MKL_Complex8 *v = (MKL_Complex8 *)plan->v_rows;
+
+    // Column-one FFT
+    MKL_Complex8 a = {B_t_B_w[0].real + B_t_B_w[columns - 1].real, B_t_B_w[0].imag + B_t_B_w[columns - 1].imag};
+
+    trace_forward(plan->fft_column, B_t_B_w, "fft_column");
 
     cblas_ccopy(rows, B_t_B_w, columns, &B_t_B_w[columns - 1], columns);
     cblas_csscal(rows, -1.0f, &B_t_B_w[columns - 1], columns);
-    cblas_caxpy(rows, a, v, 1, &B_t_B_w[columns - 1], columns);
+    cblas_caxpy(rows, &a, v, 1, &B_t_B_w[columns - 1], columns);
 
     for (int j = 1; j < columns - 1; j++)
     {
-        a->real = B_t_B_w[j].real;
-        a->imag = B_t_B_w[j].imag;
+        a.real = B_t_B_w[j].real;
+        a.imag = B_t_B_w[j].imag;
         cblas_ccopy(rows, v, 1, &B_t_B_w[j], columns);
-        cblas_cscal(rows, a, &B_t_B_w[j], columns);
+        cblas_cscal(rows, &a, &B_t_B_w[j], columns);
     }
 
-    free(v);
-    free(a);
-
     // Row-by-Row FFT
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim3 = NULL;
-    status = DftiCreateDescriptor(&desc_handle_dim3, DFTI_SINGLE,
-                                  DFTI_COMPLEX, 1, columns);
-
-    stride[1] = 1;
-
-    status = DftiSetValue(desc_handle_dim3, DFTI_NUMBER_OF_TRANSFORMS, rows);
-    status = DftiSetValue(desc_handle_dim3, DFTI_INPUT_DISTANCE, columns);
-    status = DftiSetValue(desc_handle_dim3, DFTI_OUTPUT_DISTANCE, columns);
-    status = DftiSetValue(desc_handle_dim3, DFTI_INPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim3, DFTI_OUTPUT_STRIDES, stride);
-    status = DftiCommitDescriptor(desc_handle_dim3);
-    status = DftiComputeForward(desc_handle_dim3, B_t_B_w);
-    status = DftiFreeDescriptor(&desc_handle_dim3);
+    trace_forward(plan->fft_rows, B_t_B_w, "fft_rows");
+    profile_end(OPSD_STAGE_C_FFT_BORDER, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
 }
 
-void compute_csmooth_component_S(MKL_Complex8 *B_S, size_t rows, size_t columns)
+// Step D over 'outer' lines of 'width' elements: element (i, j) is multiplied
+// by the reciprocal of denom_outer[i] + denom_inner[j]. Row-major data passes
+// the row table as outer; column-major data swaps the two tables. The
+// reciprocal is formed in-register from the separable tables: a stored M x N
+// table would only add traffic to a bandwidth-bound loop. B_S(0, 0) is kept.
+static void apply_csmooth(MKL_Complex8 *B_S, const float *denom_outer, size_t outer, const float *denom_inner, size_t inner, size_t width)
 {
-    if (B_S == NULL)
-    {
-        printf("Matrix not found!\n");
-        return;
-    }
-
     MKL_Complex8 aux = {B_S[0].real, B_S[0].imag};
 
-    for (int i = 0; i < rows; i++)
+#pragma omp parallel
     {
-        for (int j = 0; j < columns; j++)
+        double chunk = trace_begin();
+#pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < outer; i++)
         {
-            float denom = (2.0f * cosf(2.0f * PI * i / rows) + 2.0f * cosf(2.0f * PI * j / columns) - 4.0f);
-            B_S[j + i * columns].real /= denom;
-            B_S[j + i * columns].imag /= denom;
+            float d = denom_outer[i];
+            float *line = (float *)&B_S[i * width];
+
+#pragma omp simd
+            for (size_t j = 0; j < inner; j++)
+            {
+                float r = 1.0f / (d + denom_inner[j]);
+                line[2 * j] *= r;
+                line[2 * j + 1] *= r;
+            }
         }
+        trace_end("apply_csmooth", "omp", chunk);
     }
 
     B_S[0].real = aux.real;
     B_S[0].imag = aux.imag;
 }
 
-void compute_csmooth_component_S_2(MKL_Complex8 *B_S, size_t rows, size_t columns)
+void compute_csmooth_component_S(MKL_Complex8 *B_S, size_t rows, size_t columns, opsd_layout layout)
 {
     if (B_S == NULL)
     {
@@ -237,388 +341,1712 @@ void compute_csmooth_component_S_2(MKL_Complex8 *B_S, size_t rows, size_t column
         return;
     }
 
-    MKL_Complex8 aux = {B_S[0].real, B_S[0].imag};
+    double start = profile_begin(OPSD_STAGE_D_SMOOTH);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    apply_csmooth(B_S, (float *)plan->denom_rows, rows, (float *)plan->denom_columns, columns, columns);
+    profile_end(OPSD_STAGE_D_SMOOTH, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+// Step E is elementwise over the whole matrix, so it reads the same memory in
+// either layout; layout only puts the shape in memory order for the profile, as
+// the other stages report it.
+void compute_cperiodic_component_P(MKL_Complex8 *I_w, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || S == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_E_PERIODIC);
 
-    float *v1 = (float *)malloc(rows * sizeof(float));
-    float *v2 = (float *)malloc(columns * sizeof(float));
+    transpose_shape(layout, &rows, &columns);
 
-    for (int i = 0; i < rows; i++)
+    vcSub(rows * columns, I_w, S, I_w);
+    profile_end(OPSD_STAGE_E_PERIODIC, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+// One output row of the fused kernel: 'count' columns whose edge spectrum,
+// twiddles and denominators start at R, v_columns and denom_columns.
+static inline void fused_crow(MKL_Complex8 *I_row, MKL_Complex8 *S_row, MKL_Complex8 vk, MKL_Complex8 ck, float dk,
+                              const MKL_Complex8 *R, const MKL_Complex8 *v_columns, const float *denom_columns, size_t count)
+{
+    if (S_row == NULL)
     {
-        v1[i] = (2.0f * PI * i) / rows;
+#pragma omp simd
+        for (size_t l = 0; l < count; l++)
+        {
+            float r = 1.0f / (dk + denom_columns[l]);
+            I_row[l].real -= (vk.real * R[l].real - vk.imag * R[l].imag + ck.real * v_columns[l].real - ck.imag * v_columns[l].imag) * r;
+            I_row[l].imag -= (vk.real * R[l].imag + vk.imag * R[l].real + ck.real * v_columns[l].imag + ck.imag * v_columns[l].real) * r;
+        }
     }
-    
-    for (int i = 0; i < columns; i++)
+    else
     {
-        v2[i] = (2.0f * PI * (i)) / columns;
+#pragma omp simd
+        for (size_t l = 0; l < count; l++)
+        {
+            float r = 1.0f / (dk + denom_columns[l]);
+            S_row[l].real = (vk.real * R[l].real - vk.imag * R[l].imag + ck.real * v_columns[l].real - ck.imag * v_columns[l].imag) * r;
+            S_row[l].imag = (vk.real * R[l].imag + vk.imag * R[l].real + ck.real * v_columns[l].imag + ck.imag * v_columns[l].real) * r;
+            I_row[l].real -= S_row[l].real;
+            I_row[l].imag -= S_row[l].imag;
+        }
     }
+}
+
+// Steps C, D and E in one streaming pass: each S(k, l) is built from the edge
+// spectra R and C, divided by the Laplacian denominator and subtracted from
+// I_w, so the border matrix is never stored. S may be NULL; otherwise it also
+// receives the smooth component. Position (k, l) holds the frequency
+// ((k - row_shift) mod rows, (l - column_shift) mod columns): with shifts of
+// rows / 2 and columns / 2 a centered I_w gets a centered S, with no shift pass.
+static void apply_cperiodic_fused(MKL_Complex8 *I_w, MKL_Complex8 *S, MKL_Complex8 *R, MKL_Complex8 *C, size_t width,
+                                  size_t row_shift, size_t column_shift, opsd_plan *plan)
+{
+    MKL_Complex8 *v_rows = (MKL_Complex8 *)plan->v_rows;
+    MKL_Complex8 *v_columns = (MKL_Complex8 *)plan->v_columns;
+    float *denom_rows = (float *)plan->denom_rows;
+    float *denom_columns = (float *)plan->denom_columns;
+    size_t rows = plan->rows, tail = plan->columns - column_shift;
 
-    float *cos_1 = (float *)malloc(rows * sizeof(float));
-    float *cos_2 = (float *)malloc(columns * sizeof(float));
-    mkl_set_num_threads(8);
-    vsCos(rows, v1, cos_1);
-    vsCos(columns, v2, cos_2);
-    cblas_sscal(rows, 2.0f, cos_1, 1);
-    cblas_sscal(columns, 2.0f, cos_2, 1);
-    mkl_set_num_threads(1);
+    // B_w(0, 0) = 0 and its denominator is 0: keep I_w(0, 0), as Step D does
+    size_t zero = row_shift * width + column_shift;
+    MKL_Complex8 aux = {I_w[zero].real, I_w[zero].imag};
 
-    for (int i = 0; i < rows; i++)
+#pragma omp parallel
     {
-        for (int j = 0; j < columns; j++)
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t k = 0; k < rows; k++)
         {
-            float denom = cos_1[i] + cos_2[j] - 4.0f;
-            B_S[i + j * rows].real /= denom;
-            B_S[i + j * rows].imag /= denom;
+            size_t source = (k + rows - row_shift) % rows;
+            MKL_Complex8 vk = v_rows[source], ck = C[source];
+            float dk = denom_rows[source];
+            MKL_Complex8 *I_row = &I_w[k * width];
+            MKL_Complex8 *S_row = S != NULL ? &S[k * width] : NULL;
+
+            // Columns [0, column_shift) hold the negative frequencies
+            fused_crow(I_row, S_row, vk, ck, dk, R + tail, v_columns + tail, denom_columns + tail, column_shift);
+            fused_crow(I_row + column_shift, S_row != NULL ? S_row + column_shift : NULL, vk, ck, dk, R, v_columns, denom_columns,
+                       width - column_shift);
         }
+        trace_end("apply_cperiodic_fused", "omp", chunk);
     }
 
-    B_S[0].real = aux.real;
-    B_S[0].imag = aux.imag;
+    I_w[zero].real = aux.real;
+    I_w[zero].imag = aux.imag;
+    if (S != NULL)
+    {
+        S[zero].real = 0.0f;
+        S[zero].imag = 0.0f;
+    }
 }
 
-
-void compute_cperiodic_component_P(MKL_Complex8 *I_w, MKL_Complex8 *S, size_t rows, size_t columns)
+// Step B reduced to its edges: R and C receive the FFTs of the row and column
+// edge differences of I_t, the only data Steps C-E need from the border. A
+// modulated I_t (even sizes, times (-1)^(i + j)) gives them back as sums:
+// x(last, j) - x(0, j) = -(-1)^j (I_t(last, j) + I_t(0, j)), and likewise
+// along the columns.
+static void border_cedges(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout, int modulated)
 {
-    if (I_w == NULL || S == NULL)
+    if (I_t == NULL || R == NULL || C == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
-    
-    vcSub(rows * columns, I_w, S, I_w);
-}
 
-void compute_cfftshift(MKL_Complex8 *vector, size_t rows, size_t columns) {
-    size_t half_rows = rows / 2;
-    size_t half_columns = columns / 2;
-    
-    // Troca os quadrantes (1,4) e (2,3)
-    for (size_t i = 0; i < half_rows; i++) {
-        for (size_t j = 0; j < half_columns; j++) {
-            // Índices dos elementos a serem trocados
-            size_t index1 = i * columns + j;
-            size_t index2 = (i + half_rows) * columns + (j + half_columns);
-            size_t index3 = i * columns + (j + half_columns);
-            size_t index4 = (i + half_rows) * columns + j;
+    double start = profile_begin(OPSD_STAGE_B_EDGES);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex8 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+
+    if (modulated)
+    {
+        for (size_t j = 0; j < columns; j++)
+        {
+            float sign = j % 2 == 0 ? -1 : 1;
+            R[j].real = sign * (I_t[j + (rows - 1) * columns].real + I_t[j].real);
+            R[j].imag = sign * (I_t[j + (rows - 1) * columns].imag + I_t[j].imag);
+        }
+
+        for (size_t i = 0; i < rows; i++)
+        {
+            float sign = i % 2 == 0 ? -1 : 1;
+            C[i].real = sign * (I_t[columns - 1 + i * columns].real + I_t[i * columns].real);
+            C[i].imag = sign * (I_t[columns - 1 + i * columns].imag + I_t[i * columns].imag);
+        }
+    }
+    else
+    {
+        for (size_t j = 0; j < columns; j++)
+        {
+            R[j].real = I_t[j + (rows - 1) * columns].real - I_t[j].real;
+            R[j].imag = I_t[j + (rows - 1) * columns].imag - I_t[j].imag;
+        }
 
-            // Swap (1,4)
-            MKL_Complex8 temp = vector[index1];
-            vector[index1] = vector[index2];
-            vector[index2] = temp;
-            
-            // Swap (2,3)
-            temp = vector[index3];
-            vector[index3] = vector[index4];
-            vector[index4] = temp;
+        for (size_t i = 0; i < rows; i++)
+        {
+            C[i].real = I_t[columns - 1 + i * columns].real - I_t[i * columns].real;
+            C[i].imag = I_t[columns - 1 + i * columns].imag - I_t[i * columns].imag;
         }
     }
+
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    profile_end(OPSD_STAGE_B_EDGES, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
 }
 
-//ZVECTOR FFT FUNCTIONS
+void compute_cborder_edges(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout)
+{
+    border_cedges(I_t, R, C, rows, columns, layout, 0);
+}
 
-void compute_zfft2d(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns){
-    if (I_t_I_w == NULL)
+void compute_cborder_edges_modulated(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout)
+{
+    border_cedges(I_t, R, C, rows, columns, layout, 1);
+}
+
+void compute_cperiodic_component_P_fused(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
 
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim1 = NULL;
-    MKL_LONG status;
-    MKL_LONG dim_sizes[2] = {rows, columns};
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED);
 
-    status = DftiCreateDescriptor(&desc_handle_dim1, DFTI_DOUBLE,
-                                  DFTI_COMPLEX, 2, dim_sizes);
-    
-    status = DftiCommitDescriptor(desc_handle_dim1);
-    status = DftiComputeForward(desc_handle_dim1, I_t_I_w);
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex8 *aux = R;
+        R = C;
+        C = aux;
+    }
 
-    status = DftiFreeDescriptor(&desc_handle_dim1);
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    apply_cperiodic_fused(I_w, S, R, C, columns, 0, 0, plan);
+    profile_end(OPSD_STAGE_CDE_FUSED, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
 }
 
-void compute_zifft2d(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns){
-    if (I_t_I_w == NULL)
+void compute_cfftshift(MKL_Complex8 *in, MKL_Complex8 *out, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (in == NULL || out == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
 
-    double start = omp_get_wtime();
+    double start = profile_begin(OPSD_STAGE_FFTSHIFT);
 
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim1 = NULL;
-    MKL_LONG status;
-    MKL_LONG dim_sizes[2] = {rows, columns};
+    transpose_shape(layout, &rows, &columns);
 
-    status = DftiCreateDescriptor(&desc_handle_dim1, DFTI_DOUBLE,
-                                  DFTI_COMPLEX, 2, dim_sizes);
-    
-    status = DftiCommitDescriptor(desc_handle_dim1);
-    status = DftiComputeBackward(desc_handle_dim1, I_t_I_w);
-
-    status = DftiFreeDescriptor(&desc_handle_dim1);     
+    rotate_crows(in, out, rows, columns, rows / 2, columns / 2);
+    profile_end(OPSD_STAGE_FFTSHIFT, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
 }
 
-void compute_zfft2d_column_row(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns)
+// Step A with a centered result, I_t being lost. Even sizes modulate I_t (unless
+// its loader already did) and transform it in place; odd sizes transform it and
+// rotate the spectrum into work (unused otherwise, may be NULL). Returns the
+// buffer holding the centered spectrum.
+static MKL_Complex8 *fft2d_cshifted(MKL_Complex8 *I_t, MKL_Complex8 *work, size_t rows, size_t columns, opsd_layout layout, int modulated)
 {
-    if (I_t_I_w == NULL)
+    transpose_shape(layout, &rows, &columns);
+
+    int even = rows % 2 == 0 && columns % 2 == 0;
+    if (I_t == NULL || (!even && work == NULL))
     {
         printf("Matrix not found!\n");
-        return;
+        return NULL;
     }
 
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim1 = NULL;
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim2 = NULL;
-    MKL_LONG status;
+    double start = profile_begin(OPSD_STAGE_A_FFT2D_SHIFTED);
 
-    status = DftiCreateDescriptor(&desc_handle_dim1, DFTI_DOUBLE,
-                                  DFTI_COMPLEX, 1, rows);
-    status = DftiCreateDescriptor(&desc_handle_dim2, DFTI_DOUBLE,
-                                  DFTI_COMPLEX, 1, columns);
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
 
-    MKL_LONG stride[2] = {0, columns};
+    if (even)
+    {
+        if (!modulated)
+            modulate_crows(I_t, rows, columns);
+        trace_forward(plan->fft2d, I_t, "fft2d");
+        profile_end(OPSD_STAGE_A_FFT2D_SHIFTED, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
+        return I_t;
+    }
+
+    trace_forward(plan->fft2d, I_t, "fft2d");
+    rotate_crows(I_t, work, rows, columns, rows / 2, columns / 2);
+    profile_end(OPSD_STAGE_A_FFT2D_SHIFTED, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
+    return work;
+}
 
-    status = DftiSetValue(desc_handle_dim1, DFTI_NUMBER_OF_TRANSFORMS, columns);
-    status = DftiSetValue(desc_handle_dim1, DFTI_INPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim1, DFTI_OUTPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim1, DFTI_INPUT_DISTANCE, 1);
-    status = DftiSetValue(desc_handle_dim1, DFTI_OUTPUT_DISTANCE, 1);
-    status = DftiCommitDescriptor(desc_handle_dim1);
+MKL_Complex8 *compute_cfft2d_shifted(MKL_Complex8 *I_t, MKL_Complex8 *work, size_t rows, size_t columns, opsd_layout layout)
+{
+    return fft2d_cshifted(I_t, work, rows, columns, layout, 0);
+}
+
+// Step A centered for an even I_t its loader modulated (see
+// copy_fvector_to_cvector_modulated): the forward FFT alone
+void compute_cfft2d_modulated(MKL_Complex8 *I_t, size_t rows, size_t columns, opsd_layout layout)
+{
+    fft2d_cshifted(I_t, NULL, rows, columns, layout, 1);
+}
 
-    stride[1] = 1;
+// Steps C-E on a centered I_w: S is produced centered, as the css routine saves it
+void compute_cperiodic_component_P_fused_shifted(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
 
-    status = DftiSetValue(desc_handle_dim2, DFTI_NUMBER_OF_TRANSFORMS, rows);
-    status = DftiSetValue(desc_handle_dim2, DFTI_INPUT_DISTANCE, columns);
-    status = DftiSetValue(desc_handle_dim2, DFTI_OUTPUT_DISTANCE, columns);
-    status = DftiSetValue(desc_handle_dim2, DFTI_INPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim2, DFTI_OUTPUT_STRIDES, stride);
-    status = DftiCommitDescriptor(desc_handle_dim2);
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED_SHIFTED);
 
-    status = DftiComputeForward(desc_handle_dim1, I_t_I_w);
-    status = DftiComputeForward(desc_handle_dim2, I_t_I_w);
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex8 *aux = R;
+        R = C;
+        C = aux;
+    }
 
-    status = DftiFreeDescriptor(&desc_handle_dim1);
-    status = DftiFreeDescriptor(&desc_handle_dim2);
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    apply_cperiodic_fused(I_w, S, R, C, columns, rows / 2, columns / 2, plan);
+    profile_end(OPSD_STAGE_CDE_FUSED_SHIFTED, start, OPSD_SINGLE, OPSD_COMPLEX, rows, columns, 1);
 }
 
-void compute_zperiodic_border_B(MKL_Complex16 *I_t, MKL_Complex16 *B_t, size_t rows, size_t columns)
+// Step B from edge differences gathered elsewhere: R holds the last row of the
+// image minus the first, C its last column minus the first, as
+// compute_cborder_edges builds them. Both are transformed in place. The
+// out-of-core path collects them while streaming the image.
+void compute_cedge_spectra(MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_domain domain)
 {
-    if (I_t == NULL || B_t == NULL)
+    if (R == NULL || C == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
 
-    B_t[0].real = I_t[columns - 1].real - 2 * I_t[0].real + I_t[(rows - 1) * columns].real;
-    B_t[0].imag = I_t[columns - 1].imag - 2 * I_t[0].imag + I_t[(rows - 1) * columns].imag;
+    double start = profile_begin(OPSD_STAGE_B_EDGES);
 
-    B_t[columns - 1].real = I_t[0].real - 2 * I_t[columns - 1].real + I_t[rows * columns - 1].real;
-    B_t[columns - 1].imag = I_t[0].imag - 2 * I_t[columns - 1].imag + I_t[rows * columns - 1].imag;
+    opsd_plan *plan = get_plan(OPSD_SINGLE, domain, rows, columns, OPSD_FORWARD);
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    profile_end(OPSD_STAGE_B_EDGES, start, OPSD_SINGLE, domain, rows, columns, 1);
+}
 
-    B_t[(rows - 1) * columns].real = I_t[0].real - 2 * I_t[(rows - 1) * columns].real + I_t[rows * columns - 1].real;
-    B_t[(rows - 1) * columns].imag = I_t[0].imag - 2 * I_t[(rows - 1) * columns].imag + I_t[rows * columns - 1].imag;
+// Steps C-E on columns [first, first + count) of the row-major rows x columns
+// spectrum (rows x (columns / 2 + 1) for real input), stored transposed: slab
+// column l holds I_w(., first + l) in rows contiguous elements. fused_crow runs
+// down each column with the row and column tables swapped, which gives the
+// same S since B_w(k, l) is symmetric in its two axes.
+void compute_cperiodic_component_P_fused_columns(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns,
+                                                 size_t first, size_t count, opsd_domain domain)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
 
-    B_t[rows * columns - 1].real = I_t[columns - 1].real - 2 * I_t[rows * columns - 1].real + I_t[(rows - 1) * columns].real;
-    B_t[rows * columns - 1].imag = I_t[columns - 1].imag - 2 * I_t[rows * columns - 1].imag + I_t[(rows - 1) * columns].imag;
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED);
 
-    // linha 0 e rows-1
-    for (int j = 1; j < columns - 1; j++)
-    {
-        B_t[j].real = I_t[j + (rows - 1) * columns].real - I_t[j].real;
-        B_t[j].imag = I_t[j + (rows - 1) * columns].imag - I_t[j].imag;
+    opsd_plan *plan = get_plan(OPSD_SINGLE, domain, rows, columns, OPSD_FORWARD);
+    MKL_Complex8 *v_rows = (MKL_Complex8 *)plan->v_rows;
+    MKL_Complex8 *v_columns = (MKL_Complex8 *)plan->v_columns;
+    float *denom_rows = (float *)plan->denom_rows;
+    float *denom_columns = (float *)plan->denom_columns;
 
-        B_t[j + (rows - 1) * columns].real = B_t[j].real * (-1);
-        B_t[j + (rows - 1) * columns].imag = B_t[j].imag * (-1);
-    }
+    // B_w(0, 0) = 0 and its denominator is 0: keep I_w(0, 0), as Step D does
+    MKL_Complex8 aux = {I_w[0].real, I_w[0].imag};
 
-    // coluna 0 e columns-1
-    for (int i = 1; i < rows - 1; i++)
+#pragma omp parallel
     {
-        B_t[i * columns].real = I_t[columns - 1 + i * columns].real - I_t[i * columns].real;
-        B_t[i * columns].imag = I_t[columns - 1 + i * columns].imag - I_t[i * columns].imag;
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t l = 0; l < count; l++)
+        {
+            size_t j = first + l;
+            fused_crow(&I_w[l * rows], S != NULL ? &S[l * rows] : NULL, v_columns[j], R[j], denom_columns[j], C, v_rows, denom_rows,
+                       rows);
+        }
+        trace_end("compute_cperiodic_component_P_fused_columns", "omp", chunk);
+    }
 
-        B_t[columns - 1 + i * columns].real = B_t[i * columns].real * (-1);
-        B_t[columns - 1 + i * columns].imag = B_t[i * columns].imag * (-1);
+    if (first == 0)
+    {
+        I_w[0].real = aux.real;
+        I_w[0].imag = aux.imag;
+        if (S != NULL)
+        {
+            S[0].real = 0.0f;
+            S[0].imag = 0.0f;
+        }
     }
+    profile_end(OPSD_STAGE_CDE_FUSED, start, OPSD_SINGLE, OPSD_COMPLEX, count, rows, 1);
 }
 
-void compute_zfft2d_of_border_B(MKL_Complex16 *B_t_B_w, size_t rows, size_t columns)
+//REAL INPUT (CCE) FUNCTIONS
+// Real images are stored in rows padded to 2 * (columns / 2 + 1) floats, so the
+// in-place R2C leaves the rows x (columns / 2 + 1) non-redundant spectrum in
+// the same buffer.
+
+void compute_cfft2d_real(MKL_Complex8 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout)
 {
-    if (B_t_B_w == NULL)
+    if (I_t_I_w == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
 
-    // Column-one FFT
-    MKL_Complex16 *a = (MKL_Complex16 *)malloc(sizeof(MKL_Complex16));
-    a->real = B_t_B_w[0].real + B_t_B_w[columns - 1].real;
-    a->imag = B_t_B_w[0].imag + B_t_B_w[columns - 1].imag;
-
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim1 = NULL;
-    MKL_LONG status;
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
 
-    status = DftiCreateDescriptor(&desc_handle_dim1, DFTI_DOUBLE,
-                                  DFTI_COMPLEX, 1, rows);
+    transpose_shape(layout, &rows, &columns);
 
-    MKL_LONG stride[2] = {0, columns};
-
-    status = DftiSetValue(desc_handle_dim1, DFTI_NUMBER_OF_TRANSFORMS, 1);
-    status = DftiSetValue(desc_handle_dim1, DFTI_INPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim1, DFTI_OUTPUT_STRIDES, stride);
-    status = DftiCommitDescriptor(desc_handle_dim1);
-    status = DftiComputeForward(desc_handle_dim1, B_t_B_w);
-    status = DftiFreeDescriptor(&desc_handle_dim1);
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    trace_forward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+}
 
-    // Calcular cada elemento de v usando a fórmula W^k = exp(-i * 2 * PI * k / M)
-    MKL_Complex16 *v = (MKL_Complex16 *)malloc(rows * sizeof(MKL_Complex16));
-    if (v == NULL)
+void compute_cifft2d_real(MKL_Complex8 *I_w_I_t, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w_I_t == NULL)
     {
-        printf("Erro ao alocar memória\n");
+        printf("Matrix not found!\n");
         return;
     }
 
-    v[0].real = 0.00;
-    v[0].imag = 0.00;
+    double start = profile_begin(OPSD_STAGE_IFFT2D);
 
-    for (int k = 1; k < rows; k++)
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_BACKWARD);
+    trace_backward(plan->fft2d, I_w_I_t, "fft2d");
+    profile_end(OPSD_STAGE_IFFT2D, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+}
+
+// count padded images, rows * 2 * (columns / 2 + 1) floats apart
+void compute_cfft2d_real_batch(MKL_Complex8 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
     {
-        float theta = -2.0 * PI * (rows - k) / rows;
-        v[k].real = 1.0 - cos(theta);
-        v[k].imag = sin(theta) * (-1);
+        printf("Matrix not found!\n");
+        return;
     }
 
-    cblas_ccopy(rows, B_t_B_w, columns, &B_t_B_w[columns - 1], columns);
-    cblas_csscal(rows, -1.0, &B_t_B_w[columns - 1], columns);
-    cblas_caxpy(rows, a, v, 1, &B_t_B_w[columns - 1], columns);
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
 
-    for (int j = 1; j < columns - 1; j++)
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_batch_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_FORWARD, count);
+    trace_forward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_SINGLE, OPSD_REAL, rows, columns, count);
+}
+
+void compute_cifft2d_real_batch(MKL_Complex8 *I_w_I_t, size_t count, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w_I_t == NULL)
     {
-        a->real = B_t_B_w[j].real;
-        a->imag = B_t_B_w[j].imag;
-        cblas_ccopy(rows, v, 1, &B_t_B_w[j], columns);
-        cblas_cscal(rows, a, &B_t_B_w[j], columns);
+        printf("Matrix not found!\n");
+        return;
     }
 
-    free(v);
-    free(a);
+    double start = profile_begin(OPSD_STAGE_IFFT2D);
 
-    // Row-by-Row FFT
-    DFTI_DESCRIPTOR_HANDLE desc_handle_dim3 = NULL;
-    status = DftiCreateDescriptor(&desc_handle_dim3, DFTI_DOUBLE,
-                                  DFTI_COMPLEX, 1, columns);
-
-    stride[1] = 1;
+    transpose_shape(layout, &rows, &columns);
 
-    status = DftiSetValue(desc_handle_dim3, DFTI_NUMBER_OF_TRANSFORMS, rows);
-    status = DftiSetValue(desc_handle_dim3, DFTI_INPUT_DISTANCE, columns);
-    status = DftiSetValue(desc_handle_dim3, DFTI_OUTPUT_DISTANCE, columns);
-    status = DftiSetValue(desc_handle_dim3, DFTI_INPUT_STRIDES, stride);
-    status = DftiSetValue(desc_handle_dim3, DFTI_OUTPUT_STRIDES, stride);
-    status = DftiCommitDescriptor(desc_handle_dim3);
-    status = DftiComputeForward(desc_handle_dim3, B_t_B_w);
-    status = DftiFreeDescriptor(&desc_handle_dim3);
+    opsd_plan *plan = get_batch_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_BACKWARD, count);
+    trace_backward(plan->fft2d, I_w_I_t, "fft2d");
+    profile_end(OPSD_STAGE_IFFT2D, start, OPSD_SINGLE, OPSD_REAL, rows, columns, count);
 }
 
-void compute_zsmooth_component_S(MKL_Complex16 *B_S, size_t rows, size_t columns)
+void compute_cperiodic_border_B_real(MKL_Complex8 *I_t, MKL_Complex8 *B_t, size_t rows, size_t columns, opsd_layout layout)
 {
-    if (B_S == NULL)
+    if (I_t == NULL || B_t == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
 
-    MKL_Complex16 aux = {B_S[0].real, B_S[0].imag};
+    double start = profile_begin(OPSD_STAGE_B_BORDER);
+
+    transpose_shape(layout, &rows, &columns);
+
+    float *image = (float *)I_t;
+    float *border = (float *)B_t;
+    size_t ld = 2 * (columns / 2 + 1);
+
+    // linha 0 e rows-1
+    for (size_t j = 0; j < columns; j++)
+    {
+        border[j] = image[j + (rows - 1) * ld] - image[j];
+        border[j + (rows - 1) * ld] = border[j] * (-1);
+    }
 
-    for (int i = 0; i < rows; i++)
+    // coluna 0 e columns-1 (os cantos acumulam as duas contribuições)
+    for (size_t i = 0; i < rows; i++)
     {
-        for (int j = 0; j < columns; j++)
+        float d = image[columns - 1 + i * ld] - image[i * ld];
+        if (i == 0 || i == rows - 1)
+        {
+            border[i * ld] += d;
+            border[columns - 1 + i * ld] -= d;
+        }
+        else
         {
-            float denom = (2.0 * cos(2.0 * PI * i / rows) + 2.0 * cos(2.0 * PI * j / columns) - 4.0);
-            B_S[j + i * columns].real /= denom;
-            B_S[j + i * columns].imag /= denom;
+            border[i * ld] = d;
+            border[columns - 1 + i * ld] = d * (-1);
         }
     }
-
-    B_S[0].real = aux.real;
-    B_S[0].imag = aux.imag;
+    profile_end(OPSD_STAGE_B_BORDER, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
 }
 
-void compute_zsmooth_component_S_2(MKL_Complex16 *B_S, size_t rows, size_t columns)
+void compute_cfft2d_of_border_B_real(MKL_Complex8 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout)
 {
-    if (B_S == NULL)
+    if (B_t_B_w == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
 
-    MKL_Complex16 aux = {B_S[0].real, B_S[0].imag};
+    double start = profile_begin(OPSD_STAGE_C_FFT_BORDER);
+
+    transpose_shape(layout, &rows, &columns);
 
-    double *v1 = (double *)malloc(rows * sizeof(double));
-    double *v2 = (double *)malloc(columns * sizeof(double));
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    float *border = (float *)B_t_B_w;
+    size_t ld = 2 * (columns / 2 + 1);
 
-    for (int i = 0; i < rows; i++)
+    size_t mark = scratch_mark(plan);
+    MKL_Complex8 *R = scratch_alloc(plan, columns * sizeof(MKL_Complex8));
+    MKL_Complex8 *C = scratch_alloc(plan, rows * sizeof(MKL_Complex8));
+
+    // Same edge split as compute_cfft2d_of_border_B, read from the padded rows
+    for (size_t i = 0; i < rows; i++)
     {
-        v1[i] = (2.0 * PI * i) / rows;
+        C[i].real = border[i * ld];
+        C[i].imag = 0.0f;
     }
-    
-    for (int i = 0; i < columns; i++)
+
+    for (size_t j = 0; j < columns; j++)
     {
-        v2[i] = (2.0 * PI * (i)) / columns;
+        R[j].real = border[j];
+        R[j].imag = 0.0f;
     }
+    R[0].real = 0.0f;
+    R[columns - 1].real += C[0].real;
 
-    double *cos_1 = (double *)malloc(rows * sizeof(double));
-    double *cos_2 = (double *)malloc(columns * sizeof(double));
-    vdCos(rows, v1, cos_1);
-    vdCos(columns, v2, cos_2);
-    cblas_dscal(rows, 2.0, cos_1, 1);
-    cblas_dscal(columns, 2.0, cos_2, 1);
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    build_cborder_spectrum(B_t_B_w, R, C, columns / 2 + 1, plan);
+
+    scratch_release(plan, mark);
+    profile_end(OPSD_STAGE_C_FFT_BORDER, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+}
 
-    for (int i = 0; i < rows; i++)
+void compute_csmooth_component_S_real(MKL_Complex8 *B_S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (B_S == NULL)
     {
-        for (int j = 0; j < columns; j++)
-        {
-            float denom = cos_1[i] + cos_2[j] - 4.0;
-            B_S[i + j * rows].real /= denom;
-            B_S[i + j * rows].imag /= denom;
-        }
+        printf("Matrix not found!\n");
+        return;
     }
 
-    B_S[0].real = aux.real;
-    B_S[0].imag = aux.imag;
+    double start = profile_begin(OPSD_STAGE_D_SMOOTH);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    size_t half = columns / 2 + 1;
+    apply_csmooth(B_S, (float *)plan->denom_rows, rows, (float *)plan->denom_columns, half, half);
+    profile_end(OPSD_STAGE_D_SMOOTH, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
 }
 
-void compute_zperiodic_component_P(MKL_Complex16 *I_w, MKL_Complex16 *S, size_t rows, size_t columns)
+void compute_cperiodic_component_P_real(MKL_Complex8 *I_w, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout)
 {
     if (I_w == NULL || S == NULL)
     {
         printf("Matrix not found!\n");
         return;
     }
-    
-    vzSub(rows * columns, I_w, S, I_w);
+
+    double start = profile_begin(OPSD_STAGE_E_PERIODIC);
+
+    transpose_shape(layout, &rows, &columns);
+
+    vcSub(rows * (columns / 2 + 1), I_w, S, I_w);
+    profile_end(OPSD_STAGE_E_PERIODIC, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+}
+
+// A modulated I_t (even row count, odd rows negated) has x(last, j) =
+// -I_t(last, j) and x(i, j) = (-1)^i I_t(i, j)
+static void border_cedges_real(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout, int modulated)
+{
+    if (I_t == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_B_EDGES);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex8 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    float *image = (float *)I_t;
+    size_t ld = 2 * (columns / 2 + 1);
+
+    float last = modulated ? -1 : 1;
+    for (size_t j = 0; j < columns; j++)
+    {
+        R[j].real = last * image[j + (rows - 1) * ld] - image[j];
+        R[j].imag = 0.0f;
+    }
+
+    for (size_t i = 0; i < rows; i++)
+    {
+        float sign = modulated && i % 2 != 0 ? -1 : 1;
+        C[i].real = sign * (image[columns - 1 + i * ld] - image[i * ld]);
+        C[i].imag = 0.0f;
+    }
+
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    profile_end(OPSD_STAGE_B_EDGES, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+}
+
+void compute_cborder_edges_real(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout)
+{
+    border_cedges_real(I_t, R, C, rows, columns, layout, 0);
+}
+
+void compute_cborder_edges_real_modulated(MKL_Complex8 *I_t, MKL_Complex8 *R, MKL_Complex8 *C, size_t rows, size_t columns, opsd_layout layout)
+{
+    border_cedges_real(I_t, R, C, rows, columns, layout, 1);
+}
+
+void compute_cperiodic_component_P_fused_real(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex8 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    apply_cperiodic_fused(I_w, S, R, C, columns / 2 + 1, 0, 0, plan);
+    profile_end(OPSD_STAGE_CDE_FUSED, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+}
+
+// Only the row axis of a CCE spectrum can be centered: its columns already are
+// the non-negative frequencies 0..columns/2.
+void compute_cfftshift_real(MKL_Complex8 *in, MKL_Complex8 *out, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (in == NULL || out == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_FFTSHIFT);
+
+    transpose_shape(layout, &rows, &columns);
+
+    rotate_crows(in, out, rows, columns / 2 + 1, rows / 2, 0);
+    profile_end(OPSD_STAGE_FFTSHIFT, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+}
+
+// Real-input Step A with centered rows, I_t being lost. Even row counts negate
+// the odd rows of the padded image before the R2C, unless its loader already
+// did; odd ones rotate the rows of the spectrum into work (unused otherwise,
+// may be NULL). Returns the buffer holding the centered spectrum.
+static MKL_Complex8 *fft2d_cshifted_real(MKL_Complex8 *I_t, MKL_Complex8 *work, size_t rows, size_t columns, opsd_layout layout, int modulated)
+{
+    transpose_shape(layout, &rows, &columns);
+
+    size_t half = columns / 2 + 1;
+    if (I_t == NULL || (rows % 2 != 0 && work == NULL))
+    {
+        printf("Matrix not found!\n");
+        return NULL;
+    }
+
+    double start = profile_begin(OPSD_STAGE_A_FFT2D_SHIFTED);
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+
+    if (rows % 2 == 0)
+    {
+        float *image = (float *)I_t;
+
+        if (!modulated)
+        {
+#pragma omp parallel
+            {
+                double chunk = trace_begin();
+#pragma omp for nowait
+                for (size_t i = 1; i < rows; i += 2)
+                {
+                    for (size_t j = 0; j < 2 * half; j++)
+                        image[j + i * 2 * half] = -image[j + i * 2 * half];
+                }
+                trace_end("compute_cfft2d_real_shifted", "omp", chunk);
+            }
+        }
+
+        trace_forward(plan->fft2d, I_t, "fft2d");
+        profile_end(OPSD_STAGE_A_FFT2D_SHIFTED, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+        return I_t;
+    }
+
+    trace_forward(plan->fft2d, I_t, "fft2d");
+    rotate_crows(I_t, work, rows, half, rows / 2, 0);
+    profile_end(OPSD_STAGE_A_FFT2D_SHIFTED, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+    return work;
+}
+
+MKL_Complex8 *compute_cfft2d_real_shifted(MKL_Complex8 *I_t, MKL_Complex8 *work, size_t rows, size_t columns, opsd_layout layout)
+{
+    return fft2d_cshifted_real(I_t, work, rows, columns, layout, 0);
+}
+
+// Real-input Step A centered for an even row count its loader modulated (see
+// pad_fvector_rows_modulated)
+void compute_cfft2d_real_modulated(MKL_Complex8 *I_t, size_t rows, size_t columns, opsd_layout layout)
+{
+    fft2d_cshifted_real(I_t, NULL, rows, columns, layout, 1);
+}
+
+void compute_cperiodic_component_P_fused_real_shifted(MKL_Complex8 *I_w, MKL_Complex8 *R, MKL_Complex8 *C, MKL_Complex8 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED_SHIFTED);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex8 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_SINGLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    apply_cperiodic_fused(I_w, S, R, C, columns / 2 + 1, rows / 2, 0, plan);
+    profile_end(OPSD_STAGE_CDE_FUSED_SHIFTED, start, OPSD_SINGLE, OPSD_REAL, rows, columns, 1);
+}
+
+//ZVECTOR FFT FUNCTIONS
+
+static void rotate_zrows(MKL_Complex16 *in, MKL_Complex16 *out, size_t rows, size_t width, size_t row_shift, size_t column_shift)
+{
+#pragma omp parallel
+    {
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t k = 0; k < rows; k++)
+        {
+            MKL_Complex16 *source = &in[((k + rows - row_shift) % rows) * width];
+            MKL_Complex16 *target = &out[k * width];
+
+            memcpy(target, source + width - column_shift, column_shift * sizeof(MKL_Complex16));
+            memcpy(target + column_shift, source, (width - column_shift) * sizeof(MKL_Complex16));
+        }
+        trace_end("rotate_zrows", "omp", chunk);
+    }
+}
+
+static void modulate_zrows(MKL_Complex16 *vector, size_t rows, size_t columns)
+{
+#pragma omp parallel
+    {
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t i = 0; i < rows; i++)
+        {
+            MKL_Complex16 *row = &vector[i * columns];
+            for (size_t j = (i + 1) % 2; j < columns; j += 2)
+            {
+                row[j].real = -row[j].real;
+                row[j].imag = -row[j].imag;
+            }
+        }
+        trace_end("modulate_zrows", "omp", chunk);
+    }
+}
+
+void compute_zfft2d(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    trace_forward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+void compute_zifft2d(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_IFFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_BACKWARD);
+    trace_backward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_IFFT2D, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+void compute_zfft2d_batch(MKL_Complex16 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_batch_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD, count);
+    trace_forward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, count);
+}
+
+void compute_zifft2d_batch(MKL_Complex16 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_IFFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_batch_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_BACKWARD, count);
+    trace_backward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_IFFT2D, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, count);
+}
+
+void compute_zfft2d_column_row(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    trace_forward(plan->fft_columns, I_t_I_w, "fft_columns");
+    trace_forward(plan->fft_rows, I_t_I_w, "fft_rows");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+void compute_zperiodic_border_B(MKL_Complex16 *I_t, MKL_Complex16 *B_t, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t == NULL || B_t == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_B_BORDER);
+
+    transpose_shape(layout, &rows, &columns);
+
+    B_t[0].real = I_t[columns - 1].real - 2 * I_t[0].real + I_t[(rows - 1) * columns].real;
+    B_t[0].imag = I_t[columns - 1].imag - 2 * I_t[0].imag + I_t[(rows - 1) * columns].imag;
+
+    B_t[columns - 1].real = I_t[0].real - 2 * I_t[columns - 1].real + I_t[rows * columns - 1].real;
+    B_t[columns - 1].imag = I_t[0].imag - 2 * I_t[columns - 1].imag + I_t[rows * columns - 1].imag;
+
+    B_t[(rows - 1) * columns].real = I_t[0].real - 2 * I_t[(rows - 1) * columns].real + I_t[rows * columns - 1].real;
+    B_t[(rows - 1) * columns].imag = I_t[0].imag - 2 * I_t[(rows - 1) * columns].imag + I_t[rows * columns - 1].imag;
+
+    B_t[rows * columns - 1].real = I_t[columns - 1].real - 2 * I_t[rows * columns - 1].real + I_t[(rows - 1) * columns].real;
+    B_t[rows * columns - 1].imag = I_t[columns - 1].imag - 2 * I_t[rows * columns - 1].imag + I_t[(rows - 1) * columns].imag;
+
+    // linha 0 e rows-1
+    for (int j = 1; j < columns - 1; j++)
+    {
+        B_t[j].real = I_t[j + (rows - 1) * columns].real - I_t[j].real;
+        B_t[j].imag = I_t[j + (rows - 1) * columns].imag - I_t[j].imag;
+
+        B_t[j + (rows - 1) * columns].real = B_t[j].real * (-1);
+        B_t[j + (rows - 1) * columns].imag = B_t[j].imag * (-1);
+    }
+
+    // coluna 0 e columns-1
+    for (int i = 1; i < rows - 1; i++)
+    {
+        B_t[i * columns].real = I_t[columns - 1 + i * columns].real - I_t[i * columns].real;
+        B_t[i * columns].imag = I_t[columns - 1 + i * columns].imag - I_t[i * columns].imag;
+
+        B_t[columns - 1 + i * columns].real = B_t[i * columns].real * (-1);
+        B_t[columns - 1 + i * columns].imag = B_t[i * columns].imag * (-1);
+    }
+    profile_end(OPSD_STAGE_B_BORDER, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+static void build_zborder_spectrum(MKL_Complex16 *B_w, MKL_Complex16 *R, MKL_Complex16 *C, size_t width, opsd_plan *plan)
+{
+    MKL_Complex16 *v_rows = (MKL_Complex16 *)plan->v_rows;
+    MKL_Complex16 *v_columns = (MKL_Complex16 *)plan->v_columns;
+
+#pragma omp parallel
+    {
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t k = 0; k < plan->rows; k++)
+        {
+            MKL_Complex16 vk = v_rows[k], ck = C[k];
+            MKL_Complex16 *row = &B_w[k * width];
+
+            for (size_t l = 0; l < width; l++)
+            {
+                row[l].real = vk.real * R[l].real - vk.imag * R[l].imag + ck.real * v_columns[l].real - ck.imag * v_columns[l].imag;
+                row[l].imag = vk.real * R[l].imag + vk.imag * R[l].real + ck.real * v_columns[l].imag + ck.imag * v_columns[l].real;
+            }
+        }
+        trace_end("build_zborder_spectrum", "omp", chunk);
+    }
+}
+
+void compute_zfft2d_of_border_B(MKL_Complex16 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (B_t_B_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_C_FFT_BORDER);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+
+    size_t mark = scratch_mark(plan);
+    MKL_Complex16 *R = scratch_alloc(plan, columns * sizeof(MKL_Complex16));
+    MKL_Complex16 *C = scratch_alloc(plan, rows * sizeof(MKL_Complex16));
+
+    for (size_t i = 0; i < rows; i++)
+        C[i] = B_t_B_w[i * columns];
+
+    for (size_t j = 0; j < columns; j++)
+        R[j] = B_t_B_w[j];
+    R[0].real = 0.0;
+    R[0].imag = 0.0;
+    R[columns - 1].real += C[0].real;
+    R[columns - 1].imag += C[0].imag;
+
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    build_zborder_spectrum(B_t_B_w, R, C, columns, plan);
+
+    scratch_release(plan, mark);
+    profile_end(OPSD_STAGE_C_FFT_BORDER, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+void compute_zfft2d_of_border_B_batch(MKL_Complex16 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (B_t_B_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_C_FFT_BORDER);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    MKL_Complex16 *v = (MKL_Complex16 *)plan->v_rows;
+
+    // Column-one FFT
+    MKL_Complex16 a = {B_t_B_w[0].real + B_t_B_w[columns - 1].real, B_t_B_w[0].imag + B_t_B_w[columns - 1].imag};
+
+    trace_forward(plan->fft_column, B_t_B_w, "fft_column");
+
+    cblas_zcopy(rows, B_t_B_w, columns, &B_t_B_w[columns - 1], columns);
+    cblas_zdscal(rows, -1.0, &B_t_B_w[columns - 1], columns);
+    cblas_zaxpy(rows, &a, v, 1, &B_t_B_w[columns - 1], columns);
+
+    for (int j = 1; j < columns - 1; j++)
+    {
+        a.real = B_t_B_w[j].real;
+        a.imag = B_t_B_w[j].imag;
+        cblas_zcopy(rows, v, 1, &B_t_B_w[j], columns);
+        cblas_zscal(rows, &a, &B_t_B_w[j], columns);
+    }
+
+    // Row-by-Row FFT
+    trace_forward(plan->fft_rows, B_t_B_w, "fft_rows");
+    profile_end(OPSD_STAGE_C_FFT_BORDER, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+static void apply_zsmooth(MKL_Complex16 *B_S, const double *denom_outer, size_t outer, const double *denom_inner, size_t inner, size_t width)
+{
+    MKL_Complex16 aux = {B_S[0].real, B_S[0].imag};
+
+#pragma omp parallel
+    {
+        double chunk = trace_begin();
+#pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < outer; i++)
+        {
+            double d = denom_outer[i];
+            double *line = (double *)&B_S[i * width];
+
+#pragma omp simd
+            for (size_t j = 0; j < inner; j++)
+            {
+                double r = 1.0 / (d + denom_inner[j]);
+                line[2 * j] *= r;
+                line[2 * j + 1] *= r;
+            }
+        }
+        trace_end("apply_zsmooth", "omp", chunk);
+    }
+
+    B_S[0].real = aux.real;
+    B_S[0].imag = aux.imag;
+}
+
+void compute_zsmooth_component_S(MKL_Complex16 *B_S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (B_S == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_D_SMOOTH);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    apply_zsmooth(B_S, (double *)plan->denom_rows, rows, (double *)plan->denom_columns, columns, columns);
+    profile_end(OPSD_STAGE_D_SMOOTH, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+void compute_zperiodic_component_P(MKL_Complex16 *I_w, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || S == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_E_PERIODIC);
+
+    transpose_shape(layout, &rows, &columns);
+
+    vzSub(rows * columns, I_w, S, I_w);
+    profile_end(OPSD_STAGE_E_PERIODIC, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+static inline void fused_zrow(MKL_Complex16 *I_row, MKL_Complex16 *S_row, MKL_Complex16 vk, MKL_Complex16 ck, double dk,
+                              const MKL_Complex16 *R, const MKL_Complex16 *v_columns, const double *denom_columns, size_t count)
+{
+    if (S_row == NULL)
+    {
+#pragma omp simd
+        for (size_t l = 0; l < count; l++)
+        {
+            double r = 1.0 / (dk + denom_columns[l]);
+            I_row[l].real -= (vk.real * R[l].real - vk.imag * R[l].imag + ck.real * v_columns[l].real - ck.imag * v_columns[l].imag) * r;
+            I_row[l].imag -= (vk.real * R[l].imag + vk.imag * R[l].real + ck.real * v_columns[l].imag + ck.imag * v_columns[l].real) * r;
+        }
+    }
+    else
+    {
+#pragma omp simd
+        for (size_t l = 0; l < count; l++)
+        {
+            double r = 1.0 / (dk + denom_columns[l]);
+            S_row[l].real = (vk.real * R[l].real - vk.imag * R[l].imag + ck.real * v_columns[l].real - ck.imag * v_columns[l].imag) * r;
+            S_row[l].imag = (vk.real * R[l].imag + vk.imag * R[l].real + ck.real * v_columns[l].imag + ck.imag * v_columns[l].real) * r;
+            I_row[l].real -= S_row[l].real;
+            I_row[l].imag -= S_row[l].imag;
+        }
+    }
+}
+
+static void apply_zperiodic_fused(MKL_Complex16 *I_w, MKL_Complex16 *S, MKL_Complex16 *R, MKL_Complex16 *C, size_t width,
+                                  size_t row_shift, size_t column_shift, opsd_plan *plan)
+{
+    MKL_Complex16 *v_rows = (MKL_Complex16 *)plan->v_rows;
+    MKL_Complex16 *v_columns = (MKL_Complex16 *)plan->v_columns;
+    double *denom_rows = (double *)plan->denom_rows;
+    double *denom_columns = (double *)plan->denom_columns;
+    size_t rows = plan->rows, tail = plan->columns - column_shift;
+
+    // B_w(0, 0) = 0 and its denominator is 0: keep I_w(0, 0), as Step D does
+    size_t zero = row_shift * width + column_shift;
+    MKL_Complex16 aux = {I_w[zero].real, I_w[zero].imag};
+
+#pragma omp parallel
+    {
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t k = 0; k < rows; k++)
+        {
+            size_t source = (k + rows - row_shift) % rows;
+            MKL_Complex16 vk = v_rows[source], ck = C[source];
+            double dk = denom_rows[source];
+            MKL_Complex16 *I_row = &I_w[k * width];
+            MKL_Complex16 *S_row = S != NULL ? &S[k * width] : NULL;
+
+            // Columns [0, column_shift) hold the negative frequencies
+            fused_zrow(I_row, S_row, vk, ck, dk, R + tail, v_columns + tail, denom_columns + tail, column_shift);
+            fused_zrow(I_row + column_shift, S_row != NULL ? S_row + column_shift : NULL, vk, ck, dk, R, v_columns, denom_columns,
+                       width - column_shift);
+        }
+        trace_end("apply_zperiodic_fused", "omp", chunk);
+    }
+
+    I_w[zero].real = aux.real;
+    I_w[zero].imag = aux.imag;
+    if (S != NULL)
+    {
+        S[zero].real = 0.0;
+        S[zero].imag = 0.0;
+    }
+}
+
+static void border_zedges(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout, int modulated)
+{
+    if (I_t == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_B_EDGES);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex16 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+
+    if (modulated)
+    {
+        for (size_t j = 0; j < columns; j++)
+        {
+            double sign = j % 2 == 0 ? -1 : 1;
+            R[j].real = sign * (I_t[j + (rows - 1) * columns].real + I_t[j].real);
+            R[j].imag = sign * (I_t[j + (rows - 1) * columns].imag + I_t[j].imag);
+        }
+
+        for (size_t i = 0; i < rows; i++)
+        {
+            double sign = i % 2 == 0 ? -1 : 1;
+            C[i].real = sign * (I_t[columns - 1 + i * columns].real + I_t[i * columns].real);
+            C[i].imag = sign * (I_t[columns - 1 + i * columns].imag + I_t[i * columns].imag);
+        }
+    }
+    else
+    {
+        for (size_t j = 0; j < columns; j++)
+        {
+            R[j].real = I_t[j + (rows - 1) * columns].real - I_t[j].real;
+            R[j].imag = I_t[j + (rows - 1) * columns].imag - I_t[j].imag;
+        }
+
+        for (size_t i = 0; i < rows; i++)
+        {
+            C[i].real = I_t[columns - 1 + i * columns].real - I_t[i * columns].real;
+            C[i].imag = I_t[columns - 1 + i * columns].imag - I_t[i * columns].imag;
+        }
+    }
+
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    profile_end(OPSD_STAGE_B_EDGES, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+void compute_zborder_edges(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout)
+{
+    border_zedges(I_t, R, C, rows, columns, layout, 0);
+}
+
+void compute_zborder_edges_modulated(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout)
+{
+    border_zedges(I_t, R, C, rows, columns, layout, 1);
+}
+
+void compute_zperiodic_component_P_fused(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex16 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    apply_zperiodic_fused(I_w, S, R, C, columns, 0, 0, plan);
+    profile_end(OPSD_STAGE_CDE_FUSED, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+void compute_zfftshift(MKL_Complex16 *in, MKL_Complex16 *out, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (in == NULL || out == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_FFTSHIFT);
+
+    transpose_shape(layout, &rows, &columns);
+
+    rotate_zrows(in, out, rows, columns, rows / 2, columns / 2);
+    profile_end(OPSD_STAGE_FFTSHIFT, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+static MKL_Complex16 *fft2d_zshifted(MKL_Complex16 *I_t, MKL_Complex16 *work, size_t rows, size_t columns, opsd_layout layout, int modulated)
+{
+    transpose_shape(layout, &rows, &columns);
+
+    int even = rows % 2 == 0 && columns % 2 == 0;
+    if (I_t == NULL || (!even && work == NULL))
+    {
+        printf("Matrix not found!\n");
+        return NULL;
+    }
+
+    double start = profile_begin(OPSD_STAGE_A_FFT2D_SHIFTED);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+
+    if (even)
+    {
+        if (!modulated)
+            modulate_zrows(I_t, rows, columns);
+        trace_forward(plan->fft2d, I_t, "fft2d");
+        profile_end(OPSD_STAGE_A_FFT2D_SHIFTED, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+        return I_t;
+    }
+
+    trace_forward(plan->fft2d, I_t, "fft2d");
+    rotate_zrows(I_t, work, rows, columns, rows / 2, columns / 2);
+    profile_end(OPSD_STAGE_A_FFT2D_SHIFTED, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+    return work;
+}
+
+MKL_Complex16 *compute_zfft2d_shifted(MKL_Complex16 *I_t, MKL_Complex16 *work, size_t rows, size_t columns, opsd_layout layout)
+{
+    return fft2d_zshifted(I_t, work, rows, columns, layout, 0);
+}
+
+void compute_zfft2d_modulated(MKL_Complex16 *I_t, size_t rows, size_t columns, opsd_layout layout)
+{
+    fft2d_zshifted(I_t, NULL, rows, columns, layout, 1);
+}
+
+void compute_zperiodic_component_P_fused_shifted(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED_SHIFTED);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex16 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, OPSD_FORWARD);
+    apply_zperiodic_fused(I_w, S, R, C, columns, rows / 2, columns / 2, plan);
+    profile_end(OPSD_STAGE_CDE_FUSED_SHIFTED, start, OPSD_DOUBLE, OPSD_COMPLEX, rows, columns, 1);
+}
+
+// Step B from edge differences gathered elsewhere: R holds the last row of the
+// image minus the first, C its last column minus the first, as
+// compute_zborder_edges builds them. Both are transformed in place. The
+// out-of-core path collects them while streaming the image.
+void compute_zedge_spectra(MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_domain domain)
+{
+    if (R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_B_EDGES);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, domain, rows, columns, OPSD_FORWARD);
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    profile_end(OPSD_STAGE_B_EDGES, start, OPSD_DOUBLE, domain, rows, columns, 1);
+}
+
+// Steps C-E on columns [first, first + count) of the row-major rows x columns
+// spectrum (rows x (columns / 2 + 1) for real input), stored transposed: slab
+// column l holds I_w(., first + l) in rows contiguous elements. fused_zrow runs
+// down each column with the row and column tables swapped, which gives the
+// same S since B_w(k, l) is symmetric in its two axes.
+void compute_zperiodic_component_P_fused_columns(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns,
+                                                 size_t first, size_t count, opsd_domain domain)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, domain, rows, columns, OPSD_FORWARD);
+    MKL_Complex16 *v_rows = (MKL_Complex16 *)plan->v_rows;
+    MKL_Complex16 *v_columns = (MKL_Complex16 *)plan->v_columns;
+    double *denom_rows = (double *)plan->denom_rows;
+    double *denom_columns = (double *)plan->denom_columns;
+
+    // B_w(0, 0) = 0 and its denominator is 0: keep I_w(0, 0), as Step D does
+    MKL_Complex16 aux = {I_w[0].real, I_w[0].imag};
+
+#pragma omp parallel
+    {
+        double chunk = trace_begin();
+#pragma omp for nowait
+        for (size_t l = 0; l < count; l++)
+        {
+            size_t j = first + l;
+            fused_zrow(&I_w[l * rows], S != NULL ? &S[l * rows] : NULL, v_columns[j], R[j], denom_columns[j], C, v_rows, denom_rows,
+                       rows);
+        }
+        trace_end("compute_zperiodic_component_P_fused_columns", "omp", chunk);
+    }
+
+    if (first == 0)
+    {
+        I_w[0].real = aux.real;
+        I_w[0].imag = aux.imag;
+        if (S != NULL)
+        {
+            S[0].real = 0.0;
+            S[0].imag = 0.0;
+        }
+    }
+    profile_end(OPSD_STAGE_CDE_FUSED, start, OPSD_DOUBLE, OPSD_COMPLEX, count, rows, 1);
+}
+
+//REAL INPUT (CCE) FUNCTIONS
+// Real images are stored in rows padded to 2 * (columns / 2 + 1) doubles, so the
+// in-place R2C leaves the rows x (columns / 2 + 1) non-redundant spectrum in
+// the same buffer.
+
+void compute_zfft2d_real(MKL_Complex16 *I_t_I_w, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    trace_forward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+}
+
+void compute_zifft2d_real(MKL_Complex16 *I_w_I_t, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w_I_t == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_IFFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_BACKWARD);
+    trace_backward(plan->fft2d, I_w_I_t, "fft2d");
+    profile_end(OPSD_STAGE_IFFT2D, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+}
+
+void compute_zfft2d_real_batch(MKL_Complex16 *I_t_I_w, size_t count, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t_I_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_A_FFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_batch_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_FORWARD, count);
+    trace_forward(plan->fft2d, I_t_I_w, "fft2d");
+    profile_end(OPSD_STAGE_A_FFT2D, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, count);
+}
+
+void compute_zifft2d_real_batch(MKL_Complex16 *I_w_I_t, size_t count, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w_I_t == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_IFFT2D);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_batch_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_BACKWARD, count);
+    trace_backward(plan->fft2d, I_w_I_t, "fft2d");
+    profile_end(OPSD_STAGE_IFFT2D, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, count);
+}
+
+void compute_zperiodic_border_B_real(MKL_Complex16 *I_t, MKL_Complex16 *B_t, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_t == NULL || B_t == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_B_BORDER);
+
+    transpose_shape(layout, &rows, &columns);
+
+    double *image = (double *)I_t;
+    double *border = (double *)B_t;
+    size_t ld = 2 * (columns / 2 + 1);
+
+    // linha 0 e rows-1
+    for (size_t j = 0; j < columns; j++)
+    {
+        border[j] = image[j + (rows - 1) * ld] - image[j];
+        border[j + (rows - 1) * ld] = border[j] * (-1);
+    }
+
+    // coluna 0 e columns-1
+    for (size_t i = 0; i < rows; i++)
+    {
+        double d = image[columns - 1 + i * ld] - image[i * ld];
+        if (i == 0 || i == rows - 1)
+        {
+            border[i * ld] += d;
+            border[columns - 1 + i * ld] -= d;
+        }
+        else
+        {
+            border[i * ld] = d;
+            border[columns - 1 + i * ld] = d * (-1);
+        }
+    }
+    profile_end(OPSD_STAGE_B_BORDER, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+}
+
+void compute_zfft2d_of_border_B_real(MKL_Complex16 *B_t_B_w, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (B_t_B_w == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_C_FFT_BORDER);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    double *border = (double *)B_t_B_w;
+    size_t ld = 2 * (columns / 2 + 1);
+
+    size_t mark = scratch_mark(plan);
+    MKL_Complex16 *R = scratch_alloc(plan, columns * sizeof(MKL_Complex16));
+    MKL_Complex16 *C = scratch_alloc(plan, rows * sizeof(MKL_Complex16));
+
+    for (size_t i = 0; i < rows; i++)
+    {
+        C[i].real = border[i * ld];
+        C[i].imag = 0.0;
+    }
+
+    for (size_t j = 0; j < columns; j++)
+    {
+        R[j].real = border[j];
+        R[j].imag = 0.0;
+    }
+    R[0].real = 0.0;
+    R[columns - 1].real += C[0].real;
+
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    build_zborder_spectrum(B_t_B_w, R, C, columns / 2 + 1, plan);
+
+    scratch_release(plan, mark);
+    profile_end(OPSD_STAGE_C_FFT_BORDER, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+}
+
+void compute_zsmooth_component_S_real(MKL_Complex16 *B_S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (B_S == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_D_SMOOTH);
+
+    transpose_shape(layout, &rows, &columns);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    size_t half = columns / 2 + 1;
+    apply_zsmooth(B_S, (double *)plan->denom_rows, rows, (double *)plan->denom_columns, half, half);
+    profile_end(OPSD_STAGE_D_SMOOTH, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+}
+
+void compute_zperiodic_component_P_real(MKL_Complex16 *I_w, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || S == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_E_PERIODIC);
+
+    transpose_shape(layout, &rows, &columns);
+
+    vzSub(rows * (columns / 2 + 1), I_w, S, I_w);
+    profile_end(OPSD_STAGE_E_PERIODIC, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+}
+
+static void border_zedges_real(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout, int modulated)
+{
+    if (I_t == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_B_EDGES);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex16 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    double *image = (double *)I_t;
+    size_t ld = 2 * (columns / 2 + 1);
+
+    double last = modulated ? -1 : 1;
+    for (size_t j = 0; j < columns; j++)
+    {
+        R[j].real = last * image[j + (rows - 1) * ld] - image[j];
+        R[j].imag = 0.0;
+    }
+
+    for (size_t i = 0; i < rows; i++)
+    {
+        double sign = modulated && i % 2 != 0 ? -1 : 1;
+        C[i].real = sign * (image[columns - 1 + i * ld] - image[i * ld]);
+        C[i].imag = 0.0;
+    }
+
+    trace_forward(plan->fft_edge_row, R, "fft_edge_row");
+    trace_forward(plan->fft_edge_column, C, "fft_edge_column");
+    profile_end(OPSD_STAGE_B_EDGES, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+}
+
+void compute_zborder_edges_real(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout)
+{
+    border_zedges_real(I_t, R, C, rows, columns, layout, 0);
+}
+
+void compute_zborder_edges_real_modulated(MKL_Complex16 *I_t, MKL_Complex16 *R, MKL_Complex16 *C, size_t rows, size_t columns, opsd_layout layout)
+{
+    border_zedges_real(I_t, R, C, rows, columns, layout, 1);
+}
+
+void compute_zperiodic_component_P_fused_real(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex16 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    apply_zperiodic_fused(I_w, S, R, C, columns / 2 + 1, 0, 0, plan);
+    profile_end(OPSD_STAGE_CDE_FUSED, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+}
+
+void compute_zfftshift_real(MKL_Complex16 *in, MKL_Complex16 *out, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (in == NULL || out == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_FFTSHIFT);
+
+    transpose_shape(layout, &rows, &columns);
+
+    rotate_zrows(in, out, rows, columns / 2 + 1, rows / 2, 0);
+    profile_end(OPSD_STAGE_FFTSHIFT, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+}
+
+static MKL_Complex16 *fft2d_zshifted_real(MKL_Complex16 *I_t, MKL_Complex16 *work, size_t rows, size_t columns, opsd_layout layout, int modulated)
+{
+    transpose_shape(layout, &rows, &columns);
+
+    size_t half = columns / 2 + 1;
+    if (I_t == NULL || (rows % 2 != 0 && work == NULL))
+    {
+        printf("Matrix not found!\n");
+        return NULL;
+    }
+
+    double start = profile_begin(OPSD_STAGE_A_FFT2D_SHIFTED);
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+
+    if (rows % 2 == 0)
+    {
+        double *image = (double *)I_t;
+
+        if (!modulated)
+        {
+#pragma omp parallel
+            {
+                double chunk = trace_begin();
+#pragma omp for nowait
+                for (size_t i = 1; i < rows; i += 2)
+                {
+                    for (size_t j = 0; j < 2 * half; j++)
+                        image[j + i * 2 * half] = -image[j + i * 2 * half];
+                }
+                trace_end("compute_zfft2d_real_shifted", "omp", chunk);
+            }
+        }
+
+        trace_forward(plan->fft2d, I_t, "fft2d");
+        profile_end(OPSD_STAGE_A_FFT2D_SHIFTED, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+        return I_t;
+    }
+
+    trace_forward(plan->fft2d, I_t, "fft2d");
+    rotate_zrows(I_t, work, rows, half, rows / 2, 0);
+    profile_end(OPSD_STAGE_A_FFT2D_SHIFTED, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
+    return work;
+}
+
+MKL_Complex16 *compute_zfft2d_real_shifted(MKL_Complex16 *I_t, MKL_Complex16 *work, size_t rows, size_t columns, opsd_layout layout)
+{
+    return fft2d_zshifted_real(I_t, work, rows, columns, layout, 0);
+}
+
+void compute_zfft2d_real_modulated(MKL_Complex16 *I_t, size_t rows, size_t columns, opsd_layout layout)
+{
+    fft2d_zshifted_real(I_t, NULL, rows, columns, layout, 1);
+}
+
+void compute_zperiodic_component_P_fused_real_shifted(MKL_Complex16 *I_w, MKL_Complex16 *R, MKL_Complex16 *C, MKL_Complex16 *S, size_t rows, size_t columns, opsd_layout layout)
+{
+    if (I_w == NULL || R == NULL || C == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    double start = profile_begin(OPSD_STAGE_CDE_FUSED_SHIFTED);
+
+    if (transpose_shape(layout, &rows, &columns))
+    {
+        MKL_Complex16 *aux = R;
+        R = C;
+        C = aux;
+    }
+
+    opsd_plan *plan = get_plan(OPSD_DOUBLE, OPSD_REAL, rows, columns, OPSD_FORWARD);
+    apply_zperiodic_fused(I_w, S, R, C, columns / 2 + 1, rows / 2, 0, plan);
+    profile_end(OPSD_STAGE_CDE_FUSED_SHIFTED, start, OPSD_DOUBLE, OPSD_REAL, rows, columns, 1);
 }
 
-void compute_zfftshift(MKL_Complex16 *vector, size_t rows, size_t columns) {
-    size_t half_rows = rows / 2;
-    size_t half_columns = columns / 2;
-    
-    // Troca os quadrantes (1,4) e (2,3)
-    for (size_t i = 0; i < half_rows; i++) {
-        for (size_t j = 0; j < half_columns; j++) {
-            // Índices dos elementos a serem trocados
-            size_t index1 = i * columns + j;
-            size_t index2 = (i + half_rows) * columns + (j + half_columns);
-            size_t index3 = i * columns + (j + half_columns);
-            size_t index4 = (i + half_rows) * columns + j;
-
-            // Swap (1,4)
-            MKL_Complex16 temp = vector[index1];
-            vector[index1] = vector[index2];
-            vector[index2] = temp;
-            
-            // Swap (2,3)
-            temp = vector[index3];
-            vector[index3] = vector[index4];
-            vector[index4] = temp;
-        }
-    }
-}
\ No newline at end of file
@@ -1,370 +1,182 @@
 #include "../include/utils.h"
 #include "../include/fourier.h"
+#include "../include/pipeline.h"
+#include "../include/batch.h"
+#include "../include/stream.h"
+#include "../include/server.h"
+#include "../include/planner.h"
+#include "../include/outofcore.h"
 
 int main(int argc, char const *argv[])
 {
-    if (argc != 9)
+    if (argc == 3 && !strcmp(argv[1], "--serve"))
     {
-        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed>\n", argv[0]);
+        int err_code = run_server(argv[2]);
+        destroy_plans();
+        return err_code;
+    }
+
+    if (argc < 9)
+    {
+        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed> [layout] [--mmap] [--batch] [--stream] [--connect <socket>] [--profile] [--trace <file>] [--counters] [--out-of-core] [--dry-run [--machine <csv>]] [--budget <GB>]\n", argv[0]);
+        printf("     %s --serve <socket>\n", argv[0]);
         return -1;
     }
 
-    size_t rows = atoi(argv[1]), columns = atoi(argv[2]), size = rows * columns;
+    size_t rows = atoi(argv[1]), columns = atoi(argv[2]);
     const char *ROUTINE = argv[3], *PRECISION = argv[4], *SAVE_VECTORS = argv[5], *INPUT = argv[6], *DIR = argv[7];
     int seed = atoi(argv[8]);
 
-    int err_code = check_args(argv[0], ROUTINE, PRECISION, SAVE_VECTORS, INPUT);
-    if (err_code)
-        return err_code;
-
-    char filepath[1024];
-   
-    snprintf(filepath, sizeof(filepath), "../bin/%s", DIR);
-
-    ensure_directory_exists(filepath);
-
-    if (!strcmp(ROUTINE, "ccr"))
+    // data.bin holds row-major images by default; "column" reads column-major traces.
+    // --mmap maps data.bin and the product files instead of staging them in buffers;
+    // --batch makes <directory> a batch source (directory, .txt list or stack file);
+    // --stream filters frames from stdin to stdout, ignoring <input> and <directory>;
+    // --connect sends the image as one job to a server started with --serve;
+    // --profile prints the time, traffic and FLOPs of each stage at exit, as OPSD_PROFILE=1 does;
+    // --trace writes a Chrome trace of the stages and threads to <file>, as OPSD_TRACE=<file> does;
+    // --counters adds hardware counters per stage to the --profile table, as OPSD_COUNTERS=1 does;
+    // --dry-run only estimates memory, I/O and stage times, from the bench --csv file given by
+    // --machine (or OPSD_MACHINE), and recommends the fastest variant within --budget (default: RAM);
+    // --out-of-core streams data.bin through slabs and an on-disk scratch, within --budget
+    opsd_layout layout = OPSD_ROW_MAJOR;
+    int mapped = 0, batch = 0, stream = 0, dry_run = 0, out_of_core = 0;
+    const char *socket_path = NULL, *machine_file = getenv("OPSD_MACHINE");
+    double budget = (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+    for (int i = 9; i < argc; i++)
     {
-        if (!strcmp(PRECISION, "single"))
+        if (!strcmp(argv[i], "--mmap"))
+            mapped = 1;
+        else if (!strcmp(argv[i], "--batch"))
+            batch = 1;
+        else if (!strcmp(argv[i], "--stream"))
+            stream = 1;
+        else if (!strcmp(argv[i], "--connect") && i + 1 < argc)
+            socket_path = argv[++i];
+        else if (!strcmp(argv[i], "--profile"))
+            profile_enable();
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+            trace_enable(argv[++i]);
+        else if (!strcmp(argv[i], "--counters"))
+            counters_enable();
+        else if (!strcmp(argv[i], "--out-of-core"))
+            out_of_core = 1;
+        else if (!strcmp(argv[i], "--dry-run"))
+            dry_run = 1;
+        else if (!strcmp(argv[i], "--machine") && i + 1 < argc)
+            machine_file = argv[++i];
+        else if (!strcmp(argv[i], "--budget") && i + 1 < argc)
+            budget = atof(argv[++i]) * 1e9;
+        else if (!strcmp(argv[i], "column"))
+            layout = OPSD_COLUMN_MAJOR;
+        else if (strcmp(argv[i], "row"))
         {
-            MKL_Complex8 *I_t = NULL;
-            init_cvector(&I_t, size);
-
-            MKL_Complex8 *B_t = NULL;
-            init_cvector(&B_t, size);
-
-            if (!strcmp(INPUT, "rb"))
-            {
-                float *aux = NULL;
-                init_fvector(&aux, size);
-                snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", DIR);
-                read_fvector_bin(filepath, aux, size);
-                copy_fvector_to_cvector(I_t, aux, size);
-                free_fvector(aux);
-            }
-            else if (!strcmp(INPUT, "fm"))
-            {
-                fill_cmatrix(I_t, rows, columns, seed);
-            }
-
-            compute_cperiodic_border_B(I_t, B_t, rows, columns);
-            compute_cfft2d(I_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/spectrum.bin", DIR);
-                save_cvector_on_bin(filepath, I_t, size);
-            }
-
-            compute_cfft2d_of_border_B(B_t, rows, columns);
-            compute_csmooth_component_S(B_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/smooth.bin", DIR);
-                save_cvector_on_bin(filepath, B_t, size);
-            }
-
-            compute_cperiodic_component_P(I_t, B_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/periodic.bin", DIR);
-                save_cvector_on_bin(filepath, I_t, size);
-            }
-
-            compute_cifft2d(I_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                float *aux = NULL;
-                init_fvector(&aux, size);
-                copy_cvector_to_real_fvector(I_t, aux, size);
-                snprintf(filepath, sizeof(filepath), "../bin/%s/data_filtered.bin", DIR);
-                save_fvector_on_bin(filepath, aux, size);
-                free_fvector(aux);
-            }
-
-            free_cvector(B_t);
-            free_cvector(I_t);
+            printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed> [layout] [--mmap] [--batch] [--stream] [--connect <socket>] [--profile] [--trace <file>] [--counters] [--out-of-core] [--dry-run [--machine <csv>]] [--budget <GB>]\n", argv[0]);
+            printf("Options to [layout]: 'row' or 'column'\n");
+            return -2;
         }
-        else if (!strcmp(PRECISION, "double"))
-        {
-            MKL_Complex16 *I_t = NULL;
-            init_zvector(&I_t, size);
-
-            MKL_Complex16 *B_t = NULL;
-            init_zvector(&B_t, size);
-
-            if (!strcmp(INPUT, "rb"))
-            {
-                double *aux = NULL;
-                init_dvector(&aux, size);
-                snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", DIR);
-                read_dvector_bin(filepath, aux, size);
-                copy_dvector_to_zvector(I_t, aux, size);
-                free_dvector(aux);
-            }
-            else if (!strcmp(INPUT, "fm"))
-            {
-                fill_zmatrix(I_t, rows, columns, seed);
-            }
-
-            compute_zperiodic_border_B(I_t, B_t, rows, columns);
-            compute_zfft2d(I_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/spectrum.bin", DIR);
-                save_zvector_on_bin(filepath, I_t, size);
-            }
-
-            compute_zfft2d_of_border_B(B_t, rows, columns);
-            compute_zsmooth_component_S(B_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/smooth.bin", DIR);
-                save_zvector_on_bin(filepath, B_t, size);
-            }
-
-            compute_zperiodic_component_P(I_t, B_t, rows, columns);
+    }
 
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/periodic.bin", DIR);
-                save_zvector_on_bin(filepath, I_t, size);
-            }
+    int err_code = check_args(argv[0], PRECISION, SAVE_VECTORS, INPUT);
+    if (err_code)
+        return err_code;
 
-            compute_zifft2d(I_t, rows, columns);
+    char filepath[1024];
+    opsd_job job = {rows, columns, OPSD_COMPLEX, layout, 0, !strcmp(SAVE_VECTORS, "yes"), INPUT, DIR, seed, mapped, NULL, 1, NULL};
+    job.products = parse_routines(ROUTINE, &job.domain);
+    if (!job.products)
+    {
+        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed> [layout] [--mmap] [--batch] [--stream] [--connect <socket>] [--profile] [--trace <file>] [--counters] [--out-of-core] [--dry-run [--machine <csv>]] [--budget <GB>]\n", argv[0]);
+        printf("Options to <routine>: 'ccr', 'cts', 'css', 'rccr', 'rcts', 'rcss' or a comma-separated list of them (e.g. 'ccr,css')\n");
+        return -2;
+
+        //compute completed routine - ccr
+        //compute shifted spectrums - css
+        //compute tradicional spectrums - cts
+        //r prefix: real input through R2C/C2R transforms
+    }
 
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                double *aux = NULL;
-                init_dvector(&aux, size);
-                copy_zvector_to_real_dvector(I_t, aux, size);
-                snprintf(filepath, sizeof(filepath), "../bin/%s/data_filtered.bin", DIR);
-                save_dvector_on_bin(filepath, aux, size);
-                free_dvector(aux);
-            }
+    if (dry_run)
+    {
+        run_dry_run(&job, strcmp(PRECISION, "single") ? OPSD_DOUBLE : OPSD_SINGLE, machine_file, budget);
+        return 0;
+    }
 
-            free_zvector(B_t);
-            free_zvector(I_t);
-        }
+    if (socket_path != NULL)
+    {
+        snprintf(filepath, sizeof(filepath), "../bin/%s", DIR);
+        if (job.save)
+            ensure_directory_exists(filepath);
+        return run_client(&job, strcmp(PRECISION, "single") != 0, socket_path);
     }
-    else if (!strcmp(ROUTINE, "cts"))
+
+    if (stream)
     {
         if (!strcmp(PRECISION, "single"))
-        {
-            MKL_Complex8 *I_t = NULL;
-            init_cvector(&I_t, size);
+            run_cstream(&job);
+        else
+            run_zstream(&job);
 
-            MKL_Complex8 *B_t = NULL;
-            init_cvector(&B_t, size);
-
-            if (!strcmp(INPUT, "rb"))
-            {
-                float *aux = NULL;
-                init_fvector(&aux, size);
-                snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", DIR);
-                read_fvector_bin(filepath, aux, size);
-                copy_fvector_to_cvector(I_t, aux, size);
-                free_fvector(aux);
-            }
-            else if (!strcmp(INPUT, "fm"))
-            {
-                fill_cmatrix(I_t, rows, columns, seed);
-            }
-
-            compute_cperiodic_border_B(I_t, B_t, rows, columns);
-            compute_cfft2d(I_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/spectrum.bin", DIR);
-                save_cvector_on_bin(filepath, I_t, size);
-            }
-
-            compute_cfft2d_of_border_B(B_t, rows, columns);
-            compute_csmooth_component_S(B_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/smooth.bin", DIR);
-                save_cvector_on_bin(filepath, B_t, size);
-            }
-
-            compute_cperiodic_component_P(I_t, B_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/periodic.bin", DIR);
-                save_cvector_on_bin(filepath, I_t, size);
-            }
-
-            free_cvector(B_t);
-            free_cvector(I_t);
-        }
-        else if (!strcmp(PRECISION, "double"))
-        {
-            MKL_Complex16 *I_t = NULL;
-            init_zvector(&I_t, size);
-
-            MKL_Complex16 *B_t = NULL;
-            init_zvector(&B_t, size);
-
-            if (!strcmp(INPUT, "rb"))
-            {
-                double *aux = NULL;
-                init_dvector(&aux, size);
-                snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", DIR);
-                read_dvector_bin(filepath, aux, size);
-                copy_dvector_to_zvector(I_t, aux, size);
-                free_dvector(aux);
-            }
-            else if (!strcmp(INPUT, "fm"))
-            {
-                fill_zmatrix(I_t, rows, columns, seed);
-            }
-
-            compute_zperiodic_border_B(I_t, B_t, rows, columns);
-            compute_zfft2d(I_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/spectrum.bin", DIR);
-                save_zvector_on_bin(filepath, I_t, size);
-            }
-
-            compute_zfft2d_of_border_B(B_t, rows, columns);
-            compute_zsmooth_component_S(B_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/smooth.bin", DIR);
-                save_zvector_on_bin(filepath, B_t, size);
-            }
-
-            compute_zperiodic_component_P(I_t, B_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/periodic.bin", DIR);
-                save_zvector_on_bin(filepath, I_t, size);
-            }
+        destroy_plans();
+        return 0;
+    }
 
-            free_zvector(B_t);
-            free_zvector(I_t);
-        }
+    if (batch && strcmp(INPUT, "rb"))
+    {
+        printf("--batch reads its images: <input> must be 'rb'\n");
+        return -5;
     }
-    else if (!strcmp(ROUTINE, "css"))
+
+    if (out_of_core)
     {
-        if (!strcmp(PRECISION, "single"))
+        if (strcmp(INPUT, "rb"))
         {
-            MKL_Complex8 *I_t = NULL;
-            init_cvector(&I_t, size);
-
-            MKL_Complex8 *B_t = NULL;
-            init_cvector(&B_t, size);
-
-            if (!strcmp(INPUT, "rb"))
-            {
-                float *aux = NULL;
-                init_fvector(&aux, size);
-                snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", DIR);
-                read_fvector_bin(filepath, aux, size);
-                copy_fvector_to_cvector(I_t, aux, size);
-                free_fvector(aux);
-            }
-            else if (!strcmp(INPUT, "fm"))
-            {
-                fill_cmatrix(I_t, rows, columns, seed);
-            }
-
-            compute_cperiodic_border_B(I_t, B_t, rows, columns);
-            compute_cfft2d(I_t, rows, columns);
-            compute_cfftshift(I_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/spectrum_shifted.bin", DIR);
-                save_cvector_on_bin(filepath, I_t, size);
-            }
-
-            compute_cfft2d_of_border_B(B_t, rows, columns);
-            compute_csmooth_component_S(B_t, rows, columns);
-            compute_cfftshift(B_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/smooth_shifted.bin", DIR);
-                save_cvector_on_bin(filepath, B_t, size);
-            }
-
-            compute_cperiodic_component_P(I_t, B_t, rows, columns);
-
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/periodic_shifted.bin", DIR);
-                save_cvector_on_bin(filepath, I_t, size);
-            }
-
-            free_cvector(B_t);
-            free_cvector(I_t);
+            printf("--out-of-core streams data.bin: <input> must be 'rb'\n");
+            return -5;
         }
-        else if (!strcmp(PRECISION, "double"))
-        {
-            MKL_Complex16 *I_t = NULL;
-            init_zvector(&I_t, size);
 
-            MKL_Complex16 *B_t = NULL;
-            init_zvector(&B_t, size);
+        snprintf(filepath, sizeof(filepath), "../bin/%s", DIR);
+        ensure_directory_exists(filepath);
+        if (!strcmp(PRECISION, "single"))
+            run_coutofcore(&job, budget);
+        else
+            run_zoutofcore(&job, budget);
 
-            if (!strcmp(INPUT, "rb"))
-            {
-                double *aux = NULL;
-                init_dvector(&aux, size);
-                snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", DIR);
-                read_dvector_bin(filepath, aux, size);
-                copy_dvector_to_zvector(I_t, aux, size);
-                free_dvector(aux);
-            }
-            else if (!strcmp(INPUT, "fm"))
-            {
-                fill_zmatrix(I_t, rows, columns, seed);
-            }
+        destroy_plans();
+        return 0;
+    }
 
-            compute_zperiodic_border_B(I_t, B_t, rows, columns);
-            compute_zfft2d(I_t, rows, columns);
-            compute_zfftshift(I_t, rows, columns);
+    snprintf(filepath, sizeof(filepath), "../bin/%s", DIR);
 
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/spectrum_shifted.bin", DIR);
-                save_zvector_on_bin(filepath, I_t, size);
-            }
+    if (!batch)
+        ensure_directory_exists(filepath);
 
-            compute_zfft2d_of_border_B(B_t, rows, columns);
-            compute_zsmooth_component_S(B_t, rows, columns);
-            compute_zfftshift(B_t, rows, columns);
+    // Products go through the background writer, which overlaps their I/O with the
+    // remaining stages; mapped runs write through the page cache instead
+    opsd_writer writer;
+    if (job.save && !job.mmap)
+    {
+        writer_start(&writer);
+        job.writer = &writer;
+    }
 
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/smooth_shifted.bin", DIR);
-                save_zvector_on_bin(filepath, B_t, size);
-            }
+    if (batch && !strcmp(PRECISION, "single"))
+        run_cbatch(&job);
+    else if (batch)
+        run_zbatch(&job);
+    else if (!strcmp(PRECISION, "single"))
+        run_cpipeline(&job);
+    else if (!strcmp(PRECISION, "double"))
+        run_zpipeline(&job);
 
-            compute_zperiodic_component_P(I_t, B_t, rows, columns);
+    if (job.writer != NULL)
+    {
+        writer_stop(&writer);
+        double hidden = writer.write_time > writer.wait_time ? writer.write_time - writer.wait_time : 0.0;
+        printf("Output: %.1f MB written and synced in %.3f s, %.3f s hidden behind compute\n",
+               writer.bytes / 1e6, writer.write_time, hidden);
+    }
 
-            if (!strcmp(SAVE_VECTORS, "yes"))
-            {
-                snprintf(filepath, sizeof(filepath), "../bin/%s/periodic_shifted.bin", DIR);
-                save_zvector_on_bin(filepath, I_t, size);
-            }
+    destroy_plans();
 
-            free_zvector(B_t);
-            free_zvector(I_t);
-        }
-    }
     return 0;
 }
@@ -0,0 +1,210 @@
+#define _GNU_SOURCE // sched_getaffinity, pthread_setaffinity_np
+#include "../include/numa.h"
+#include <strings.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+
+// Pages of a buffer whose node numa_sample asks for
+#define OPSD_NUMA_SAMPLES 1024
+
+int opsd_numa = 0;
+int opsd_shared_team = 0;
+
+static int node_count = 1, node_limit = 1;   // nodes present, highest node id + 1
+static int cpu_nodes[CPU_SETSIZE];           // node of each CPU
+static int cpus[CPU_SETSIZE], cpu_count = 0; // allowed CPUs in node order
+static int pinning = 0, pinned_team = 0;
+static double placement_bytes[OPSD_NUMA_MAX_NODES];
+static pthread_once_t numa_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t numa_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Node of every CPU from the cpulist of each node, e.g. "0-15,32-47"
+static void read_cpu_nodes(void)
+{
+    node_count = 0;
+    for (int node = 0; node < OPSD_NUMA_MAX_NODES; node++)
+    {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *file = fopen(path, "r");
+        if (file == NULL)
+            continue;
+
+        node_count++;
+        node_limit = node + 1;
+        int first, last, separator = ',';
+        while (separator == ',' && fscanf(file, "%d", &first) == 1)
+        {
+            last = first;
+            separator = fgetc(file);
+            if (separator == '-' && fscanf(file, "%d", &last) == 1)
+                separator = fgetc(file);
+            for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+                cpu_nodes[cpu] = node;
+        }
+        fclose(file);
+    }
+
+    if (node_count == 0)
+    {
+        node_count = 1;
+        node_limit = 1;
+    }
+}
+
+// MKL runs its threads in the OpenMP runtime the library is built with (mkl_rt
+// defaults to the Intel one, a pool of its own under gcc): the stages and MKL
+// then share one team, which pin_team pins and profile.c counts. Ahead of the
+// other constructors, since the first MKL call fixes the layer; an explicit
+// MKL_THREADING_LAYER wins.
+__attribute__((constructor(101))) static void threading_from_environment(void)
+{
+#if defined(__INTEL_LLVM_COMPILER) || defined(__INTEL_COMPILER)
+    const char *layer = "INTEL";
+    int code = MKL_THREADING_INTEL;
+#else
+    const char *layer = "GNU";
+    int code = MKL_THREADING_GNU;
+#endif
+
+    const char *value = getenv("MKL_THREADING_LAYER");
+    if (value != NULL && value[0] != '\0')
+    {
+        opsd_shared_team = strcasecmp(value, layer) == 0;
+        return;
+    }
+    mkl_set_threading_layer(code);
+    opsd_shared_team = 1;
+}
+
+__attribute__((constructor)) static void numa_from_environment(void)
+{
+    read_cpu_nodes();
+
+    const char *value = getenv("OPSD_NUMA");
+    if (value != NULL && value[0] != '\0')
+        opsd_numa = strcmp(value, "0") != 0;
+    else
+        opsd_numa = node_count > 1;
+}
+
+int numa_nodes(void)
+{
+    return node_count;
+}
+
+// CPUs of the affinity mask, node after node
+static int allowed_cpus(int *list)
+{
+    cpu_set_t allowed;
+    int count = 0;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed))
+        return 0;
+
+    for (int node = 0; node < node_limit; node++)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &allowed) && cpu_nodes[cpu] == node)
+                list[count++] = cpu;
+        }
+    }
+    return count;
+}
+
+// Done at the first large buffer, after any numa_bind_share
+static void numa_setup(void)
+{
+    cpu_count = allowed_cpus(cpus);
+    pinning = cpu_count > 1 && getenv("OMP_PLACES") == NULL && getenv("OMP_PROC_BIND") == NULL &&
+              getenv("GOMP_CPU_AFFINITY") == NULL && getenv("KMP_AFFINITY") == NULL;
+}
+
+// Thread t of a team of T runs on CPU t * cpu_count / T: spread over the
+// nodes in order, as OMP_PROC_BIND=spread would. Again whenever the team grows
+// (bench --threads); the pool threads keep their CPU for MKL's calls too.
+static void pin_team(void)
+{
+    int threads = omp_get_max_threads() > mkl_get_max_threads() ? omp_get_max_threads() : mkl_get_max_threads();
+    if (!pinning || omp_in_parallel() || threads <= pinned_team)
+        return;
+
+#pragma omp parallel num_threads(threads)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[(size_t)omp_get_thread_num() * cpu_count / omp_get_num_threads()], &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    pinned_team = threads;
+}
+
+void numa_touch(void *data, size_t bytes, size_t page)
+{
+    pthread_once(&numa_once, numa_setup);
+
+    pthread_mutex_lock(&numa_lock);
+    pin_team();
+    pthread_mutex_unlock(&numa_lock);
+
+    // Thread t touches the t-th contiguous share of the pages, as the static
+    // schedule of the stage loops hands it the t-th share of rows or columns
+    char *pointer = data;
+    size_t pages = (bytes + page - 1) / page;
+#pragma omp parallel for schedule(static)
+    for (size_t p = 0; p < pages; p++)
+        pointer[p * page] = 0;
+}
+
+void numa_bind_share(int part, int parts)
+{
+    static int list[CPU_SETSIZE];
+    int count = allowed_cpus(list);
+    if (!opsd_numa || parts < 2 || count < parts)
+        return;
+
+    cpu_set_t share;
+    CPU_ZERO(&share);
+    for (int i = part * count / parts; i < (part + 1) * count / parts; i++)
+        CPU_SET(list[i], &share);
+    sched_setaffinity(0, sizeof(share), &share);
+}
+
+// Pages never touched have no node (a negative status) and are left out
+void numa_sample(const void *pointer, size_t bytes)
+{
+    if (node_count < 2 && !opsd_numa)
+        return;
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t first = ((uintptr_t)pointer + page - 1) / page * page, end = (uintptr_t)pointer + bytes;
+    size_t pages = end > first ? (end - first) / page : 0;
+    size_t count = pages < OPSD_NUMA_SAMPLES ? pages : OPSD_NUMA_SAMPLES;
+    if (count == 0)
+        return;
+
+    void *addresses[OPSD_NUMA_SAMPLES];
+    int status[OPSD_NUMA_SAMPLES];
+    for (size_t i = 0; i < count; i++)
+        addresses[i] = (void *)(first + i * pages / count * page);
+    if (syscall(SYS_move_pages, 0, count, addresses, NULL, status, 0))
+        return;
+
+    pthread_mutex_lock(&numa_lock);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (status[i] >= 0 && status[i] < OPSD_NUMA_MAX_NODES)
+            placement_bytes[status[i]] += (double)bytes / count;
+    }
+    pthread_mutex_unlock(&numa_lock);
+}
+
+// Returns the highest node id + 1
+int numa_placement(double *placement)
+{
+    pthread_mutex_lock(&numa_lock);
+    memcpy(placement, placement_bytes, sizeof(placement_bytes));
+    pthread_mutex_unlock(&numa_lock);
+    return node_limit;
+}
@@ -0,0 +1,487 @@
+#include "../include/outofcore.h"
+
+// Product files in opsd_product bit order
+static const char *product_names[] = {"spectrum", "smooth", "periodic", "spectrum_shifted", "smooth_shifted", "periodic_shifted",
+                                      "data_filtered"};
+
+// pread or pwrite of the whole range, resumed after short transfers
+static void transfer(int fd, char *data, size_t bytes, size_t offset, int write)
+{
+    while (bytes > 0)
+    {
+        ssize_t done = write ? pwrite(fd, data, bytes, (off_t)offset) : pread(fd, data, bytes, (off_t)offset);
+        if (done <= 0) {
+            perror(write ? "Erro ao escrever o arquivo" : "Error reading file");
+            exit(EXIT_FAILURE);
+        }
+        data += done;
+        bytes -= done;
+        offset += done;
+    }
+}
+
+void transfer_block(int fd, void *block, size_t block_rows, size_t block_width, size_t element, size_t file_rows,
+                    size_t file_width, size_t column, size_t row_shift, size_t column_shift, int write)
+{
+    opsd_stage stage = write ? OPSD_STAGE_SAVE : OPSD_STAGE_LOAD;
+    double start = profile_begin(stage);
+
+    size_t target = (column + column_shift) % file_width;
+    size_t head = file_width - target < block_width ? file_width - target : block_width;
+    for (size_t r = 0; r < block_rows; r++)
+    {
+        char *data = (char *)block + r * block_width * element;
+        size_t offset = (r + row_shift) % file_rows * file_width * element;
+
+        transfer(fd, data, head * element, offset + target * element, write);
+        if (head < block_width)
+            transfer(fd, data + head * element, (block_width - head) * element, offset, write);
+    }
+
+    double bytes = (double)block_rows * block_width * element;
+    profile_end_io(stage, start, write ? 0.0 : bytes, write ? bytes : 0.0);
+}
+
+int open_product(const opsd_job *job, int product, size_t bytes, int create)
+{
+    char filepath[1024];
+    snprintf(filepath, sizeof(filepath), "../bin/%s/%s.bin", job->dir, product_names[product]);
+
+    int fd = open(filepath, create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+    if (fd < 0 || (create && ftruncate(fd, bytes))) {
+        perror("Erro ao abrir o arquivo para escrita");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+// The transposed spectrum lives in an unlinked file next to the products,
+// released when closed even if the run is interrupted
+static int open_scratch(const opsd_job *job, size_t bytes)
+{
+    char filepath[1024];
+    snprintf(filepath, sizeof(filepath), "../bin/%s/.scratch_XXXXXX", job->dir);
+
+    int fd = mkstemp(filepath);
+    if (fd < 0 || unlink(filepath) || ftruncate(fd, bytes)) {
+        perror("Erro ao criar o arquivo temporario");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+// The slab descriptor for count transforms, committed again only when the
+// count changes, i.e. for the last slab of a pass
+static DFTI_DESCRIPTOR_HANDLE slab_fft(DFTI_DESCRIPTOR_HANDLE fft, size_t *committed, opsd_precision precision, opsd_domain domain,
+                                       size_t length, size_t count, opsd_direction direction)
+{
+    if (fft != NULL && *committed == count)
+        return fft;
+    if (fft != NULL)
+        DftiFreeDescriptor(&fft);
+
+    *committed = count;
+    return create_slab_fft(precision, domain, length, count, direction);
+}
+
+void close_products(int *outputs)
+{
+    for (int p = 0; p < 7; p++)
+    {
+        if (outputs[p] >= 0 && (fsync(outputs[p]) || close(outputs[p]))) {
+            perror("Erro ao escrever o arquivo");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+//CVECTOR OUT-OF-CORE
+
+// Edge differences of rows [first, first + count) of the raw image: the first
+// and last rows give R, the first and last column of every row give C
+void gather_cedges(const float *raw, MKL_Complex8 *R, MKL_Complex8 *C, size_t first, size_t count, size_t rows, size_t columns)
+{
+    if (first == 0)
+    {
+        for (size_t j = 0; j < columns; j++)
+        {
+            R[j].real = -raw[j];
+            R[j].imag = 0.0f;
+        }
+    }
+
+    if (first + count == rows)
+    {
+        for (size_t j = 0; j < columns; j++)
+            R[j].real += raw[(count - 1) * columns + j];
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        C[first + i].real = raw[i * columns + columns - 1] - raw[i * columns];
+        C[first + i].imag = 0.0f;
+    }
+}
+
+// Columns [first, first + count) of a spectrum, stored transposed in slab, go
+// to the row-major product files: as they are, and centered with the rotation
+// of compute_cfftshift (rows / 2, column_shift). A file of -1 is skipped.
+void save_ccolumns(int plain, int shifted, MKL_Complex8 *slab, MKL_Complex8 *T, size_t rows, size_t width, size_t first,
+                   size_t count, size_t column_shift)
+{
+    if (plain < 0 && shifted < 0)
+        return;
+
+    MKL_Complex8 one = {1.0f, 0.0f};
+    mkl_comatcopy('R', 'T', count, rows, one, slab, rows, T, count);
+    if (plain >= 0)
+        transfer_block(plain, T, rows, count, sizeof(MKL_Complex8), rows, width, first, 0, 0, 1);
+    if (shifted >= 0)
+        transfer_block(shifted, T, rows, count, sizeof(MKL_Complex8), rows, width, first, rows / 2, column_shift, 1);
+}
+
+void run_coutofcore(const opsd_job *job, size_t budget)
+{
+    // Column-major data.bin is the row-major transposed image, and the products
+    // keep that layout, so the passes below only see row-major images
+    size_t rows = job->layout == OPSD_ROW_MAJOR ? job->rows : job->columns;
+    size_t columns = job->layout == OPSD_ROW_MAJOR ? job->columns : job->rows;
+    int real = job->domain == OPSD_REAL;
+    size_t width = real ? columns / 2 + 1 : columns, column_shift = real ? 0 : columns / 2;
+    unsigned products = job->save ? job->products : 0, smooth = products & (OPSD_SMOOTH | OPSD_SMOOTH_SHIFTED);
+    int filtered = (job->products & OPSD_FILTERED) != 0;
+
+    // Besides the slabs: R, C and the plan tables. A row slab holds the raw
+    // rows, their spectra and a transposed copy; a column slab holds the
+    // columns, a transposed copy and their smooth component when it is saved
+    size_t fixed = (rows + columns) * (2 * sizeof(MKL_Complex8) + sizeof(float));
+    size_t per_row = columns * sizeof(float) + 2 * width * sizeof(MKL_Complex8);
+    size_t per_column = rows * sizeof(MKL_Complex8) * (2 + (smooth != 0));
+    size_t slab_rows = budget > fixed ? (budget - fixed) / per_row : 0;
+    size_t slab_columns = budget > fixed ? (budget - fixed) / per_column : 0;
+    if (slab_rows == 0 || slab_columns == 0)
+    {
+        printf("Budget too small for --out-of-core: %.1f MB at least\n", (fixed + (per_row > per_column ? per_row : per_column)) / 1e6);
+        return;
+    }
+    slab_rows = slab_rows < rows ? slab_rows : rows;
+    slab_columns = slab_columns < width ? slab_columns : width;
+
+    char filepath[1024];
+    snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", job->dir);
+    int input = open(filepath, O_RDONLY);
+    if (input < 0) {
+        perror("Error opening file");
+        exit(EXIT_FAILURE);
+    }
+
+    int scratch = open_scratch(job, width * rows * sizeof(MKL_Complex8)), outputs[7];
+    for (int p = 0; p < 7; p++)
+    {
+        size_t bytes = p == 6 ? rows * columns * sizeof(float) : rows * width * sizeof(MKL_Complex8);
+        outputs[p] = products & (1u << p) ? open_product(job, p, bytes, 1) : -1;
+    }
+
+    double start = omp_get_wtime();
+    MKL_Complex8 one = {1.0f, 0.0f};
+    MKL_Complex8 *R = NULL, *C = NULL, *slab = NULL, *T = NULL, *S = NULL;
+    float *raw = NULL;
+    DFTI_DESCRIPTOR_HANDLE fft = NULL;
+    size_t committed = 0;
+    init_cvector(&R, columns);
+    init_cvector(&C, rows);
+
+    // Pass 1, row slabs: the row FFTs (R2C for real input), written to the
+    // scratch transposed, and the edge differences
+    init_fvector(&raw, slab_rows * columns);
+    init_cvector(&slab, slab_rows * width);
+    init_cvector(&T, slab_rows * width);
+    for (size_t first = 0; first < rows; first += slab_rows)
+    {
+        size_t count = rows - first < slab_rows ? rows - first : slab_rows;
+        transfer_block(input, raw, 1, count * columns, sizeof(float), 1, rows * columns, first * columns, 0, 0, 0);
+        gather_cedges(raw, R, C, first, count, rows, columns);
+        if (real)
+            pad_fvector_rows_from((float *)slab, raw, count, columns);
+        else
+            copy_fvector_to_cvector(slab, raw, count * columns);
+
+        fft = slab_fft(fft, &committed, OPSD_SINGLE, job->domain, columns, count, OPSD_FORWARD);
+        double stage = profile_begin(OPSD_STAGE_A_FFT2D);
+        trace_forward(fft, slab, "fft_slab_rows");
+        profile_end(OPSD_STAGE_A_FFT2D, stage, OPSD_SINGLE, job->domain, count, columns, 1);
+
+        mkl_comatcopy('R', 'T', count, width, one, slab, width, T, count);
+        transfer_block(scratch, T, width, count, sizeof(MKL_Complex8), width, rows, first, 0, 0, 1);
+    }
+    DftiFreeDescriptor(&fft);
+    free_cvector(T);
+    free_cvector(slab);
+    free_fvector(raw);
+
+    compute_cedge_spectra(R, C, rows, columns, job->domain);
+
+    // Pass 2, column slabs read contiguously from the scratch: the column FFTs,
+    // Steps C-E on the slab and the spectral products. ccr takes the inverse
+    // column FFTs back to the scratch
+    init_cvector(&slab, slab_columns * rows);
+    init_cvector(&T, slab_columns * rows);
+    if (smooth)
+        init_cvector(&S, slab_columns * rows);
+    for (size_t first = 0; first < width; first += slab_columns)
+    {
+        size_t count = width - first < slab_columns ? width - first : slab_columns;
+        transfer_block(scratch, slab, 1, count * rows, sizeof(MKL_Complex8), 1, width * rows, first * rows, 0, 0, 0);
+
+        fft = slab_fft(fft, &committed, OPSD_SINGLE, OPSD_COMPLEX, rows, count, OPSD_FORWARD);
+        double stage = profile_begin(OPSD_STAGE_A_FFT2D);
+        trace_forward(fft, slab, "fft_slab_columns");
+        profile_end(OPSD_STAGE_A_FFT2D, stage, OPSD_SINGLE, OPSD_COMPLEX, count, rows, 1);
+        save_ccolumns(outputs[0], outputs[3], slab, T, rows, width, first, count, column_shift);
+
+        compute_cperiodic_component_P_fused_columns(slab, R, C, S, rows, columns, first, count, job->domain);
+        if (S != NULL)
+            save_ccolumns(outputs[1], outputs[4], S, T, rows, width, first, count, column_shift);
+        save_ccolumns(outputs[2], outputs[5], slab, T, rows, width, first, count, column_shift);
+
+        if (filtered)
+        {
+            stage = profile_begin(OPSD_STAGE_IFFT2D);
+            trace_backward(fft, slab, "fft_slab_columns");
+            profile_end(OPSD_STAGE_IFFT2D, stage, OPSD_SINGLE, OPSD_COMPLEX, count, rows, 1);
+            transfer_block(scratch, slab, 1, count * rows, sizeof(MKL_Complex8), 1, width * rows, first * rows, 0, 0, 1);
+        }
+    }
+    DftiFreeDescriptor(&fft);
+    if (S != NULL)
+        free_cvector(S);
+    free_cvector(T);
+    free_cvector(slab);
+
+    // Pass 3, row slabs gathered from the transposed scratch: the inverse row
+    // FFTs (C2R for real input) and data_filtered
+    if (filtered)
+    {
+        init_fvector(&raw, slab_rows * columns);
+        init_cvector(&slab, slab_rows * width);
+        init_cvector(&T, slab_rows * width);
+        for (size_t first = 0; first < rows; first += slab_rows)
+        {
+            size_t count = rows - first < slab_rows ? rows - first : slab_rows;
+            transfer_block(scratch, T, width, count, sizeof(MKL_Complex8), width, rows, first, 0, 0, 0);
+            mkl_comatcopy('R', 'T', width, count, one, T, count, slab, width);
+
+            fft = slab_fft(fft, &committed, OPSD_SINGLE, job->domain, columns, count, OPSD_BACKWARD);
+            double stage = profile_begin(OPSD_STAGE_IFFT2D);
+            trace_backward(fft, slab, "fft_slab_rows");
+            profile_end(OPSD_STAGE_IFFT2D, stage, OPSD_SINGLE, job->domain, count, columns, 1);
+
+            if (real)
+                compact_fvector_rows_to(raw, (float *)slab, count, columns);
+            else
+                copy_cvector_to_real_fvector(slab, raw, count * columns);
+            if (outputs[6] >= 0)
+                transfer_block(outputs[6], raw, 1, count * columns, sizeof(float), 1, rows * columns, first * columns, 0, 0, 1);
+        }
+        DftiFreeDescriptor(&fft);
+        free_cvector(T);
+        free_cvector(slab);
+        free_fvector(raw);
+    }
+
+    close_products(outputs);
+    close(scratch);
+    close(input);
+    free_cvector(C);
+    free_cvector(R);
+
+    printf("Out-of-core: %zu-row and %zu-column slabs within %.1f MB, %.1f MB of scratch, %.3f s\n", slab_rows, slab_columns,
+           budget / 1e6, width * rows * sizeof(MKL_Complex8) / 1e6, omp_get_wtime() - start);
+}
+
+//ZVECTOR OUT-OF-CORE
+
+void gather_zedges(const double *raw, MKL_Complex16 *R, MKL_Complex16 *C, size_t first, size_t count, size_t rows, size_t columns)
+{
+    if (first == 0)
+    {
+        for (size_t j = 0; j < columns; j++)
+        {
+            R[j].real = -raw[j];
+            R[j].imag = 0.0;
+        }
+    }
+
+    if (first + count == rows)
+    {
+        for (size_t j = 0; j < columns; j++)
+            R[j].real += raw[(count - 1) * columns + j];
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        C[first + i].real = raw[i * columns + columns - 1] - raw[i * columns];
+        C[first + i].imag = 0.0;
+    }
+}
+
+void save_zcolumns(int plain, int shifted, MKL_Complex16 *slab, MKL_Complex16 *T, size_t rows, size_t width, size_t first,
+                   size_t count, size_t column_shift)
+{
+    if (plain < 0 && shifted < 0)
+        return;
+
+    MKL_Complex16 one = {1.0, 0.0};
+    mkl_zomatcopy('R', 'T', count, rows, one, slab, rows, T, count);
+    if (plain >= 0)
+        transfer_block(plain, T, rows, count, sizeof(MKL_Complex16), rows, width, first, 0, 0, 1);
+    if (shifted >= 0)
+        transfer_block(shifted, T, rows, count, sizeof(MKL_Complex16), rows, width, first, rows / 2, column_shift, 1);
+}
+
+void run_zoutofcore(const opsd_job *job, size_t budget)
+{
+    size_t rows = job->layout == OPSD_ROW_MAJOR ? job->rows : job->columns;
+    size_t columns = job->layout == OPSD_ROW_MAJOR ? job->columns : job->rows;
+    int real = job->domain == OPSD_REAL;
+    size_t width = real ? columns / 2 + 1 : columns, column_shift = real ? 0 : columns / 2;
+    unsigned products = job->save ? job->products : 0, smooth = products & (OPSD_SMOOTH | OPSD_SMOOTH_SHIFTED);
+    int filtered = (job->products & OPSD_FILTERED) != 0;
+
+    size_t fixed = (rows + columns) * (2 * sizeof(MKL_Complex16) + sizeof(double));
+    size_t per_row = columns * sizeof(double) + 2 * width * sizeof(MKL_Complex16);
+    size_t per_column = rows * sizeof(MKL_Complex16) * (2 + (smooth != 0));
+    size_t slab_rows = budget > fixed ? (budget - fixed) / per_row : 0;
+    size_t slab_columns = budget > fixed ? (budget - fixed) / per_column : 0;
+    if (slab_rows == 0 || slab_columns == 0)
+    {
+        printf("Budget too small for --out-of-core: %.1f MB at least\n", (fixed + (per_row > per_column ? per_row : per_column)) / 1e6);
+        return;
+    }
+    slab_rows = slab_rows < rows ? slab_rows : rows;
+    slab_columns = slab_columns < width ? slab_columns : width;
+
+    char filepath[1024];
+    snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", job->dir);
+    int input = open(filepath, O_RDONLY);
+    if (input < 0) {
+        perror("Error opening file");
+        exit(EXIT_FAILURE);
+    }
+
+    int scratch = open_scratch(job, width * rows * sizeof(MKL_Complex16)), outputs[7];
+    for (int p = 0; p < 7; p++)
+    {
+        size_t bytes = p == 6 ? rows * columns * sizeof(double) : rows * width * sizeof(MKL_Complex16);
+        outputs[p] = products & (1u << p) ? open_product(job, p, bytes, 1) : -1;
+    }
+
+    double start = omp_get_wtime();
+    MKL_Complex16 one = {1.0, 0.0};
+    MKL_Complex16 *R = NULL, *C = NULL, *slab = NULL, *T = NULL, *S = NULL;
+    double *raw = NULL;
+    DFTI_DESCRIPTOR_HANDLE fft = NULL;
+    size_t committed = 0;
+    init_zvector(&R, columns);
+    init_zvector(&C, rows);
+
+    init_dvector(&raw, slab_rows * columns);
+    init_zvector(&slab, slab_rows * width);
+    init_zvector(&T, slab_rows * width);
+    for (size_t first = 0; first < rows; first += slab_rows)
+    {
+        size_t count = rows - first < slab_rows ? rows - first : slab_rows;
+        transfer_block(input, raw, 1, count * columns, sizeof(double), 1, rows * columns, first * columns, 0, 0, 0);
+        gather_zedges(raw, R, C, first, count, rows, columns);
+        if (real)
+            pad_dvector_rows_from((double *)slab, raw, count, columns);
+        else
+            copy_dvector_to_zvector(slab, raw, count * columns);
+
+        fft = slab_fft(fft, &committed, OPSD_DOUBLE, job->domain, columns, count, OPSD_FORWARD);
+        double stage = profile_begin(OPSD_STAGE_A_FFT2D);
+        trace_forward(fft, slab, "fft_slab_rows");
+        profile_end(OPSD_STAGE_A_FFT2D, stage, OPSD_DOUBLE, job->domain, count, columns, 1);
+
+        mkl_zomatcopy('R', 'T', count, width, one, slab, width, T, count);
+        transfer_block(scratch, T, width, count, sizeof(MKL_Complex16), width, rows, first, 0, 0, 1);
+    }
+    DftiFreeDescriptor(&fft);
+    free_zvector(T);
+    free_zvector(slab);
+    free_dvector(raw);
+
+    compute_zedge_spectra(R, C, rows, columns, job->domain);
+
+    init_zvector(&slab, slab_columns * rows);
+    init_zvector(&T, slab_columns * rows);
+    if (smooth)
+        init_zvector(&S, slab_columns * rows);
+    for (size_t first = 0; first < width; first += slab_columns)
+    {
+        size_t count = width - first < slab_columns ? width - first : slab_columns;
+        transfer_block(scratch, slab, 1, count * rows, sizeof(MKL_Complex16), 1, width * rows, first * rows, 0, 0, 0);
+
+        fft = slab_fft(fft, &committed, OPSD_DOUBLE, OPSD_COMPLEX, rows, count, OPSD_FORWARD);
+        double stage = profile_begin(OPSD_STAGE_A_FFT2D);
+        trace_forward(fft, slab, "fft_slab_columns");
+        profile_end(OPSD_STAGE_A_FFT2D, stage, OPSD_DOUBLE, OPSD_COMPLEX, count, rows, 1);
+        save_zcolumns(outputs[0], outputs[3], slab, T, rows, width, first, count, column_shift);
+
+        compute_zperiodic_component_P_fused_columns(slab, R, C, S, rows, columns, first, count, job->domain);
+        if (S != NULL)
+            save_zcolumns(outputs[1], outputs[4], S, T, rows, width, first, count, column_shift);
+        save_zcolumns(outputs[2], outputs[5], slab, T, rows, width, first, count, column_shift);
+
+        if (filtered)
+        {
+            stage = profile_begin(OPSD_STAGE_IFFT2D);
+            trace_backward(fft, slab, "fft_slab_columns");
+            profile_end(OPSD_STAGE_IFFT2D, stage, OPSD_DOUBLE, OPSD_COMPLEX, count, rows, 1);
+            transfer_block(scratch, slab, 1, count * rows, sizeof(MKL_Complex16), 1, width * rows, first * rows, 0, 0, 1);
+        }
+    }
+    DftiFreeDescriptor(&fft);
+    if (S != NULL)
+        free_zvector(S);
+    free_zvector(T);
+    free_zvector(slab);
+
+    if (filtered)
+    {
+        init_dvector(&raw, slab_rows * columns);
+        init_zvector(&slab, slab_rows * width);
+        init_zvector(&T, slab_rows * width);
+        for (size_t first = 0; first < rows; first += slab_rows)
+        {
+            size_t count = rows - first < slab_rows ? rows - first : slab_rows;
+            transfer_block(scratch, T, width, count, sizeof(MKL_Complex16), width, rows, first, 0, 0, 0);
+            mkl_zomatcopy('R', 'T', width, count, one, T, count, slab, width);
+
+            fft = slab_fft(fft, &committed, OPSD_DOUBLE, job->domain, columns, count, OPSD_BACKWARD);
+            double stage = profile_begin(OPSD_STAGE_IFFT2D);
+            trace_backward(fft, slab, "fft_slab_rows");
+            profile_end(OPSD_STAGE_IFFT2D, stage, OPSD_DOUBLE, job->domain, count, columns, 1);
+
+            if (real)
+                compact_dvector_rows_to(raw, (double *)slab, count, columns);
+            else
+                copy_zvector_to_real_dvector(slab, raw, count * columns);
+            if (outputs[6] >= 0)
+                transfer_block(outputs[6], raw, 1, count * columns, sizeof(double), 1, rows * columns, first * columns, 0, 0, 1);
+        }
+        DftiFreeDescriptor(&fft);
+        free_zvector(T);
+        free_zvector(slab);
+        free_dvector(raw);
+    }
+
+    close_products(outputs);
+    close(scratch);
+    close(input);
+    free_zvector(C);
+    free_zvector(R);
+
+    printf("Out-of-core: %zu-row and %zu-column slabs within %.1f MB, %.1f MB of scratch, %.3f s\n", slab_rows, slab_columns,
+           budget / 1e6, width * rows * sizeof(MKL_Complex16) / 1e6, omp_get_wtime() - start);
+}
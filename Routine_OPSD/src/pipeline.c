@@ -0,0 +1,732 @@
+#include "../include/pipeline.h"
+
+// ccr, cts and css (r prefix: real input through R2C/C2R) are sets of products;
+// a comma-separated list runs their union in a single pass. Returns 0 for an
+// unknown routine or for a list that mixes real and complex routines.
+unsigned parse_routines(const char *routines, opsd_domain *domain)
+{
+    char list[256];
+    snprintf(list, sizeof(list), "%s", routines);
+
+    unsigned products = 0;
+    int real = -1;
+
+    for (char *saveptr = NULL, *routine = strtok_r(list, ",", &saveptr); routine != NULL; routine = strtok_r(NULL, ",", &saveptr))
+    {
+        int is_real = routine[0] == 'r';
+        if (real != -1 && real != is_real)
+            return 0;
+        real = is_real;
+
+        const char *name = routine + is_real;
+        if (!strcmp(name, "ccr"))
+            products |= OPSD_SPECTRUM | OPSD_SMOOTH | OPSD_PERIODIC | OPSD_FILTERED;
+        else if (!strcmp(name, "cts"))
+            products |= OPSD_SPECTRUM | OPSD_SMOOTH | OPSD_PERIODIC;
+        else if (!strcmp(name, "css"))
+            products |= OPSD_SHIFTED_PRODUCTS;
+        else
+            return 0;
+    }
+
+    *domain = real == 1 ? OPSD_REAL : OPSD_COMPLEX;
+    return products;
+}
+
+// ../bin/<dir>/<name>.bin, dir being the directory of the image inside the job
+static void product_path(char *filepath, size_t length, const opsd_job *job, size_t image, const char *name)
+{
+    snprintf(filepath, length, "../bin/%s/%s.bin", job->dirs != NULL ? job->dirs[image] : job->dir, name);
+}
+
+// The edge spectra of a run come from the scratch of its forward plan, the one
+// of the row-major shape that the FFTs of the run use anyway
+static opsd_plan *job_plan(const opsd_job *job, opsd_precision precision)
+{
+    size_t rows = job->layout == OPSD_ROW_MAJOR ? job->rows : job->columns;
+    size_t columns = job->layout == OPSD_ROW_MAJOR ? job->columns : job->rows;
+    return get_batch_plan(precision, job->domain, rows, columns, OPSD_FORWARD, job->count);
+}
+
+// Elements of each workspace buffer a job of job->count images needs, 0 for
+// none. W holds the centered spectrum whenever it cannot replace the plain one
+// in place (single even images); S is saved from I_t when only the centered
+// spectrum went to W. An image centered in place is modulated as it is loaded,
+// except for generated complex input, which compute_*fft2d_shifted modulates.
+static void workspace_sizes(const opsd_job *job, size_t *W, size_t *S, size_t *filtered, int *modulated)
+{
+    size_t size = job->rows * job->columns;
+    size_t lines = job->layout == OPSD_ROW_MAJOR ? job->rows : job->columns, length = size / lines;
+    size_t spectral_size = job->domain == OPSD_REAL ? lines * (length / 2 + 1) : size;
+    int plain = (job->products & OPSD_PLAIN_PRODUCTS) != 0;
+    int shifted = (job->products & OPSD_SHIFTED_PRODUCTS) != 0;
+    int centered_in_place = job->count == 1 && (job->domain == OPSD_REAL ? lines % 2 == 0 : job->rows % 2 == 0 && job->columns % 2 == 0);
+    int centered_apart = shifted && (plain || !centered_in_place);
+    unsigned smooth = job->save ? job->products & (OPSD_SMOOTH | OPSD_SMOOTH_SHIFTED) : 0;
+
+    *W = centered_apart ? job->count * spectral_size : 0;
+    *S = smooth && !job->mmap && (plain || !centered_apart) ? job->count * spectral_size : 0;
+    *filtered = plain && (job->products & OPSD_FILTERED) && job->save && job->domain == OPSD_COMPLEX && !job->mmap
+                    ? job->count * size : 0;
+    *modulated = shifted && !plain && centered_in_place && (job->domain == OPSD_REAL || !strcmp(job->input, "rb"));
+}
+
+//CVECTOR PIPELINE
+
+// flags: OPSD_WRITE_SNAPSHOT when a later stage overwrites the vector
+static void save_cproduct(const opsd_job *job, size_t image, const char *name, MKL_Complex8 *vector, size_t size, int flags)
+{
+    char filepath[1024];
+    product_path(filepath, sizeof(filepath), job, image, name);
+
+    if (job->mmap)
+    {
+        MKL_Complex8 *map = map_output_file(filepath, size * sizeof(MKL_Complex8));
+        cblas_ccopy(size, vector, 1, map, 1);
+        unmap_file(map, size * sizeof(MKL_Complex8));
+    }
+    else if (job->writer != NULL)
+    {
+        writer_submit(job->writer, filepath, vector, size * sizeof(MKL_Complex8), flags);
+    }
+    else
+    {
+        save_cvector_on_bin(filepath, vector, size);
+    }
+}
+
+// Mapped product file: the stage writing it computes straight into the page cache
+static MKL_Complex8 *open_cproduct(const opsd_job *job, size_t image, const char *name, size_t size)
+{
+    char filepath[1024];
+    product_path(filepath, sizeof(filepath), job, image, name);
+    return map_output_file(filepath, size * sizeof(MKL_Complex8));
+}
+
+static void save_cfiltered(const opsd_job *job, size_t image, MKL_Complex8 *I_t, float *aux, size_t lines, size_t length)
+{
+    size_t size = lines * length;
+    char filepath[1024];
+    product_path(filepath, sizeof(filepath), job, image, "data_filtered");
+
+    if (job->mmap)
+    {
+        float *map = map_output_file(filepath, size * sizeof(float));
+        if (job->domain == OPSD_REAL)
+            compact_fvector_rows_to(map, (float *)I_t, lines, length);
+        else
+            copy_cvector_to_real_fvector(I_t, map, size);
+        unmap_file(map, size * sizeof(float));
+        return;
+    }
+
+    float *filtered = (float *)I_t;
+    if (job->domain == OPSD_REAL)
+    {
+        compact_fvector_rows(filtered, lines, length);
+    }
+    else
+    {
+        copy_cvector_to_real_fvector(I_t, aux, size);
+        filtered = aux;
+    }
+
+    if (job->writer != NULL)
+        writer_submit(job->writer, filepath, filtered, size * sizeof(float), 0);
+    else
+        save_fvector_on_bin(filepath, filtered, size);
+}
+
+// Real input lands in lines padded for the in-place R2C. A mapped data.bin is
+// converted straight into I_t, without a staging buffer. A modulated image gets
+// the sign that centers its spectrum in the same conversion.
+static void load_cinput(const opsd_job *job, size_t image, MKL_Complex8 *I_t, float *staging, size_t lines, size_t length, int modulated)
+{
+    size_t size = job->rows * job->columns;
+    char filepath[1024];
+    product_path(filepath, sizeof(filepath), job, image, "data");
+
+    if (job->mmap && !strcmp(job->input, "rb"))
+    {
+        float *map = map_input_file(filepath, size * sizeof(float));
+        if (job->domain == OPSD_REAL && modulated)
+            pad_fvector_rows_from_modulated((float *)I_t, map, lines, length);
+        else if (job->domain == OPSD_REAL)
+            pad_fvector_rows_from((float *)I_t, map, lines, length);
+        else if (modulated)
+            copy_fvector_to_cvector_modulated(I_t, map, lines, length);
+        else
+            copy_fvector_to_cvector(I_t, map, size);
+        unmap_file(map, size * sizeof(float));
+    }
+    else if (job->domain == OPSD_REAL)
+    {
+        if (!strcmp(job->input, "rb"))
+            read_fvector_bin(filepath, (float *)I_t, size);
+        else
+            fill_fmatrix((float *)I_t, job->rows, job->columns, job->seed + image);
+        if (modulated)
+            pad_fvector_rows_modulated((float *)I_t, lines, length);
+        else
+            pad_fvector_rows((float *)I_t, lines, length);
+    }
+    else
+    {
+        if (!strcmp(job->input, "rb"))
+        {
+            read_fvector_bin(filepath, staging, size);
+            if (modulated)
+                copy_fvector_to_cvector_modulated(I_t, staging, lines, length);
+            else
+                copy_fvector_to_cvector(I_t, staging, size);
+        }
+        else
+        {
+            fill_cmatrix(I_t, job->rows, job->columns, job->seed + image);
+        }
+    }
+}
+
+// Runs the job over its count images, already loaded one after another in I_t
+// (spectral_size elements apart) and lost on return. The forward and inverse
+// FFTs are batched over all images; every other stage runs image by image.
+void init_cworkspace(const opsd_job *job, opsd_workspace *workspace)
+{
+    size_t sizes[3];
+    MKL_Complex8 *W = NULL, *S = NULL;
+    float *filtered = NULL;
+    workspace_sizes(job, &sizes[0], &sizes[1], &sizes[2], &workspace->modulated);
+    if (sizes[0])
+        init_cvector(&W, sizes[0]);
+    if (sizes[1])
+        init_cvector(&S, sizes[1]);
+    if (sizes[2])
+        init_fvector(&filtered, sizes[2]);
+
+    workspace->W = W;
+    workspace->S = S;
+    workspace->filtered = filtered;
+}
+
+void free_cworkspace(opsd_workspace *workspace)
+{
+    if (workspace->filtered != NULL)
+        free_fvector(workspace->filtered);
+    if (workspace->S != NULL)
+        free_cvector(workspace->S);
+    if (workspace->W != NULL)
+        free_cvector(workspace->W);
+}
+
+void run_cimages(const opsd_job *job, MKL_Complex8 *I_t, opsd_workspace *workspace)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns, count = job->count;
+    opsd_layout layout = job->layout;
+    unsigned products = job->products;
+    int real = job->domain == OPSD_REAL;
+
+    // The real path keeps length / 2 + 1 elements of the spectrum of each contiguous line
+    size_t lines = layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    size_t spectral_size = real ? lines * (length / 2 + 1) : size;
+
+    // Batches always take the plain transform and center it into W
+    int plain = (products & OPSD_PLAIN_PRODUCTS) != 0;
+    int shifted = (products & OPSD_SHIFTED_PRODUCTS) != 0;
+    int centered_in_place = count == 1 && (real ? lines % 2 == 0 : rows % 2 == 0 && columns % 2 == 0);
+    unsigned smooth = job->save ? products & (OPSD_SMOOTH | OPSD_SMOOTH_SHIFTED) : 0;
+
+    // The border only survives as its two edge spectra, kept in the plan's
+    // scratch; the full-size buffers are the workspace of the owner of I_t
+    opsd_plan *plan = job_plan(job, OPSD_SINGLE);
+    size_t mark = scratch_mark(plan);
+    MKL_Complex8 *W = workspace->W, *S = NULL;
+    float *aux = NULL;
+    MKL_Complex8 *R = scratch_alloc(plan, count * columns * sizeof(MKL_Complex8));
+    MKL_Complex8 *C = scratch_alloc(plan, count * rows * sizeof(MKL_Complex8));
+
+    for (size_t b = 0; b < count; b++)
+    {
+        if (real && workspace->modulated)
+            compute_cborder_edges_real_modulated(I_t + b * spectral_size, R + b * columns, C + b * rows, rows, columns, layout);
+        else if (real)
+            compute_cborder_edges_real(I_t + b * spectral_size, R + b * columns, C + b * rows, rows, columns, layout);
+        else if (workspace->modulated)
+            compute_cborder_edges_modulated(I_t + b * spectral_size, R + b * columns, C + b * rows, rows, columns, layout);
+        else
+            compute_cborder_edges(I_t + b * spectral_size, R + b * columns, C + b * rows, rows, columns, layout);
+    }
+
+    // The single forward FFT of the run
+    // A last batch group of one even image still has the W of the workspace,
+    // sized for the whole group, and is centered into it like the others
+    MKL_Complex8 *I_w = I_t, *I_w_shifted = NULL;
+    if (workspace->modulated)
+    {
+        if (real)
+            compute_cfft2d_real_modulated(I_t, rows, columns, layout);
+        else
+            compute_cfft2d_modulated(I_t, rows, columns, layout);
+        I_w_shifted = I_t;
+    }
+    else if (!plain && count == 1 && (W == NULL || !centered_in_place))
+    {
+        if (real)
+            I_w_shifted = compute_cfft2d_real_shifted(I_t, W, rows, columns, layout);
+        else
+            I_w_shifted = compute_cfft2d_shifted(I_t, W, rows, columns, layout);
+    }
+    else
+    {
+        if (real)
+            compute_cfft2d_real_batch(I_t, count, rows, columns, layout);
+        else
+            compute_cfft2d_batch(I_t, count, rows, columns, layout);
+
+        if (shifted)
+        {
+            for (size_t b = 0; b < count; b++)
+            {
+                if (real)
+                    compute_cfftshift_real(I_w + b * spectral_size, W + b * spectral_size, rows, columns, layout);
+                else
+                    compute_cfftshift(I_w + b * spectral_size, W + b * spectral_size, rows, columns, layout);
+            }
+            I_w_shifted = W;
+        }
+    }
+
+    // S is stored just to be saved: mapped runs compute it straight into its
+    // file, otherwise I_t is free when only the centered spectrum went to W
+    if (smooth && !job->mmap)
+    {
+        if (!plain && I_w_shifted != I_t)
+            S = I_t;
+        else
+            S = workspace->S;
+    }
+
+    for (size_t b = 0; b < count; b++)
+    {
+        size_t offset = b * spectral_size;
+        MKL_Complex8 *R_b = R + b * columns, *C_b = C + b * rows;
+
+        if (shifted)
+        {
+            MKL_Complex8 *I_w_b = I_w_shifted + offset;
+            if (job->save && (products & OPSD_SPECTRUM_SHIFTED))
+                save_cproduct(job, b, "spectrum_shifted", I_w_b, spectral_size, OPSD_WRITE_SNAPSHOT);
+
+            MKL_Complex8 *S_shifted = NULL;
+            if (smooth & OPSD_SMOOTH_SHIFTED)
+                S_shifted = job->mmap ? open_cproduct(job, b, "smooth_shifted", spectral_size) : S + offset;
+            if (real)
+                compute_cperiodic_component_P_fused_real_shifted(I_w_b, R_b, C_b, S_shifted, rows, columns, layout);
+            else
+                compute_cperiodic_component_P_fused_shifted(I_w_b, R_b, C_b, S_shifted, rows, columns, layout);
+
+            if (S_shifted != NULL && job->mmap)
+                unmap_file(S_shifted, spectral_size * sizeof(MKL_Complex8));
+            else if (S_shifted != NULL)
+                save_cproduct(job, b, "smooth_shifted", S_shifted, spectral_size, smooth & OPSD_SMOOTH ? OPSD_WRITE_SNAPSHOT : 0);
+            if (job->save && (products & OPSD_PERIODIC_SHIFTED))
+                save_cproduct(job, b, "periodic_shifted", I_w_b, spectral_size, 0);
+        }
+
+        if (plain)
+        {
+            MKL_Complex8 *I_w_b = I_w + offset;
+            if (job->save && (products & OPSD_SPECTRUM))
+                save_cproduct(job, b, "spectrum", I_w_b, spectral_size, OPSD_WRITE_SNAPSHOT);
+
+            MKL_Complex8 *S_plain = NULL;
+            if (smooth & OPSD_SMOOTH)
+                S_plain = job->mmap ? open_cproduct(job, b, "smooth", spectral_size) : S + offset;
+            if (real)
+                compute_cperiodic_component_P_fused_real(I_w_b, R_b, C_b, S_plain, rows, columns, layout);
+            else
+                compute_cperiodic_component_P_fused(I_w_b, R_b, C_b, S_plain, rows, columns, layout);
+
+            if (S_plain != NULL && job->mmap)
+                unmap_file(S_plain, spectral_size * sizeof(MKL_Complex8));
+            else if (S_plain != NULL)
+                save_cproduct(job, b, "smooth", S_plain, spectral_size, 0);
+            if (job->save && (products & OPSD_PERIODIC))
+                save_cproduct(job, b, "periodic", I_w_b, spectral_size, products & OPSD_FILTERED ? OPSD_WRITE_SNAPSHOT : 0);
+        }
+    }
+
+    if (plain && (products & OPSD_FILTERED))
+    {
+        if (real)
+            compute_cifft2d_real_batch(I_w, count, rows, columns, layout);
+        else
+            compute_cifft2d_batch(I_w, count, rows, columns, layout);
+
+        if (job->save)
+        {
+            if (!real && !job->mmap)
+                aux = workspace->filtered;
+            for (size_t b = 0; b < count; b++)
+                save_cfiltered(job, b, I_w + b * spectral_size, aux != NULL ? aux + b * size : NULL, lines, length);
+        }
+    }
+
+    // The writer may still be reading the buffers
+    if (job->writer != NULL)
+        writer_drain(job->writer);
+
+    scratch_release(plan, mark);
+}
+
+void run_cpipeline(const opsd_job *job)
+{
+    size_t lines = job->layout == OPSD_ROW_MAJOR ? job->rows : job->columns, length = job->rows * job->columns / lines;
+    size_t spectral_size = job->domain == OPSD_REAL ? lines * (length / 2 + 1) : job->rows * job->columns;
+
+    MKL_Complex8 *I_t = NULL;
+    float *staging = NULL;
+    opsd_workspace workspace;
+    init_cvector(&I_t, job->count * spectral_size);
+
+    // One staging buffer for every image of the job, gone before the workspace
+    size_t sizes[3];
+    int modulated;
+    workspace_sizes(job, &sizes[0], &sizes[1], &sizes[2], &modulated);
+    if (job->domain == OPSD_COMPLEX && !job->mmap && !strcmp(job->input, "rb"))
+        init_fvector(&staging, job->rows * job->columns);
+    for (size_t b = 0; b < job->count; b++)
+        load_cinput(job, b, I_t + b * spectral_size, staging, lines, length, modulated);
+    if (staging != NULL)
+        free_fvector(staging);
+
+    init_cworkspace(job, &workspace);
+    run_cimages(job, I_t, &workspace);
+    free_cworkspace(&workspace);
+
+    free_cvector(I_t);
+}
+
+//ZVECTOR PIPELINE
+
+static void save_zproduct(const opsd_job *job, size_t image, const char *name, MKL_Complex16 *vector, size_t size, int flags)
+{
+    char filepath[1024];
+    product_path(filepath, sizeof(filepath), job, image, name);
+
+    if (job->mmap)
+    {
+        MKL_Complex16 *map = map_output_file(filepath, size * sizeof(MKL_Complex16));
+        cblas_zcopy(size, vector, 1, map, 1);
+        unmap_file(map, size * sizeof(MKL_Complex16));
+    }
+    else if (job->writer != NULL)
+    {
+        writer_submit(job->writer, filepath, vector, size * sizeof(MKL_Complex16), flags);
+    }
+    else
+    {
+        save_zvector_on_bin(filepath, vector, size);
+    }
+}
+
+static MKL_Complex16 *open_zproduct(const opsd_job *job, size_t image, const char *name, size_t size)
+{
+    char filepath[1024];
+    product_path(filepath, sizeof(filepath), job, image, name);
+    return map_output_file(filepath, size * sizeof(MKL_Complex16));
+}
+
+static void save_zfiltered(const opsd_job *job, size_t image, MKL_Complex16 *I_t, double *aux, size_t lines, size_t length)
+{
+    size_t size = lines * length;
+    char filepath[1024];
+    product_path(filepath, sizeof(filepath), job, image, "data_filtered");
+
+    if (job->mmap)
+    {
+        double *map = map_output_file(filepath, size * sizeof(double));
+        if (job->domain == OPSD_REAL)
+            compact_dvector_rows_to(map, (double *)I_t, lines, length);
+        else
+            copy_zvector_to_real_dvector(I_t, map, size);
+        unmap_file(map, size * sizeof(double));
+        return;
+    }
+
+    double *filtered = (double *)I_t;
+    if (job->domain == OPSD_REAL)
+    {
+        compact_dvector_rows(filtered, lines, length);
+    }
+    else
+    {
+        copy_zvector_to_real_dvector(I_t, aux, size);
+        filtered = aux;
+    }
+
+    if (job->writer != NULL)
+        writer_submit(job->writer, filepath, filtered, size * sizeof(double), 0);
+    else
+        save_dvector_on_bin(filepath, filtered, size);
+}
+
+static void load_zinput(const opsd_job *job, size_t image, MKL_Complex16 *I_t, double *staging, size_t lines, size_t length, int modulated)
+{
+    size_t size = job->rows * job->columns;
+    char filepath[1024];
+    product_path(filepath, sizeof(filepath), job, image, "data");
+
+    if (job->mmap && !strcmp(job->input, "rb"))
+    {
+        double *map = map_input_file(filepath, size * sizeof(double));
+        if (job->domain == OPSD_REAL && modulated)
+            pad_dvector_rows_from_modulated((double *)I_t, map, lines, length);
+        else if (job->domain == OPSD_REAL)
+            pad_dvector_rows_from((double *)I_t, map, lines, length);
+        else if (modulated)
+            copy_dvector_to_zvector_modulated(I_t, map, lines, length);
+        else
+            copy_dvector_to_zvector(I_t, map, size);
+        unmap_file(map, size * sizeof(double));
+    }
+    else if (job->domain == OPSD_REAL)
+    {
+        if (!strcmp(job->input, "rb"))
+            read_dvector_bin(filepath, (double *)I_t, size);
+        else
+            fill_dmatrix((double *)I_t, job->rows, job->columns, job->seed + image);
+        if (modulated)
+            pad_dvector_rows_modulated((double *)I_t, lines, length);
+        else
+            pad_dvector_rows((double *)I_t, lines, length);
+    }
+    else
+    {
+        if (!strcmp(job->input, "rb"))
+        {
+            read_dvector_bin(filepath, staging, size);
+            if (modulated)
+                copy_dvector_to_zvector_modulated(I_t, staging, lines, length);
+            else
+                copy_dvector_to_zvector(I_t, staging, size);
+        }
+        else
+        {
+            fill_zmatrix(I_t, job->rows, job->columns, job->seed + image);
+        }
+    }
+}
+
+void init_zworkspace(const opsd_job *job, opsd_workspace *workspace)
+{
+    size_t sizes[3];
+    MKL_Complex16 *W = NULL, *S = NULL;
+    double *filtered = NULL;
+    workspace_sizes(job, &sizes[0], &sizes[1], &sizes[2], &workspace->modulated);
+    if (sizes[0])
+        init_zvector(&W, sizes[0]);
+    if (sizes[1])
+        init_zvector(&S, sizes[1]);
+    if (sizes[2])
+        init_dvector(&filtered, sizes[2]);
+
+    workspace->W = W;
+    workspace->S = S;
+    workspace->filtered = filtered;
+}
+
+void free_zworkspace(opsd_workspace *workspace)
+{
+    if (workspace->filtered != NULL)
+        free_dvector(workspace->filtered);
+    if (workspace->S != NULL)
+        free_zvector(workspace->S);
+    if (workspace->W != NULL)
+        free_zvector(workspace->W);
+}
+
+void run_zimages(const opsd_job *job, MKL_Complex16 *I_t, opsd_workspace *workspace)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns, count = job->count;
+    opsd_layout layout = job->layout;
+    unsigned products = job->products;
+    int real = job->domain == OPSD_REAL;
+
+    // The real path keeps length / 2 + 1 elements of the spectrum of each contiguous line
+    size_t lines = layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    size_t spectral_size = real ? lines * (length / 2 + 1) : size;
+
+    // Batches always take the plain transform and center it into W
+    int plain = (products & OPSD_PLAIN_PRODUCTS) != 0;
+    int shifted = (products & OPSD_SHIFTED_PRODUCTS) != 0;
+    int centered_in_place = count == 1 && (real ? lines % 2 == 0 : rows % 2 == 0 && columns % 2 == 0);
+    unsigned smooth = job->save ? products & (OPSD_SMOOTH | OPSD_SMOOTH_SHIFTED) : 0;
+
+    // The border only survives as its two edge spectra. W holds the centered
+    // spectrum whenever it cannot replace the plain one in place
+    opsd_plan *plan = job_plan(job, OPSD_DOUBLE);
+    size_t mark = scratch_mark(plan);
+    MKL_Complex16 *W = workspace->W, *S = NULL;
+    double *aux = NULL;
+    MKL_Complex16 *R = scratch_alloc(plan, count * columns * sizeof(MKL_Complex16));
+    MKL_Complex16 *C = scratch_alloc(plan, count * rows * sizeof(MKL_Complex16));
+
+    for (size_t b = 0; b < count; b++)
+    {
+        if (real && workspace->modulated)
+            compute_zborder_edges_real_modulated(I_t + b * spectral_size, R + b * columns, C + b * rows, rows, columns, layout);
+        else if (real)
+            compute_zborder_edges_real(I_t + b * spectral_size, R + b * columns, C + b * rows, rows, columns, layout);
+        else if (workspace->modulated)
+            compute_zborder_edges_modulated(I_t + b * spectral_size, R + b * columns, C + b * rows, rows, columns, layout);
+        else
+            compute_zborder_edges(I_t + b * spectral_size, R + b * columns, C + b * rows, rows, columns, layout);
+    }
+
+    // The single forward FFT of the run
+    MKL_Complex16 *I_w = I_t, *I_w_shifted = NULL;
+    if (workspace->modulated)
+    {
+        if (real)
+            compute_zfft2d_real_modulated(I_t, rows, columns, layout);
+        else
+            compute_zfft2d_modulated(I_t, rows, columns, layout);
+        I_w_shifted = I_t;
+    }
+    else if (!plain && count == 1 && (W == NULL || !centered_in_place))
+    {
+        if (real)
+            I_w_shifted = compute_zfft2d_real_shifted(I_t, W, rows, columns, layout);
+        else
+            I_w_shifted = compute_zfft2d_shifted(I_t, W, rows, columns, layout);
+    }
+    else
+    {
+        if (real)
+            compute_zfft2d_real_batch(I_t, count, rows, columns, layout);
+        else
+            compute_zfft2d_batch(I_t, count, rows, columns, layout);
+
+        if (shifted)
+        {
+            for (size_t b = 0; b < count; b++)
+            {
+                if (real)
+                    compute_zfftshift_real(I_w + b * spectral_size, W + b * spectral_size, rows, columns, layout);
+                else
+                    compute_zfftshift(I_w + b * spectral_size, W + b * spectral_size, rows, columns, layout);
+            }
+            I_w_shifted = W;
+        }
+    }
+
+    // S is stored just to be saved: mapped runs compute it straight into its
+    // file, otherwise I_t is free when only the centered spectrum went to W
+    if (smooth && !job->mmap)
+    {
+        if (!plain && I_w_shifted != I_t)
+            S = I_t;
+        else
+            S = workspace->S;
+    }
+
+    for (size_t b = 0; b < count; b++)
+    {
+        size_t offset = b * spectral_size;
+        MKL_Complex16 *R_b = R + b * columns, *C_b = C + b * rows;
+
+        if (shifted)
+        {
+            MKL_Complex16 *I_w_b = I_w_shifted + offset;
+            if (job->save && (products & OPSD_SPECTRUM_SHIFTED))
+                save_zproduct(job, b, "spectrum_shifted", I_w_b, spectral_size, OPSD_WRITE_SNAPSHOT);
+
+            MKL_Complex16 *S_shifted = NULL;
+            if (smooth & OPSD_SMOOTH_SHIFTED)
+                S_shifted = job->mmap ? open_zproduct(job, b, "smooth_shifted", spectral_size) : S + offset;
+            if (real)
+                compute_zperiodic_component_P_fused_real_shifted(I_w_b, R_b, C_b, S_shifted, rows, columns, layout);
+            else
+                compute_zperiodic_component_P_fused_shifted(I_w_b, R_b, C_b, S_shifted, rows, columns, layout);
+
+            if (S_shifted != NULL && job->mmap)
+                unmap_file(S_shifted, spectral_size * sizeof(MKL_Complex16));
+            else if (S_shifted != NULL)
+                save_zproduct(job, b, "smooth_shifted", S_shifted, spectral_size, smooth & OPSD_SMOOTH ? OPSD_WRITE_SNAPSHOT : 0);
+            if (job->save && (products & OPSD_PERIODIC_SHIFTED))
+                save_zproduct(job, b, "periodic_shifted", I_w_b, spectral_size, 0);
+        }
+
+        if (plain)
+        {
+            MKL_Complex16 *I_w_b = I_w + offset;
+            if (job->save && (products & OPSD_SPECTRUM))
+                save_zproduct(job, b, "spectrum", I_w_b, spectral_size, OPSD_WRITE_SNAPSHOT);
+
+            MKL_Complex16 *S_plain = NULL;
+            if (smooth & OPSD_SMOOTH)
+                S_plain = job->mmap ? open_zproduct(job, b, "smooth", spectral_size) : S + offset;
+            if (real)
+                compute_zperiodic_component_P_fused_real(I_w_b, R_b, C_b, S_plain, rows, columns, layout);
+            else
+                compute_zperiodic_component_P_fused(I_w_b, R_b, C_b, S_plain, rows, columns, layout);
+
+            if (S_plain != NULL && job->mmap)
+                unmap_file(S_plain, spectral_size * sizeof(MKL_Complex16));
+            else if (S_plain != NULL)
+                save_zproduct(job, b, "smooth", S_plain, spectral_size, 0);
+            if (job->save && (products & OPSD_PERIODIC))
+                save_zproduct(job, b, "periodic", I_w_b, spectral_size, products & OPSD_FILTERED ? OPSD_WRITE_SNAPSHOT : 0);
+        }
+    }
+
+    if (plain && (products & OPSD_FILTERED))
+    {
+        if (real)
+            compute_zifft2d_real_batch(I_w, count, rows, columns, layout);
+        else
+            compute_zifft2d_batch(I_w, count, rows, columns, layout);
+
+        if (job->save)
+        {
+            if (!real && !job->mmap)
+                aux = workspace->filtered;
+            for (size_t b = 0; b < count; b++)
+                save_zfiltered(job, b, I_w + b * spectral_size, aux != NULL ? aux + b * size : NULL, lines, length);
+        }
+    }
+
+    // The writer may still be reading the buffers
+    if (job->writer != NULL)
+        writer_drain(job->writer);
+
+    scratch_release(plan, mark);
+}
+
+void run_zpipeline(const opsd_job *job)
+{
+    size_t lines = job->layout == OPSD_ROW_MAJOR ? job->rows : job->columns, length = job->rows * job->columns / lines;
+    size_t spectral_size = job->domain == OPSD_REAL ? lines * (length / 2 + 1) : job->rows * job->columns;
+
+    MKL_Complex16 *I_t = NULL;
+    double *staging = NULL;
+    opsd_workspace workspace;
+    init_zvector(&I_t, job->count * spectral_size);
+
+    // One staging buffer for every image of the job, gone before the workspace
+    size_t sizes[3];
+    int modulated;
+    workspace_sizes(job, &sizes[0], &sizes[1], &sizes[2], &modulated);
+    if (job->domain == OPSD_COMPLEX && !job->mmap && !strcmp(job->input, "rb"))
+        init_dvector(&staging, job->rows * job->columns);
+    for (size_t b = 0; b < job->count; b++)
+        load_zinput(job, b, I_t + b * spectral_size, staging, lines, length, modulated);
+    if (staging != NULL)
+        free_dvector(staging);
+
+    init_zworkspace(job, &workspace);
+    run_zimages(job, I_t, &workspace);
+    free_zworkspace(&workspace);
+
+    free_zvector(I_t);
+}
@@ -0,0 +1,396 @@
+#include "../include/plan.h"
+
+static opsd_plan *plans = NULL;
+
+static void check_status(MKL_LONG status, const char *what)
+{
+    if (status && !DftiErrorClass(status, DFTI_NO_ERROR))
+    {
+        printf("Error committing %s: %s\n", what, DftiErrorMessage(status));
+    }
+}
+
+static DFTI_DESCRIPTOR_HANDLE create_fft2d(enum DFTI_CONFIG_VALUE precision, size_t rows, size_t columns, size_t count)
+{
+    DFTI_DESCRIPTOR_HANDLE desc_handle = NULL;
+    MKL_LONG dim_sizes[2] = {rows, columns};
+
+    DftiCreateDescriptor(&desc_handle, precision, DFTI_COMPLEX, 2, dim_sizes);
+    if (count > 1)
+    {
+        DftiSetValue(desc_handle, DFTI_NUMBER_OF_TRANSFORMS, count);
+        DftiSetValue(desc_handle, DFTI_INPUT_DISTANCE, rows * columns);
+        DftiSetValue(desc_handle, DFTI_OUTPUT_DISTANCE, rows * columns);
+    }
+    check_status(DftiCommitDescriptor(desc_handle), "2D descriptor");
+
+    return desc_handle;
+}
+
+// In-place R2C (forward) or C2R (backward) transform over rows padded to
+// 2 * (columns / 2 + 1) reals. The strides differ between the two directions,
+// which is why real plans are kept per direction. Batched images are
+// rows * 2 * (columns / 2 + 1) reals apart.
+static DFTI_DESCRIPTOR_HANDLE create_fft2d_real(enum DFTI_CONFIG_VALUE precision, size_t rows, size_t columns,
+                                                opsd_direction direction, size_t count)
+{
+    DFTI_DESCRIPTOR_HANDLE desc_handle = NULL;
+    MKL_LONG dim_sizes[2] = {rows, columns};
+    MKL_LONG half = columns / 2 + 1;
+    MKL_LONG real_strides[3] = {0, 2 * half, 1};
+    MKL_LONG complex_strides[3] = {0, half, 1};
+
+    DftiCreateDescriptor(&desc_handle, precision, DFTI_REAL, 2, dim_sizes);
+    DftiSetValue(desc_handle, DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX);
+    DftiSetValue(desc_handle, DFTI_PLACEMENT, DFTI_INPLACE);
+    if (direction == OPSD_FORWARD)
+    {
+        DftiSetValue(desc_handle, DFTI_INPUT_STRIDES, real_strides);
+        DftiSetValue(desc_handle, DFTI_OUTPUT_STRIDES, complex_strides);
+    }
+    else
+    {
+        DftiSetValue(desc_handle, DFTI_INPUT_STRIDES, complex_strides);
+        DftiSetValue(desc_handle, DFTI_OUTPUT_STRIDES, real_strides);
+    }
+    if (count > 1)
+    {
+        DftiSetValue(desc_handle, DFTI_NUMBER_OF_TRANSFORMS, count);
+        DftiSetValue(desc_handle, DFTI_INPUT_DISTANCE, direction == OPSD_FORWARD ? 2 * half * rows : half * rows);
+        DftiSetValue(desc_handle, DFTI_OUTPUT_DISTANCE, direction == OPSD_FORWARD ? half * rows : 2 * half * rows);
+    }
+    check_status(DftiCommitDescriptor(desc_handle), "2D real descriptor");
+
+    return desc_handle;
+}
+
+// Batch of 1D transforms: 'howmany' transforms of 'length' points, 'stride'
+// apart inside a transform and 'distance' apart between transforms.
+static DFTI_DESCRIPTOR_HANDLE create_fft1d_batch(enum DFTI_CONFIG_VALUE precision, size_t length, size_t howmany,
+                                                 size_t stride, size_t distance)
+{
+    DFTI_DESCRIPTOR_HANDLE desc_handle = NULL;
+    MKL_LONG strides[2] = {0, stride};
+
+    DftiCreateDescriptor(&desc_handle, precision, DFTI_COMPLEX, 1, length);
+    DftiSetValue(desc_handle, DFTI_NUMBER_OF_TRANSFORMS, howmany);
+    DftiSetValue(desc_handle, DFTI_INPUT_STRIDES, strides);
+    DftiSetValue(desc_handle, DFTI_OUTPUT_STRIDES, strides);
+    if (howmany > 1)
+    {
+        DftiSetValue(desc_handle, DFTI_INPUT_DISTANCE, distance);
+        DftiSetValue(desc_handle, DFTI_OUTPUT_DISTANCE, distance);
+    }
+    check_status(DftiCommitDescriptor(desc_handle), "1D descriptor");
+
+    return desc_handle;
+}
+
+// v[k] = 1 - W^-k, W = exp(-i * 2 * PI / n): the transform of e_0 - e_(n-1)
+static void fill_ctwiddles(MKL_Complex8 *v, size_t n)
+{
+    // Calcular cada elemento de v usando a fórmula W^k = exp(-i * 2 * PI * k / M)
+    v[0].real = 0.00f;
+    v[0].imag = 0.00f;
+    for (size_t k = 1; k < n; k++)
+    {
+        float theta = -2.0f * PI * (n - k) / n;
+        v[k].real = 1.0f - cosf(theta);
+        v[k].imag = sinf(theta) * (-1);
+    }
+}
+
+static void fill_ztwiddles(MKL_Complex16 *v, size_t n)
+{
+    v[0].real = 0.00;
+    v[0].imag = 0.00;
+    for (size_t k = 1; k < n; k++)
+    {
+        double theta = -2.0 * PI * (n - k) / n;
+        v[k].real = 1.0 - cos(theta);
+        v[k].imag = sin(theta) * (-1);
+    }
+}
+
+static void build_ctables(opsd_plan *plan)
+{
+    size_t rows = plan->rows, columns = plan->columns;
+
+    MKL_Complex8 *v_rows = (MKL_Complex8 *)opsd_malloc(rows * sizeof(MKL_Complex8));
+    MKL_Complex8 *v_columns = (MKL_Complex8 *)opsd_malloc(columns * sizeof(MKL_Complex8));
+    float *denom_rows = (float *)opsd_malloc(rows * sizeof(float));
+    float *denom_columns = (float *)opsd_malloc(columns * sizeof(float));
+    if (v_rows == NULL || v_columns == NULL || denom_rows == NULL || denom_columns == NULL)
+    {
+        printf("Allocation error!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fill_ctwiddles(v_rows, rows);
+    fill_ctwiddles(v_columns, columns);
+
+    // 2cos(2PIi/M) + 2cos(2PIj/N) - 4 split as -4sin²(PIi/M) - 4sin²(PIj/N): the
+    // sum is symmetric in the two tables and does not cancel near (0, 0)
+    for (size_t i = 0; i < rows; i++)
+    {
+        float s = sinf(PI * i / rows);
+        denom_rows[i] = -4.0f * s * s;
+    }
+
+    for (size_t j = 0; j < columns; j++)
+    {
+        float s = sinf(PI * j / columns);
+        denom_columns[j] = -4.0f * s * s;
+    }
+
+    plan->v_rows = v_rows;
+    plan->v_columns = v_columns;
+    plan->denom_rows = denom_rows;
+    plan->denom_columns = denom_columns;
+}
+
+static void build_ztables(opsd_plan *plan)
+{
+    size_t rows = plan->rows, columns = plan->columns;
+
+    MKL_Complex16 *v_rows = (MKL_Complex16 *)opsd_malloc(rows * sizeof(MKL_Complex16));
+    MKL_Complex16 *v_columns = (MKL_Complex16 *)opsd_malloc(columns * sizeof(MKL_Complex16));
+    double *denom_rows = (double *)opsd_malloc(rows * sizeof(double));
+    double *denom_columns = (double *)opsd_malloc(columns * sizeof(double));
+    if (v_rows == NULL || v_columns == NULL || denom_rows == NULL || denom_columns == NULL)
+    {
+        printf("Allocation error!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fill_ztwiddles(v_rows, rows);
+    fill_ztwiddles(v_columns, columns);
+
+    for (size_t i = 0; i < rows; i++)
+    {
+        double s = sin(PI * i / rows);
+        denom_rows[i] = -4.0 * s * s;
+    }
+
+    for (size_t j = 0; j < columns; j++)
+    {
+        double s = sin(PI * j / columns);
+        denom_columns[j] = -4.0 * s * s;
+    }
+
+    plan->v_rows = v_rows;
+    plan->v_columns = v_columns;
+    plan->denom_rows = denom_rows;
+    plan->denom_columns = denom_columns;
+}
+
+static opsd_plan *create_plan(opsd_precision precision, opsd_domain domain, size_t rows, size_t columns, opsd_direction direction,
+                              size_t count)
+{
+    opsd_plan *plan = (opsd_plan *)opsd_calloc(1, sizeof(opsd_plan));
+    if (plan == NULL)
+    {
+        printf("Allocation error!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    plan->precision = precision;
+    plan->domain = domain;
+    plan->rows = rows;
+    plan->columns = columns;
+    plan->direction = direction;
+    plan->count = count;
+
+    enum DFTI_CONFIG_VALUE dfti_precision = precision == OPSD_SINGLE ? DFTI_SINGLE : DFTI_DOUBLE;
+
+    if (domain == OPSD_REAL)
+        plan->fft2d = create_fft2d_real(dfti_precision, rows, columns, direction, count);
+    else
+        plan->fft2d = create_fft2d(dfti_precision, rows, columns, count);
+
+    if (count > 1)
+        return plan;
+
+    // Steps C and D only run on the forward side of the routine
+    if (direction == OPSD_FORWARD && domain == OPSD_COMPLEX)
+    {
+        plan->fft_columns = create_fft1d_batch(dfti_precision, rows, columns, columns, 1);
+        plan->fft_rows = create_fft1d_batch(dfti_precision, columns, rows, 1, columns);
+        plan->fft_column = create_fft1d_batch(dfti_precision, rows, 1, columns, 0);
+    }
+
+    if (direction == OPSD_FORWARD)
+    {
+        plan->fft_edge_row = create_fft1d_batch(dfti_precision, columns, 1, 1, 0);
+        plan->fft_edge_column = create_fft1d_batch(dfti_precision, rows, 1, 1, 0);
+
+        if (precision == OPSD_SINGLE)
+            build_ctables(plan);
+        else
+            build_ztables(plan);
+    }
+
+    return plan;
+}
+
+// Out-of-core slabs: count transforms of length points stored one after
+// another. Real slabs are R2C rows padded to 2 * (length / 2 + 1) reals, or
+// the C2R back into them. Not cached: the caller frees them with
+// DftiFreeDescriptor.
+DFTI_DESCRIPTOR_HANDLE create_slab_fft(opsd_precision precision, opsd_domain domain, size_t length, size_t count,
+                                       opsd_direction direction)
+{
+    enum DFTI_CONFIG_VALUE dfti_precision = precision == OPSD_SINGLE ? DFTI_SINGLE : DFTI_DOUBLE;
+    if (domain == OPSD_COMPLEX)
+        return create_fft1d_batch(dfti_precision, length, count, 1, length);
+
+    DFTI_DESCRIPTOR_HANDLE desc_handle = NULL;
+    MKL_LONG half = length / 2 + 1;
+
+    DftiCreateDescriptor(&desc_handle, dfti_precision, DFTI_REAL, 1, length);
+    DftiSetValue(desc_handle, DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX);
+    DftiSetValue(desc_handle, DFTI_PLACEMENT, DFTI_INPLACE);
+    if (count > 1)
+    {
+        DftiSetValue(desc_handle, DFTI_NUMBER_OF_TRANSFORMS, count);
+        DftiSetValue(desc_handle, DFTI_INPUT_DISTANCE, direction == OPSD_FORWARD ? 2 * half : half);
+        DftiSetValue(desc_handle, DFTI_OUTPUT_DISTANCE, direction == OPSD_FORWARD ? half : 2 * half);
+    }
+    check_status(DftiCommitDescriptor(desc_handle), "1D real descriptor");
+
+    return desc_handle;
+}
+
+// Spilled buffers keep their offset in the stack and a link in front of the data
+typedef struct scratch_spill
+{
+    struct scratch_spill *next;
+    size_t offset;
+} __attribute__((aligned(OPSD_ALIGNMENT))) scratch_spill;
+
+void *scratch_alloc(opsd_plan *plan, size_t bytes)
+{
+    opsd_scratch *scratch = &plan->scratch;
+    size_t offset = scratch->top;
+    bytes = (bytes + OPSD_ALIGNMENT - 1) / OPSD_ALIGNMENT * OPSD_ALIGNMENT;
+
+    scratch->top += bytes;
+    if (scratch->top > scratch->peak)
+        scratch->peak = scratch->top;
+    if (scratch->top <= scratch->capacity)
+        return scratch->data + offset;
+
+    scratch_spill *spill = (scratch_spill *)opsd_malloc(sizeof(scratch_spill) + bytes);
+    if (spill == NULL)
+    {
+        printf("Allocation error!\n");
+        exit(EXIT_FAILURE);
+    }
+    spill->next = scratch->spilled;
+    spill->offset = offset;
+    scratch->spilled = spill;
+    return spill + 1;
+}
+
+size_t scratch_mark(const opsd_plan *plan)
+{
+    return plan->scratch.top;
+}
+
+void scratch_release(opsd_plan *plan, size_t mark)
+{
+    opsd_scratch *scratch = &plan->scratch;
+    while (scratch->spilled != NULL && ((scratch_spill *)scratch->spilled)->offset >= mark)
+    {
+        scratch_spill *spill = scratch->spilled;
+        scratch->spilled = spill->next;
+        opsd_free(spill);
+    }
+    scratch->top = mark;
+
+    // Nothing is handed out: the block can move
+    if (mark == 0 && scratch->peak > scratch->capacity)
+    {
+        opsd_free(scratch->data);
+        scratch->data = (char *)opsd_malloc(scratch->peak);
+        if (scratch->data == NULL)
+        {
+            printf("Allocation error!\n");
+            exit(EXIT_FAILURE);
+        }
+        scratch->capacity = scratch->peak;
+    }
+}
+
+opsd_plan *get_plan(opsd_precision precision, opsd_domain domain, size_t rows, size_t columns, opsd_direction direction)
+{
+    return get_batch_plan(precision, domain, rows, columns, direction, 1);
+}
+
+opsd_plan *get_batch_plan(opsd_precision precision, opsd_domain domain, size_t rows, size_t columns, opsd_direction direction,
+                          size_t count)
+{
+    opsd_plan *plan = NULL;
+
+#pragma omp critical(opsd_plans)
+    {
+        for (plan = plans; plan != NULL; plan = plan->next)
+        {
+            if (plan->precision == precision && plan->domain == domain && plan->rows == rows && plan->columns == columns &&
+                plan->direction == direction && plan->count == count)
+                break;
+        }
+
+        if (plan == NULL)
+        {
+            plan = create_plan(precision, domain, rows, columns, direction, count);
+            plan->next = plans;
+            plans = plan;
+        }
+    }
+
+    return plan;
+}
+
+static void free_scratch(opsd_scratch *scratch)
+{
+    while (scratch->spilled != NULL)
+    {
+        scratch_spill *spill = scratch->spilled;
+        scratch->spilled = spill->next;
+        opsd_free(spill);
+    }
+    opsd_free(scratch->data);
+}
+
+void destroy_plans(void)
+{
+#pragma omp critical(opsd_plans)
+    {
+        while (plans != NULL)
+        {
+            opsd_plan *plan = plans;
+            plans = plan->next;
+
+            if (plan->fft2d)
+                DftiFreeDescriptor(&plan->fft2d);
+            if (plan->fft_columns)
+                DftiFreeDescriptor(&plan->fft_columns);
+            if (plan->fft_rows)
+                DftiFreeDescriptor(&plan->fft_rows);
+            if (plan->fft_column)
+                DftiFreeDescriptor(&plan->fft_column);
+            if (plan->fft_edge_row)
+                DftiFreeDescriptor(&plan->fft_edge_row);
+            if (plan->fft_edge_column)
+                DftiFreeDescriptor(&plan->fft_edge_column);
+
+            opsd_free(plan->v_rows);
+            opsd_free(plan->v_columns);
+            opsd_free(plan->denom_rows);
+            opsd_free(plan->denom_columns);
+            free_scratch(&plan->scratch);
+            opsd_free(plan);
+        }
+    }
+}
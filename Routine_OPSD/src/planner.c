@@ -0,0 +1,363 @@
+#include "../include/planner.h"
+
+#define OPSD_MAX_VARIANTS 8
+
+//MACHINE PROFILE
+
+static int parse_stage(const char *name, opsd_stage *stage)
+{
+    for (int s = 0; s < OPSD_STAGE_LOAD; s++)
+    {
+        if (!strcmp(profile_stage_name(s), name))
+        {
+            *stage = s;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Lines that are not a compute stage of bench --csv are skipped
+void machine_load(opsd_machine *machine, const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        perror("Error opening file");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t capacity = 0;
+    char line[512];
+    machine->entries = NULL;
+    machine->count = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char stage[32], precision[16], domain[16], layout[16];
+        opsd_calibration entry;
+        if (sscanf(line, "%31[^,],%15[^,],%15[^,],%15[^,],%zu,%zu,%d,%*d,%*f,%lf", stage, precision, domain, layout,
+                   &entry.rows, &entry.columns, &entry.threads, &entry.median) != 8 ||
+            !parse_stage(stage, &entry.stage) || entry.median <= 0.0)
+            continue;
+
+        entry.precision = !strcmp(precision, "double") ? OPSD_DOUBLE : OPSD_SINGLE;
+        entry.domain = !strcmp(domain, "real") ? OPSD_REAL : OPSD_COMPLEX;
+        entry.layout = !strcmp(layout, "column") ? OPSD_COLUMN_MAJOR : OPSD_ROW_MAJOR;
+
+        if (machine->count == capacity)
+        {
+            capacity = capacity ? 2 * capacity : 64;
+            opsd_calibration *entries = opsd_realloc(machine->entries, capacity * sizeof(opsd_calibration));
+            if (entries == NULL)
+            {
+                printf("Allocation error!\n");
+                exit(EXIT_FAILURE);
+            }
+            machine->entries = entries;
+        }
+        machine->entries[machine->count++] = entry;
+    }
+
+    fclose(file);
+}
+
+void machine_free(opsd_machine *machine)
+{
+    opsd_free(machine->entries);
+    machine->entries = NULL;
+    machine->count = 0;
+}
+
+// Work a stage scales with: FLOPs of the full-size FFTs, bytes moved otherwise
+static double stage_work(opsd_stage stage, opsd_precision precision, opsd_domain domain, opsd_layout layout,
+                         size_t rows, size_t columns)
+{
+    double read, written, flops;
+    if (layout == OPSD_ROW_MAJOR)
+        profile_model(stage, precision, domain, rows, columns, &read, &written, &flops);
+    else
+        profile_model(stage, precision, domain, columns, rows, &read, &written, &flops);
+
+    if (stage == OPSD_STAGE_A_FFT2D || stage == OPSD_STAGE_A_FFT2D_SHIFTED || stage == OPSD_STAGE_IFFT2D)
+        return flops;
+    return read + written;
+}
+
+// The measure of the same layout, then of the closest thread count, then of
+// the closest size, scaled to rows x columns
+double machine_stage_time(const opsd_machine *machine, opsd_stage stage, opsd_precision precision, opsd_domain domain,
+                          opsd_layout layout, size_t rows, size_t columns, int threads)
+{
+    const opsd_calibration *best = NULL;
+    double best_score = 0.0;
+
+    for (size_t k = 0; k < machine->count; k++)
+    {
+        const opsd_calibration *entry = &machine->entries[k];
+        if (entry->stage != stage || entry->precision != precision || entry->domain != domain)
+            continue;
+
+        double score = (entry->layout != layout) * 1e6 + abs(entry->threads - threads) * 1e3 +
+                       fabs(log((double)entry->rows * entry->columns / ((double)rows * columns)));
+        if (best == NULL || score < best_score)
+        {
+            best = entry;
+            best_score = score;
+        }
+    }
+
+    if (best == NULL)
+        return -1.0;
+
+    double measured = stage_work(stage, precision, domain, best->layout, best->rows, best->columns);
+    double target = stage_work(stage, precision, domain, layout, rows, columns);
+    return measured > 0.0 ? best->median * target / measured : best->median;
+}
+
+//ESTIMATE
+
+// Same buffers and stages as run_cpipeline/run_zpipeline on one image
+void estimate_job(const opsd_job *job, opsd_precision precision, const opsd_machine *machine, opsd_estimate *estimate)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns;
+    unsigned products = job->products;
+    int real = job->domain == OPSD_REAL;
+    size_t lines = job->layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    size_t spectral_size = real ? lines * (length / 2 + 1) : size;
+    size_t complex_bytes = precision == OPSD_DOUBLE ? sizeof(MKL_Complex16) : sizeof(MKL_Complex8);
+    size_t real_bytes = precision == OPSD_DOUBLE ? sizeof(double) : sizeof(float);
+    size_t spectrum = spectral_size * complex_bytes;
+
+    int plain = (products & OPSD_PLAIN_PRODUCTS) != 0;
+    int shifted = (products & OPSD_SHIFTED_PRODUCTS) != 0;
+    int filtered = (products & OPSD_FILTERED) != 0;
+    int centered_in_place = real ? lines % 2 == 0 : rows % 2 == 0 && columns % 2 == 0;
+    unsigned smooth = job->save ? products & (OPSD_SMOOTH | OPSD_SMOOTH_SHIFTED) : 0;
+    int rb = !strcmp(job->input, "rb");
+
+    memset(estimate, 0, sizeof(opsd_estimate));
+
+    // Loading: I_t, plus the staging buffer of complex input read from data.bin
+    size_t load = spectrum + (!real && rb && !job->mmap ? size * real_bytes : 0);
+
+    // Computing: I_t, the edge spectra, W when the centered spectrum cannot
+    // replace the plain one in place, S unless it reuses I_t, and the plans
+    size_t compute = spectrum + (rows + columns) * complex_bytes;
+    int centered_apart = shifted && (plain || !centered_in_place);
+    if (centered_apart)
+        compute += spectrum;
+    if (smooth && !job->mmap && (plain || !centered_apart))
+        compute += spectrum;
+    compute += sizeof(opsd_plan) + (rows + columns) * (complex_bytes + real_bytes);
+    if (filtered)
+        compute += sizeof(opsd_plan);
+
+    // Writer entries and snapshots of the buffers later stages overwrite, all
+    // still queued at worst, and the real copy of the complex filtered image.
+    // Written entries kept as spares never outnumber the queue counted here
+    if (job->save && !job->mmap)
+    {
+        for (unsigned product = OPSD_SPECTRUM; product <= OPSD_FILTERED; product <<= 1)
+            compute += (products & product) ? sizeof(opsd_write) : 0;
+        size_t snapshots = ((products & OPSD_SPECTRUM_SHIFTED) != 0) + ((smooth & OPSD_SMOOTH_SHIFTED) && (smooth & OPSD_SMOOTH)) +
+                           ((products & OPSD_SPECTRUM) != 0) + ((products & OPSD_PERIODIC) && filtered);
+        compute += (snapshots < OPSD_WRITER_DEPTH ? snapshots : OPSD_WRITER_DEPTH) * spectrum;
+        if (filtered && !real)
+            compute += size * real_bytes;
+    }
+    estimate->peak = load > compute ? load : compute;
+
+    estimate->read = rb ? (double)size * real_bytes : 0.0;
+    if (job->save)
+    {
+        for (unsigned product = OPSD_SPECTRUM; product < OPSD_FILTERED; product <<= 1)
+            estimate->written += (products & product) ? spectrum : 0.0;
+        estimate->written += filtered ? (double)size * real_bytes : 0.0;
+    }
+
+    estimate->calls[OPSD_STAGE_B_EDGES] = 1;
+    if (!plain)
+    {
+        estimate->calls[OPSD_STAGE_A_FFT2D_SHIFTED] = 1;
+    }
+    else
+    {
+        estimate->calls[OPSD_STAGE_A_FFT2D] = 1;
+        estimate->calls[OPSD_STAGE_FFTSHIFT] = shifted;
+    }
+    estimate->calls[OPSD_STAGE_CDE_FUSED_SHIFTED] = shifted;
+    estimate->calls[OPSD_STAGE_CDE_FUSED] = plain;
+    estimate->calls[OPSD_STAGE_IFFT2D] = filtered;
+
+    for (int stage = 0; stage < OPSD_STAGE_LOAD; stage++)
+    {
+        if (!estimate->calls[stage])
+            continue;
+
+        double time = machine != NULL ? machine_stage_time(machine, stage, precision, job->domain, job->layout, rows, columns,
+                                                           omp_get_max_threads())
+                                      : -1.0;
+        estimate->time[stage] = time < 0.0 ? -1.0 : estimate->calls[stage] * time;
+        if (time < 0.0 || estimate->total < 0.0)
+            estimate->total = -1.0;
+        else
+            estimate->total += estimate->time[stage];
+    }
+}
+
+//DRY RUN
+
+typedef struct
+{
+    char name[64];
+    opsd_estimate estimate;
+} opsd_variant;
+
+// ccr, cts and css making up a product mask, with the r prefix of the real path
+static void routine_name(char *name, size_t length, unsigned products, opsd_domain domain)
+{
+    const char *prefix = domain == OPSD_REAL ? "r" : "";
+    const char *plain = products & OPSD_FILTERED ? "ccr" : "cts";
+
+    if ((products & OPSD_PLAIN_PRODUCTS) && (products & OPSD_SHIFTED_PRODUCTS))
+        snprintf(name, length, "%s%s,%scss", prefix, plain, prefix);
+    else if (products & OPSD_PLAIN_PRODUCTS)
+        snprintf(name, length, "%s%s", prefix, plain);
+    else
+        snprintf(name, length, "%scss", prefix);
+}
+
+// Plain and centered products in two runs: each one reads data.bin and runs
+// its own forward FFT, but never holds both spectra
+static void estimate_split(const opsd_job *job, opsd_precision precision, const opsd_machine *machine, opsd_estimate *estimate)
+{
+    opsd_job part = *job;
+    opsd_estimate shifted;
+
+    part.products = job->products & OPSD_PLAIN_PRODUCTS;
+    estimate_job(&part, precision, machine, estimate);
+    part.products = job->products & OPSD_SHIFTED_PRODUCTS;
+    estimate_job(&part, precision, machine, &shifted);
+
+    estimate->peak = estimate->peak > shifted.peak ? estimate->peak : shifted.peak;
+    estimate->read += shifted.read;
+    estimate->written += shifted.written;
+    for (int stage = 0; stage < OPSD_STAGE_LOAD; stage++)
+    {
+        estimate->calls[stage] += shifted.calls[stage];
+        estimate->time[stage] = estimate->time[stage] < 0.0 || shifted.time[stage] < 0.0 ? -1.0
+                                                                                        : estimate->time[stage] + shifted.time[stage];
+    }
+    estimate->total = estimate->total < 0.0 || shifted.total < 0.0 ? -1.0 : estimate->total + shifted.total;
+}
+
+static void print_time(double seconds)
+{
+    if (seconds < 0.0)
+        printf(" %11s", "-");
+    else
+        printf(" %11.4f", seconds);
+}
+
+void run_dry_run(const opsd_job *job, opsd_precision precision, const char *machine_file, double budget)
+{
+    opsd_machine machine = {NULL, 0};
+    if (machine_file != NULL)
+        machine_load(&machine, machine_file);
+    const opsd_machine *calibration = machine_file != NULL ? &machine : NULL;
+
+    // The requested job first, then the r routines (CCE spectra), --mmap and
+    // separate runs of the plain and centered products
+    opsd_variant variants[OPSD_MAX_VARIANTS];
+    size_t count = 0;
+    int split_products = (job->products & OPSD_PLAIN_PRODUCTS) && (job->products & OPSD_SHIFTED_PRODUCTS);
+    int mappable = job->save || !strcmp(job->input, "rb");
+
+    for (int real = job->domain == OPSD_REAL; real < 2; real++)
+    {
+        for (int split = 0; split <= split_products; split++)
+        {
+            for (int mapped = job->mmap; mapped <= (mappable ? 1 : job->mmap); mapped++)
+            {
+                opsd_job variant = *job;
+                variant.domain = real ? OPSD_REAL : OPSD_COMPLEX;
+                variant.mmap = mapped;
+
+                opsd_variant *v = &variants[count++];
+                char plain[16], shifted[16];
+                if (split)
+                {
+                    routine_name(plain, sizeof(plain), job->products & OPSD_PLAIN_PRODUCTS, variant.domain);
+                    routine_name(shifted, sizeof(shifted), job->products & OPSD_SHIFTED_PRODUCTS, variant.domain);
+                    snprintf(v->name, sizeof(v->name), "%s then %s%s", plain, shifted, mapped ? " --mmap" : "");
+                    estimate_split(&variant, precision, calibration, &v->estimate);
+                }
+                else
+                {
+                    routine_name(plain, sizeof(plain), job->products, variant.domain);
+                    snprintf(v->name, sizeof(v->name), "%s%s", plain, mapped ? " --mmap" : "");
+                    estimate_job(&variant, precision, calibration, &v->estimate);
+                }
+            }
+        }
+    }
+
+    const opsd_estimate *requested = &variants[0].estimate;
+    printf("Dry run: %zux%zu %s %s, %s-major, save %s, input %s, %d threads\n", job->rows, job->columns, variants[0].name,
+           precision == OPSD_DOUBLE ? "double" : "single", job->layout == OPSD_ROW_MAJOR ? "row" : "column",
+           job->save ? "yes" : "no", job->input, omp_get_max_threads());
+    if (calibration != NULL)
+        printf("Machine profile: %s, %zu measures\n", machine_file, machine.count);
+    else
+        printf("Machine profile: none, stage times need --machine <bench csv>\n");
+
+    printf("\n%-18s %7s %11s\n", "stage", "calls", "time (s)");
+    for (int stage = 0; stage < OPSD_STAGE_LOAD; stage++)
+    {
+        if (!requested->calls[stage])
+            continue;
+        printf("%-18s %7zu", profile_stage_name(stage), requested->calls[stage]);
+        print_time(requested->time[stage]);
+        printf("\n");
+    }
+    printf("%-18s %7s", "compute", "");
+    print_time(requested->total);
+    printf("\n");
+
+    // Unknown stage times leave only the memory to rank the variants
+    int timed = 1;
+    for (size_t k = 0; k < count; k++)
+        timed = timed && variants[k].estimate.total >= 0.0;
+
+    const opsd_variant *best = NULL, *smallest = NULL;
+    printf("\n%-24s %10s %10s %12s %11s\n", "variant", "peak (MB)", "read (MB)", "written (MB)", "compute (s)");
+    for (size_t k = 0; k < count; k++)
+    {
+        const opsd_estimate *e = &variants[k].estimate;
+        printf("%-24s %10.1f %10.1f %12.1f", variants[k].name, e->peak / 1e6, e->read / 1e6, e->written / 1e6);
+        print_time(e->total);
+        printf("%s\n", e->peak > budget ? "  over budget" : "");
+
+        if (smallest == NULL || e->peak < smallest->estimate.peak)
+            smallest = &variants[k];
+        if (e->peak > budget)
+            continue;
+        // Ties, as with --mmap whose I/O is not timed, go to the smaller peak
+        if (best == NULL || (timed && e->total < best->estimate.total) ||
+            ((!timed || e->total == best->estimate.total) && e->peak < best->estimate.peak))
+            best = &variants[k];
+    }
+
+    if (best == NULL)
+        printf("\nNo variant fits in %.3g GB: the smallest, %s, peaks at %.1f MB\n", budget / 1e9, smallest->name,
+               smallest->estimate.peak / 1e6);
+    else if (timed)
+        printf("\nRecommended: %s, %.4f s of compute and %.1f MB peak (budget %.3g GB)\n", best->name, best->estimate.total,
+               best->estimate.peak / 1e6, budget / 1e9);
+    else
+        printf("\nRecommended: %s, the smallest peak at %.1f MB (budget %.3g GB), without stage times to rank by\n",
+               best->name, best->estimate.peak / 1e6, budget / 1e9);
+
+    if (calibration != NULL)
+        machine_free(&machine);
+}
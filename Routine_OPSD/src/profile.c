@@ -0,0 +1,583 @@
+#include "../include/profile.h"
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <errno.h>
+#include <stdint.h>
+
+// Bounds the trace of long stream or server runs: ~48 MB of events
+#define OPSD_TRACE_EVENTS (1 << 20)
+
+// Deepest nesting of compute stages measured on one thread
+#define OPSD_STAGE_DEPTH 8
+
+int opsd_profiling = 0;
+
+#ifdef OPSD_ITT
+__itt_domain *opsd_itt_domain = NULL;
+__itt_string_handle *opsd_itt_stages[OPSD_STAGE_COUNT];
+#endif
+
+static opsd_stage_stats stage_stats[OPSD_STAGE_COUNT];
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *stage_names[OPSD_STAGE_COUNT] = {
+    "A_fft2d", "B_border", "B_edges", "C_fft_border", "D_smooth", "E_periodic",
+    "CDE_fused", "A_fft2d_shifted", "CDE_fused_shifted", "fftshift", "ifft2d",
+    "load", "save"};
+
+// One span of the timeline. Thread records (name == NULL) name a thread the
+// first time it records a span.
+typedef struct
+{
+    const char *name, *category;
+    double start, end;
+    long tid;
+    int thread;
+} opsd_trace_event;
+
+static opsd_trace_event *trace_events = NULL;
+static size_t trace_count = 0, trace_capacity = 0, trace_dropped = 0;
+static double trace_origin = 0.0;
+static char trace_path[1024];
+static __thread long trace_tid = 0;
+
+static void profile_exit(void)
+{
+    profile_report(stderr);
+}
+
+void profile_enable(void)
+{
+    static int registered = 0;
+
+    opsd_profiling |= OPSD_PROFILE_STATS;
+    if (!registered)
+    {
+        registered = 1;
+        atexit(profile_exit);
+    }
+}
+
+static void trace_record(opsd_trace_event event)
+{
+    if (trace_count == trace_capacity)
+    {
+        size_t capacity = trace_capacity ? 2 * trace_capacity : 4096;
+        opsd_trace_event *events = capacity <= OPSD_TRACE_EVENTS ? realloc(trace_events, capacity * sizeof(*events)) : NULL;
+        if (events == NULL)
+        {
+            trace_dropped++;
+            return;
+        }
+        trace_events = events;
+        trace_capacity = capacity;
+    }
+    trace_events[trace_count++] = event;
+}
+
+void trace_event(const char *name, const char *category, double start, double end)
+{
+    int named = trace_tid != 0;
+    if (!named)
+        trace_tid = syscall(SYS_gettid);
+
+    pthread_mutex_lock(&stats_lock);
+    if (!named)
+        trace_record((opsd_trace_event){NULL, NULL, start, start, trace_tid, omp_in_parallel() ? omp_get_thread_num() : -1});
+    trace_record((opsd_trace_event){name, category, start, end, trace_tid, 0});
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev): one complete
+// event per span, in microseconds since tracing started
+static void trace_write(void)
+{
+    FILE *file = fopen(trace_path, "w");
+    if (file == NULL)
+    {
+        perror("Erro ao abrir o arquivo de trace");
+        return;
+    }
+
+    long pid = getpid();
+    pthread_mutex_lock(&stats_lock);
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped_events\": %zu},\n\"traceEvents\": [\n", trace_dropped);
+    fprintf(file, "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": %ld, \"args\": {\"name\": \"opsd\"}}", pid);
+    for (size_t i = 0; i < trace_count; i++)
+    {
+        opsd_trace_event *event = &trace_events[i];
+        if (event->name == NULL)
+        {
+            char thread[32];
+            if (event->tid == pid)
+                snprintf(thread, sizeof(thread), "main");
+            else if (event->thread >= 0)
+                snprintf(thread, sizeof(thread), "omp %d", event->thread);
+            else
+                snprintf(thread, sizeof(thread), "thread %ld", event->tid);
+            fprintf(file, ",\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": %ld, \"tid\": %ld, \"args\": {\"name\": \"%s\"}}",
+                    pid, event->tid, thread);
+        }
+        else
+            fprintf(file, ",\n{\"ph\": \"X\", \"name\": \"%s\", \"cat\": \"%s\", \"pid\": %ld, \"tid\": %ld, \"ts\": %.3f, \"dur\": %.3f}",
+                    event->name, event->category, pid, event->tid, (event->start - trace_origin) * 1e6,
+                    (event->end - event->start) * 1e6);
+    }
+    fprintf(file, "\n]}\n");
+    pthread_mutex_unlock(&stats_lock);
+    fclose(file);
+
+    fprintf(stderr, "Trace: %zu events written to %s\n", trace_count, trace_path);
+    if (trace_dropped)
+        fprintf(stderr, "Trace: %zu events dropped\n", trace_dropped);
+}
+
+void trace_enable(const char *path)
+{
+    static int registered = 0;
+
+    snprintf(trace_path, sizeof(trace_path), "%s", path);
+    if (!registered)
+    {
+        registered = 1;
+        trace_origin = omp_get_wtime();
+        atexit(trace_write);
+    }
+    opsd_profiling |= OPSD_PROFILE_TRACE;
+}
+
+static const char *counter_names[OPSD_COUNTER_COUNT] = {"cycles", "instructions", "LLC misses", "dTLB misses", "node loads",
+                                                         "node misses"};
+static int counter_opened[OPSD_COUNTER_COUNT];
+static int (*counter_fds)[OPSD_COUNTER_COUNT] = NULL; // one row per thread counted
+static size_t counter_threads = 0, counter_capacity = 0;
+static int counter_team = 0;
+static __thread int counter_registered = 0;
+static __thread double counter_starts[OPSD_STAGE_DEPTH][OPSD_COUNTER_COUNT];
+static __thread int stage_windows[OPSD_STAGE_DEPTH];
+static __thread int stage_depth = 0;
+
+// Counts of the calling thread, user space only, which perf_event_paranoid <= 2 allows
+static int open_counter(opsd_counter counter)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (counter)
+    {
+    case OPSD_COUNTER_CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case OPSD_COUNTER_INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case OPSD_COUNTER_LLC_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    case OPSD_COUNTER_DTLB_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case OPSD_COUNTER_NODE_LOADS:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_NODE | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+        break;
+    default:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_NODE | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    }
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void register_thread(const int *fds)
+{
+    counter_registered = 1;
+
+    pthread_mutex_lock(&stats_lock);
+    if (counter_threads == counter_capacity)
+    {
+        size_t capacity = counter_capacity ? 2 * counter_capacity : 64;
+        int (*rows)[OPSD_COUNTER_COUNT] = realloc(counter_fds, capacity * sizeof(*rows));
+        if (rows == NULL)
+        {
+            printf("Allocation error!\n");
+            pthread_mutex_unlock(&stats_lock);
+            return;
+        }
+        counter_fds = rows;
+        counter_capacity = capacity;
+    }
+    memcpy(counter_fds[counter_threads++], fds, sizeof(counter_fds[0]));
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Inherited counters only report the threads that exited, and the OpenMP pool
+// outlives every stage: each pool thread opens its own counters instead, again
+// whenever the team grows (bench --threads), and a stage reads the sum. MKL's
+// threads are counted as long as they run in this pool (opsd_shared_team).
+static void register_team(void)
+{
+    int threads = omp_get_max_threads() > mkl_get_max_threads() ? omp_get_max_threads() : mkl_get_max_threads();
+    if (threads <= counter_team)
+        return;
+
+#pragma omp parallel num_threads(threads)
+    {
+        if (!counter_registered)
+        {
+            int fds[OPSD_COUNTER_COUNT];
+            for (int counter = 0; counter < OPSD_COUNTER_COUNT; counter++)
+                fds[counter] = counter_opened[counter] ? open_counter(counter) : -1;
+            register_thread(fds);
+        }
+    }
+    counter_team = threads;
+}
+
+// Returns the number of counters opened. A counter the host does not expose
+// (virtual machines, perf_event_paranoid > 2, no PMU) is reported once and
+// left out; with none at all, the stage table is printed without them.
+int counters_enable(void)
+{
+    int opened = 0, fds[OPSD_COUNTER_COUNT];
+
+    if (opsd_profiling & OPSD_PROFILE_COUNTERS)
+        return OPSD_COUNTER_COUNT;
+
+    for (int counter = 0; counter < OPSD_COUNTER_COUNT; counter++)
+    {
+        fds[counter] = open_counter(counter);
+        counter_opened[counter] = fds[counter] != -1;
+        if (fds[counter] == -1)
+            fprintf(stderr, "Counters: %s unavailable (%s)\n", counter_names[counter], strerror(errno));
+        opened += counter_opened[counter];
+    }
+
+    if (opened && !opsd_shared_team)
+        fprintf(stderr, "Counters: MKL_THREADING_LAYER=%s runs MKL in a pool of its own, its threads are not counted\n",
+                getenv("MKL_THREADING_LAYER"));
+
+    profile_enable();
+    if (opened)
+    {
+        register_thread(fds);
+        register_team();
+        opsd_profiling |= OPSD_PROFILE_COUNTERS;
+    }
+    return opened;
+}
+
+int counter_available(opsd_counter counter)
+{
+    return counter < OPSD_COUNTER_COUNT && counter_opened[counter];
+}
+
+// Scaled by enabled / running time when the PMU multiplexes the counters
+static void read_counters(double *values)
+{
+    memset(values, 0, OPSD_COUNTER_COUNT * sizeof(double));
+
+    pthread_mutex_lock(&stats_lock);
+    for (size_t thread = 0; thread < counter_threads; thread++)
+    {
+        for (int counter = 0; counter < OPSD_COUNTER_COUNT; counter++)
+        {
+            uint64_t data[3];
+            int fd = counter_fds[thread][counter];
+            if (fd != -1 && read(fd, data, sizeof(data)) == sizeof(data) && data[2] > 0)
+                values[counter] += (double)data[0] * data[1] / data[2];
+        }
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void profile_stage_begin(void)
+{
+    int counters = opsd_profiling & OPSD_PROFILE_COUNTERS;
+    if (counters)
+        register_team();
+
+    if (stage_depth < OPSD_STAGE_DEPTH)
+    {
+        stage_windows[stage_depth] = memory_window_open();
+        if (counters)
+            read_counters(counter_starts[stage_depth]);
+    }
+    stage_depth++;
+}
+
+// Stages nested in a measured one are counted in both
+void profile_stage_end(opsd_stage stage)
+{
+    if (stage_depth == 0)
+        return;
+
+    stage_depth--;
+    if (stage_depth >= OPSD_STAGE_DEPTH || stage >= OPSD_STAGE_COUNT)
+        return;
+
+    int counters = opsd_profiling & OPSD_PROFILE_COUNTERS;
+    double values[OPSD_COUNTER_COUNT];
+    if (counters)
+        read_counters(values);
+
+    opsd_memory memory;
+    size_t peak = memory_window_close(stage_windows[stage_depth]);
+    memory_stats(&memory);
+
+    pthread_mutex_lock(&stats_lock);
+    opsd_stage_stats *stats = &stage_stats[stage];
+    for (int counter = 0; counters && counter < OPSD_COUNTER_COUNT; counter++)
+        stats->counters[counter] += values[counter] - counter_starts[stage_depth][counter];
+    stats->memory_live = memory.live;
+    if (peak > stats->memory_peak)
+        stats->memory_peak = peak;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Any binary linked with the library can be profiled without rebuilding it
+__attribute__((constructor)) static void profile_from_environment(void)
+{
+#ifdef OPSD_ITT
+    opsd_itt_domain = __itt_domain_create("OPSD");
+    for (int stage = 0; stage < OPSD_STAGE_COUNT; stage++)
+        opsd_itt_stages[stage] = __itt_string_handle_create(stage_names[stage]);
+#endif
+
+    const char *value = getenv("OPSD_PROFILE");
+    if (value != NULL && value[0] != '\0' && strcmp(value, "0"))
+        profile_enable();
+
+    value = getenv("OPSD_TRACE");
+    if (value != NULL && value[0] != '\0')
+        trace_enable(value);
+
+    value = getenv("OPSD_COUNTERS");
+    if (value != NULL && value[0] != '\0' && strcmp(value, "0"))
+        counters_enable();
+}
+
+const char *profile_stage_name(opsd_stage stage)
+{
+    return stage < OPSD_STAGE_COUNT ? stage_names[stage] : "unknown";
+}
+
+// FLOPs follow the 5 N log2 N model of complex FFTs (2.5 N log2 N for real
+// ones) and per-element counts for the pointwise stages; bytes are the
+// compulsory traffic of one pass. rows x columns is the row-major shape.
+void profile_model(opsd_stage stage, opsd_precision precision, opsd_domain domain, size_t rows, size_t columns,
+                   double *read, double *written, double *flops)
+{
+    double m = rows, n = columns, size = m * n;
+    double spectral = domain == OPSD_REAL ? m * (columns / 2 + 1) : size;
+    double complex_bytes = precision == OPSD_DOUBLE ? sizeof(MKL_Complex16) : sizeof(MKL_Complex8);
+    double fft = (domain == OPSD_REAL ? 2.5 : 5.0) * size * log2(size);
+    double edges = 5.0 * m * log2(m) + 5.0 * n * log2(n);
+
+    *read = spectral * complex_bytes;
+    *written = spectral * complex_bytes;
+    *flops = 0.0;
+    switch (stage)
+    {
+    case OPSD_STAGE_A_FFT2D:
+    case OPSD_STAGE_A_FFT2D_SHIFTED:
+    case OPSD_STAGE_IFFT2D:
+        *flops = fft;
+        break;
+    case OPSD_STAGE_B_BORDER:
+        *read = *written = 2.0 * (m + n) * complex_bytes;
+        *flops = 4.0 * (m + n);
+        break;
+    case OPSD_STAGE_B_EDGES:
+        *read = 2.0 * (m + n) * complex_bytes;
+        *written = (m + n) * complex_bytes;
+        *flops = 2.0 * (m + n) + edges;
+        break;
+    case OPSD_STAGE_C_FFT_BORDER:
+        // Sum of two outer products: 2 complex multiplications and 1 addition
+        *read = (m + n) * complex_bytes;
+        *flops = 14.0 * spectral + edges;
+        break;
+    case OPSD_STAGE_D_SMOOTH:
+        *flops = 4.0 * spectral;
+        break;
+    case OPSD_STAGE_E_PERIODIC:
+        *read = 2.0 * spectral * complex_bytes;
+        *flops = 2.0 * spectral;
+        break;
+    case OPSD_STAGE_CDE_FUSED:
+    case OPSD_STAGE_CDE_FUSED_SHIFTED:
+        *flops = 20.0 * spectral;
+        break;
+    case OPSD_STAGE_FFTSHIFT:
+        break;
+    default:
+        *read = *written = 0.0;
+        break;
+    }
+}
+
+void profile_add(opsd_stage stage, double seconds, double read, double written, double flops, int threads)
+{
+    if (stage >= OPSD_STAGE_COUNT)
+        return;
+
+    pthread_mutex_lock(&stats_lock);
+    opsd_stage_stats *stats = &stage_stats[stage];
+    stats->calls++;
+    stats->time += seconds;
+    stats->bytes_read += read;
+    stats->bytes_written += written;
+    stats->flops += flops;
+    if (threads > stats->threads)
+        stats->threads = threads;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void profile_stats(opsd_stage stage, opsd_stage_stats *stats)
+{
+    pthread_mutex_lock(&stats_lock);
+    *stats = stage < OPSD_STAGE_COUNT ? stage_stats[stage] : (opsd_stage_stats){0};
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void profile_reset(void)
+{
+    pthread_mutex_lock(&stats_lock);
+    memset(stage_stats, 0, sizeof(stage_stats));
+    pthread_mutex_unlock(&stats_lock);
+}
+
+static void print_counter(FILE *file, int width, int available, double value)
+{
+    if (available)
+        fprintf(file, " %*.2f", width, value);
+    else
+        fprintf(file, " %*s", width, "-");
+}
+
+// Counters of the whole process during each compute stage. LLC miss traffic
+// close to the modelled GB/s of the table above means a bandwidth-bound
+// stage; a low IPC with little miss traffic points at latency (strides, TLB).
+// The remote share and GB/s are the memory loads served by another NUMA node.
+static void counters_report(FILE *file)
+{
+    int cycles = counter_available(OPSD_COUNTER_CYCLES), instructions = counter_available(OPSD_COUNTER_INSTRUCTIONS);
+    int llc = counter_available(OPSD_COUNTER_LLC_MISSES), dtlb = counter_available(OPSD_COUNTER_DTLB_MISSES);
+    int remote = counter_available(OPSD_COUNTER_NODE_MISSES), node = remote && counter_available(OPSD_COUNTER_NODE_LOADS);
+
+    fprintf(file, "\n%-18s %10s %10s %6s %9s %9s %10s %8s %11s\n",
+            "stage", "cycles (G)", "instr (G)", "IPC", "LLC MPKI", "dTLB MPKI", "miss GB/s", "remote", "remote GB/s");
+
+    for (int stage = 0; stage < OPSD_STAGE_LOAD; stage++)
+    {
+        opsd_stage_stats stats;
+        profile_stats(stage, &stats);
+        if (stats.calls == 0)
+            continue;
+
+        double *counters = stats.counters;
+        double kilo_instructions = counters[OPSD_COUNTER_INSTRUCTIONS] > 0.0 ? counters[OPSD_COUNTER_INSTRUCTIONS] / 1e3 : 1.0;
+        double time = stats.time > 0.0 ? stats.time : 1e-12;
+
+        fprintf(file, "%-18s", stage_names[stage]);
+        print_counter(file, 10, cycles, counters[OPSD_COUNTER_CYCLES] / 1e9);
+        print_counter(file, 10, instructions, counters[OPSD_COUNTER_INSTRUCTIONS] / 1e9);
+        print_counter(file, 6, cycles && instructions && counters[OPSD_COUNTER_CYCLES] > 0.0,
+                      counters[OPSD_COUNTER_INSTRUCTIONS] / counters[OPSD_COUNTER_CYCLES]);
+        print_counter(file, 9, llc && instructions, counters[OPSD_COUNTER_LLC_MISSES] / kilo_instructions);
+        print_counter(file, 9, dtlb && instructions, counters[OPSD_COUNTER_DTLB_MISSES] / kilo_instructions);
+        print_counter(file, 10, llc, counters[OPSD_COUNTER_LLC_MISSES] * 64.0 / time / 1e9);
+        print_counter(file, 7, node && counters[OPSD_COUNTER_NODE_LOADS] > 0.0,
+                      100.0 * counters[OPSD_COUNTER_NODE_MISSES] / counters[OPSD_COUNTER_NODE_LOADS]);
+        fprintf(file, "%s", node && counters[OPSD_COUNTER_NODE_LOADS] > 0.0 ? "%" : " ");
+        print_counter(file, 11, remote, counters[OPSD_COUNTER_NODE_MISSES] * 64.0 / time / 1e9);
+        fprintf(file, "\n");
+    }
+}
+
+// Stages that never ran are left out. Load and save may overlap compute, so
+// their time is not part of the compute total.
+void profile_report(FILE *file)
+{
+    double compute = 0.0;
+
+    fprintf(file, "\n%-18s %7s %10s %10s %10s %10s %9s %9s %8s %7s %9s %9s\n",
+            "stage", "calls", "total (s)", "mean (ms)", "read (GB)", "write (GB)", "GFLOP/s", "GB/s", "share", "threads",
+            "live (MB)", "peak (MB)");
+
+    for (int stage = 0; stage < OPSD_STAGE_LOAD; stage++)
+    {
+        opsd_stage_stats stats;
+        profile_stats(stage, &stats);
+        compute += stats.time;
+    }
+
+    for (int stage = 0; stage < OPSD_STAGE_COUNT; stage++)
+    {
+        opsd_stage_stats stats;
+        profile_stats(stage, &stats);
+        if (stats.calls == 0)
+            continue;
+
+        double time = stats.time > 0.0 ? stats.time : 1e-12;
+        fprintf(file, "%-18s %7zu %10.4f %10.4f %10.4f %10.4f %9.2f %9.2f ",
+                stage_names[stage], stats.calls, stats.time, stats.time / stats.calls * 1e3,
+                stats.bytes_read / 1e9, stats.bytes_written / 1e9, stats.flops / time / 1e9,
+                (stats.bytes_read + stats.bytes_written) / time / 1e9);
+        if (stage < OPSD_STAGE_LOAD && compute > 0.0)
+            fprintf(file, "%7.1f%% %7d %9.1f %9.1f\n", 100.0 * stats.time / compute, stats.threads,
+                    stats.memory_live / 1e6, stats.memory_peak / 1e6);
+        else
+            fprintf(file, "%8s %7d %9s %9s\n", "-", stats.threads, "-", "-");
+    }
+
+    opsd_memory memory;
+    memory_stats(&memory);
+    fprintf(file, "%-18s %7s %10.4f\n", "compute", "", compute);
+    fprintf(file, "memory: %.1f MB live, %.1f MB peak in %zu allocations, %.1f MB peak RSS\n",
+            memory.live / 1e6, memory.peak / 1e6, memory.allocations, memory.peak_rss / 1e6);
+
+    // Page size the large buffers freed so far really got, after any fallback
+    double paged = 0.0;
+    for (int pages = 0; pages < OPSD_PAGES_COUNT; pages++)
+        paged += memory.paged[pages];
+    if (paged > 0.0)
+    {
+        fprintf(file, "pages: policy %s, large buffers", memory_pages_name(memory_pages()));
+        for (int pages = OPSD_PAGES_COUNT - 1; pages >= 0; pages--)
+        {
+            if (memory.paged[pages])
+                fprintf(file, " %.1f%% %s", 100.0 * memory.paged[pages] / paged, memory_pages_name(pages));
+        }
+        fprintf(file, "\n");
+    }
+
+    // Where the pages of the large buffers were when they were freed
+    double placement[OPSD_NUMA_MAX_NODES], placed = 0.0;
+    int nodes = numa_placement(placement);
+    for (int node = 0; node < nodes; node++)
+        placed += placement[node];
+    if (placed > 0.0)
+    {
+        fprintf(file, "numa: policy %s, large buffers", opsd_numa ? "on" : "off");
+        for (int node = 0; node < nodes; node++)
+        {
+            if (placement[node] > 0.0)
+                fprintf(file, " %.1f%% on node %d", 100.0 * placement[node] / placed, node);
+        }
+        fprintf(file, "\n");
+    }
+
+    if (opsd_profiling & OPSD_PROFILE_COUNTERS)
+        counters_report(file);
+}
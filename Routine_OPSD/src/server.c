@@ -0,0 +1,352 @@
+#define _GNU_SOURCE // memfd_create
+#include "../include/server.h"
+
+#define OPSD_JOB_ALIGNMENT 64
+#define OPSD_CLIENT_TIMEOUT 5 // seconds a connection may stay idle while others wait
+
+// Edge spectra of the last shape served, kept with the plans between jobs
+typedef struct
+{
+    size_t rows, columns;
+    int precision;
+    void *R, *C;
+    size_t jobs;
+    double compute_time;
+} opsd_server;
+
+static volatile sig_atomic_t serving = 1;
+
+static void stop_serving(int signal)
+{
+    (void)signal;
+    serving = 0;
+}
+
+static size_t align_bytes(size_t bytes)
+{
+    return (bytes + OPSD_JOB_ALIGNMENT - 1) & ~(size_t)(OPSD_JOB_ALIGNMENT - 1);
+}
+
+// Job memory: raw | I_t | W. Returns its size, W only taking space when the
+// centered spectrum cannot be produced in place
+static size_t job_layout(const opsd_job *job, int precision, size_t *I_t, size_t *W, size_t *product)
+{
+    size_t real_bytes = precision ? sizeof(double) : sizeof(float), size = job->rows * job->columns;
+    size_t spectral_size, centered_size;
+    frame_sizes(job, &spectral_size, &centered_size);
+
+    *I_t = align_bytes(size * real_bytes);
+    *W = *I_t + align_bytes(spectral_size * 2 * real_bytes);
+    *product = job->products & OPSD_FILTERED ? size * real_bytes : spectral_size * 2 * real_bytes;
+    return *W + centered_size * 2 * real_bytes;
+}
+
+static void release_edges(opsd_server *server)
+{
+    if (server->R == NULL)
+        return;
+
+    if (server->precision)
+    {
+        free_zvector(server->R);
+        free_zvector(server->C);
+    }
+    else
+    {
+        free_cvector(server->R);
+        free_cvector(server->C);
+    }
+    server->R = server->C = NULL;
+}
+
+static void warm_edges(opsd_server *server, size_t rows, size_t columns, int precision)
+{
+    if (server->R != NULL && server->rows == rows && server->columns == columns && server->precision == precision)
+        return;
+
+    release_edges(server);
+    if (precision)
+    {
+        MKL_Complex16 *R = NULL, *C = NULL;
+        init_zvector(&R, columns);
+        init_zvector(&C, rows);
+        server->R = R;
+        server->C = C;
+    }
+    else
+    {
+        MKL_Complex8 *R = NULL, *C = NULL;
+        init_cvector(&R, columns);
+        init_cvector(&C, rows);
+        server->R = R;
+        server->C = C;
+    }
+    server->rows = rows;
+    server->columns = columns;
+    server->precision = precision;
+}
+
+static ssize_t receive_request(int client, opsd_request *request, int *fd)
+{
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec data = {request, sizeof(*request)};
+    struct msghdr message = {0};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    *fd = -1;
+    ssize_t got = recvmsg(client, &message, MSG_CMSG_CLOEXEC);
+
+    struct cmsghdr *header = got > 0 ? CMSG_FIRSTHDR(&message) : NULL;
+    if (header != NULL && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS)
+        memcpy(fd, CMSG_DATA(header), sizeof(int));
+    return got;
+}
+
+static void send_request(int server, const opsd_request *request, int fd)
+{
+    char control[CMSG_SPACE(sizeof(int))] = {0};
+    struct iovec data = {(void *)request, sizeof(*request)};
+    struct msghdr message = {0};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(header), &fd, sizeof(int));
+
+    if (sendmsg(server, &message, 0) != sizeof(*request)) {
+        perror("sendmsg");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static opsd_reply serve_job(opsd_server *server, const opsd_request *request, int fd)
+{
+    opsd_reply reply = {-1, 0, 0, 0.0};
+    unsigned known = OPSD_PLAIN_PRODUCTS | OPSD_SHIFTED_PRODUCTS;
+    if (fd < 0 || request->rows == 0 || request->columns == 0 || request->precision > 1 ||
+        request->domain > OPSD_REAL || request->layout > OPSD_COLUMN_MAJOR ||
+        request->products == 0 || (request->products & ~known))
+        return reply;
+
+    // The shape comes from another process: raw, I_t and W of a double
+    // complex job take at most 40 bytes per element plus the alignment, so
+    // this bound keeps job_layout and every region offset from overflowing
+    if (request->rows > SIZE_MAX / request->columns / (3 * sizeof(MKL_Complex16)))
+        return reply;
+
+    opsd_job job = {request->rows, request->columns, request->domain, request->layout, request->products, 0, "rb", "", 0, 0, NULL, 1, NULL};
+    int precision = request->precision;
+    size_t I_t, W, product, bytes = job_layout(&job, precision, &I_t, &W, &product);
+
+    // Every region, the product included, lies below bytes
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < 0 || (size_t)st.st_size < bytes || I_t > bytes || W > bytes)
+        return reply;
+
+    char *memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+        return reply;
+
+    profile_frame_begin();
+    double start = omp_get_wtime();
+    warm_edges(server, job.rows, job.columns, precision);
+
+    void *result;
+    if (precision)
+        result = compute_zframe(&job, (double *)memory, (MKL_Complex16 *)(memory + I_t),
+                                W < bytes ? (MKL_Complex16 *)(memory + W) : NULL, server->R, server->C);
+    else
+        result = compute_cframe(&job, (float *)memory, (MKL_Complex8 *)(memory + I_t),
+                                W < bytes ? (MKL_Complex8 *)(memory + W) : NULL, server->R, server->C);
+
+    reply.compute_time = omp_get_wtime() - start;
+    profile_frame_end();
+    reply.status = 0;
+    reply.offset = (char *)result - memory;
+    reply.bytes = product;
+    munmap(memory, bytes);
+
+    server->jobs++;
+    server->compute_time += reply.compute_time;
+    printf("Job %zu: %s of %zu x %zu (%s) in %.3f ms\n", server->jobs, frame_product(&job),
+           job.rows, job.columns, precision ? "double" : "single", reply.compute_time * 1e3);
+    fflush(stdout);
+
+    return reply;
+}
+
+// Jobs of a connection run one after another, each with every MKL thread. A
+// connection idle for OPSD_CLIENT_TIMEOUT is closed so the next one is served
+static void serve_client(opsd_server *server, int client)
+{
+    struct timeval timeout = {OPSD_CLIENT_TIMEOUT, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    while (serving)
+    {
+        opsd_request request;
+        int fd;
+        ssize_t got = receive_request(client, &request, &fd);
+        if (got <= 0)
+        {
+            if (got == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                printf("Idle connection closed\n");
+            break;
+        }
+
+        opsd_reply reply = {-1, 0, 0, 0.0};
+        if (got == sizeof(request))
+            reply = serve_job(server, &request, fd);
+        else
+            printf("Malformed request of %zd bytes\n", got);
+        if (fd >= 0)
+            close(fd);
+
+        if (send(client, &reply, sizeof(reply), MSG_NOSIGNAL) != sizeof(reply))
+            break;
+    }
+}
+
+int run_server(const char *path)
+{
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        printf("Socket path too long: %s\n", path);
+        return -6;
+    }
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+
+    int listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listener == -1) {
+        perror("socket");
+        exit(EXIT_FAILURE);
+    }
+
+    unlink(path);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) == -1 || listen(listener, 16) == -1) {
+        perror("Error opening socket");
+        exit(1);
+    }
+
+    // No SA_RESTART: a signal interrupts accept and ends the loop
+    struct sigaction action = {0};
+    action.sa_handler = stop_serving;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("Serving on %s\n", path);
+    fflush(stdout);
+
+    opsd_server server = {0};
+    while (serving)
+    {
+        int client = accept(listener, NULL, NULL);
+        if (client == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("accept");
+            break;
+        }
+
+        serve_client(&server, client);
+        close(client);
+    }
+
+    close(listener);
+    unlink(path);
+    release_edges(&server);
+
+    printf("Served %zu jobs, %.3f s computing\n", server.jobs, server.compute_time);
+    return 0;
+}
+
+// Sends one job: data.bin (or the fm matrix) goes into a memfd shared with the
+// server, which leaves the product in place
+int run_client(const opsd_job *job, int precision, const char *path)
+{
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+
+    int server = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (server == -1 || connect(server, (struct sockaddr *)&address, sizeof(address)) == -1) {
+        perror("Error connecting to the server");
+        exit(1);
+    }
+
+    size_t size = job->rows * job->columns;
+    size_t I_t, W, product, bytes = job_layout(job, precision, &I_t, &W, &product);
+
+    int fd = memfd_create("opsd-job", MFD_CLOEXEC);
+    if (fd == -1 || ftruncate(fd, bytes) == -1) {
+        perror("memfd_create");
+        exit(EXIT_FAILURE);
+    }
+
+    char *memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+
+    char filepath[1024];
+    snprintf(filepath, sizeof(filepath), "../bin/%s/data.bin", job->dir);
+    if (precision && !strcmp(job->input, "rb"))
+        read_dvector_bin(filepath, (double *)memory, size);
+    else if (precision)
+        fill_dmatrix((double *)memory, job->rows, job->columns, job->seed);
+    else if (!strcmp(job->input, "rb"))
+        read_fvector_bin(filepath, (float *)memory, size);
+    else
+        fill_fmatrix((float *)memory, job->rows, job->columns, job->seed);
+
+    opsd_request request = {job->rows, job->columns, job->domain, job->layout, job->products, precision};
+    opsd_reply reply;
+
+    double start = omp_get_wtime();
+    send_request(server, &request, fd);
+    ssize_t got = recv(server, &reply, sizeof(reply), 0);
+    double latency = omp_get_wtime() - start;
+
+    int err_code = 0;
+    if (got != sizeof(reply) || reply.status || reply.offset + reply.bytes > bytes)
+    {
+        printf("The server rejected the job\n");
+        err_code = -6;
+    }
+    else
+    {
+        printf("Job: %s of %zu x %zu in %.3f ms, %.3f ms computing on the server\n",
+               frame_product(job), job->rows, job->columns, latency * 1e3, reply.compute_time * 1e3);
+
+        if (job->save)
+        {
+            snprintf(filepath, sizeof(filepath), "../bin/%s/%s.bin", job->dir, frame_product(job));
+            FILE *file = fopen(filepath, "wb");
+            if (file == NULL) {
+                perror("Erro ao abrir o arquivo para escrita");
+                exit(EXIT_FAILURE);
+            }
+            fwrite(memory + reply.offset, 1, reply.bytes, file);
+            fclose(file);
+        }
+    }
+
+    munmap(memory, bytes);
+    close(fd);
+    close(server);
+    return err_code;
+}
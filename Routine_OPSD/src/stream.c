@@ -0,0 +1,451 @@
+#include "../include/stream.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define OPSD_STREAM_SLOTS 3
+
+typedef struct opsd_stream opsd_stream;
+
+// Frame k lives in slot k % 3: read at step k, computed at step k + 1 and
+// written at step k + 2. The three stages meet at a barrier after each step.
+struct opsd_stream
+{
+    const opsd_job *job;
+    size_t frame_bytes, out_bytes;
+    void *raw[OPSD_STREAM_SLOTS]; // frame as read, reused for data_filtered
+    void *I_t[OPSD_STREAM_SLOTS];
+    void *W[OPSD_STREAM_SLOTS];   // centered spectra that cannot be produced in place
+    void *out[OPSD_STREAM_SLOTS]; // buffer holding the product of each slot
+    void *R, *C;                  // edge spectra, used by the compute stage only
+    void (*compute)(opsd_stream *stream, int slot);
+
+    pthread_barrier_t step;
+    atomic_size_t frames; // frames on stdin, SIZE_MAX until it ends
+    double read_time, compute_time, write_time;
+};
+
+static size_t read_full(int fd, void *buffer, size_t bytes)
+{
+    size_t done = 0;
+    while (done < bytes)
+    {
+        ssize_t got = read(fd, (char *)buffer + done, bytes - done);
+        if (got == 0)
+            break;
+        if (got < 0) {
+            perror("read");
+            exit(EXIT_FAILURE);
+        }
+        done += got;
+    }
+    return done;
+}
+
+static void write_full(int fd, const void *buffer, size_t bytes)
+{
+    size_t done = 0;
+    while (done < bytes)
+    {
+        ssize_t put = write(fd, (const char *)buffer + done, bytes - done);
+        if (put < 0) {
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        done += put;
+    }
+}
+
+static void *read_frames(void *arg)
+{
+    opsd_stream *stream = arg;
+
+    for (size_t step = 0;; step++)
+    {
+        if (step < atomic_load(&stream->frames))
+        {
+            profile_task_begin(OPSD_STAGE_LOAD);
+            double start = omp_get_wtime();
+            size_t got = read_full(STDIN_FILENO, stream->raw[step % OPSD_STREAM_SLOTS], stream->frame_bytes);
+            stream->read_time += omp_get_wtime() - start;
+            if (got > 0)
+                profile_end_io(OPSD_STAGE_LOAD, start, got, 0.0);
+            else
+                profile_task_end();
+
+            if (got < stream->frame_bytes)
+            {
+                if (got > 0)
+                    fprintf(stderr, "Error: incomplete frame at the end of stdin, dropped\n");
+                atomic_store(&stream->frames, step);
+            }
+        }
+
+        pthread_barrier_wait(&stream->step);
+        if (step > atomic_load(&stream->frames))
+            break;
+    }
+
+    return NULL;
+}
+
+static void *write_frames(void *arg)
+{
+    opsd_stream *stream = arg;
+
+    for (size_t step = 0;; step++)
+    {
+        if (step >= 2 && step - 2 < atomic_load(&stream->frames))
+        {
+            profile_task_begin(OPSD_STAGE_SAVE);
+            double start = omp_get_wtime();
+            write_full(STDOUT_FILENO, stream->out[(step - 2) % OPSD_STREAM_SLOTS], stream->out_bytes);
+            stream->write_time += omp_get_wtime() - start;
+            profile_end_io(OPSD_STAGE_SAVE, start, 0.0, stream->out_bytes);
+        }
+
+        pthread_barrier_wait(&stream->step);
+        if (step > atomic_load(&stream->frames))
+            break;
+    }
+
+    return NULL;
+}
+
+// The calling thread computes; stdout only carries frames, so the report goes to stderr
+static void run_stream(opsd_stream *stream)
+{
+    pthread_t reader, writer;
+    atomic_init(&stream->frames, SIZE_MAX);
+    pthread_barrier_init(&stream->step, NULL, 3);
+
+    double start = omp_get_wtime();
+    if (pthread_create(&reader, NULL, read_frames, stream) || pthread_create(&writer, NULL, write_frames, stream)) {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t step = 0;; step++)
+    {
+        if (step >= 1 && step - 1 < atomic_load(&stream->frames))
+        {
+            double begin = omp_get_wtime();
+            stream->compute(stream, (step - 1) % OPSD_STREAM_SLOTS);
+            stream->compute_time += omp_get_wtime() - begin;
+        }
+
+        pthread_barrier_wait(&stream->step);
+        if (step > atomic_load(&stream->frames))
+            break;
+    }
+
+    pthread_join(reader, NULL);
+    pthread_join(writer, NULL);
+    pthread_barrier_destroy(&stream->step);
+
+    double elapsed = omp_get_wtime() - start;
+    size_t frames = atomic_load(&stream->frames);
+    fprintf(stderr, "Stream: %zu frames of %zu x %zu in %.3f s, %.1f frames/s (read %.3f s, compute %.3f s, write %.3f s)\n",
+            frames, stream->job->rows, stream->job->columns, elapsed, frames / elapsed,
+            stream->read_time, stream->compute_time, stream->write_time);
+}
+
+void frame_sizes(const opsd_job *job, size_t *spectral_size, size_t *centered_size)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns;
+    size_t lines = job->layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    int real = job->domain == OPSD_REAL;
+    int centered_in_place = real ? lines % 2 == 0 : rows % 2 == 0 && columns % 2 == 0;
+
+    *spectral_size = real ? lines * (length / 2 + 1) : size;
+    *centered_size = !(job->products & OPSD_PLAIN_PRODUCTS) && !centered_in_place ? *spectral_size : 0;
+}
+
+const char *frame_product(const opsd_job *job)
+{
+    if (job->products & OPSD_FILTERED)
+        return "data_filtered";
+    return job->products & OPSD_PLAIN_PRODUCTS ? "periodic" : "periodic_shifted";
+}
+
+//CVECTOR STREAM
+
+void *compute_cframe(const opsd_job *job, float *raw, MKL_Complex8 *I_t, MKL_Complex8 *W, MKL_Complex8 *R, MKL_Complex8 *C)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns;
+    size_t lines = job->layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    int real = job->domain == OPSD_REAL;
+    int centered_in_place = real ? lines % 2 == 0 : rows % 2 == 0 && columns % 2 == 0;
+    int modulated = !(job->products & OPSD_PLAIN_PRODUCTS) && centered_in_place;
+
+    // A centered frame of even size gets its sign while it is converted
+
+    if (real && modulated)
+    {
+        pad_fvector_rows_from_modulated((float *)I_t, raw, lines, length);
+        compute_cborder_edges_real_modulated(I_t, R, C, rows, columns, job->layout);
+    }
+    else if (real)
+    {
+        pad_fvector_rows_from((float *)I_t, raw, lines, length);
+        compute_cborder_edges_real(I_t, R, C, rows, columns, job->layout);
+    }
+    else if (modulated)
+    {
+        copy_fvector_to_cvector_modulated(I_t, raw, lines, length);
+        compute_cborder_edges_modulated(I_t, R, C, rows, columns, job->layout);
+    }
+    else
+    {
+        copy_fvector_to_cvector(I_t, raw, size);
+        compute_cborder_edges(I_t, R, C, rows, columns, job->layout);
+    }
+
+    if (modulated)
+    {
+        if (real)
+        {
+            compute_cfft2d_real_modulated(I_t, rows, columns, job->layout);
+            compute_cperiodic_component_P_fused_real_shifted(I_t, R, C, NULL, rows, columns, job->layout);
+        }
+        else
+        {
+            compute_cfft2d_modulated(I_t, rows, columns, job->layout);
+            compute_cperiodic_component_P_fused_shifted(I_t, R, C, NULL, rows, columns, job->layout);
+        }
+        return I_t;
+    }
+
+    if (!(job->products & OPSD_PLAIN_PRODUCTS))
+    {
+        MKL_Complex8 *I_w = NULL;
+        if (real)
+        {
+            I_w = compute_cfft2d_real_shifted(I_t, W, rows, columns, job->layout);
+            compute_cperiodic_component_P_fused_real_shifted(I_w, R, C, NULL, rows, columns, job->layout);
+        }
+        else
+        {
+            I_w = compute_cfft2d_shifted(I_t, W, rows, columns, job->layout);
+            compute_cperiodic_component_P_fused_shifted(I_w, R, C, NULL, rows, columns, job->layout);
+        }
+        return I_w;
+    }
+
+    if (real)
+    {
+        compute_cfft2d_real(I_t, rows, columns, job->layout);
+        compute_cperiodic_component_P_fused_real(I_t, R, C, NULL, rows, columns, job->layout);
+    }
+    else
+    {
+        compute_cfft2d(I_t, rows, columns, job->layout);
+        compute_cperiodic_component_P_fused(I_t, R, C, NULL, rows, columns, job->layout);
+    }
+
+    if (!(job->products & OPSD_FILTERED))
+        return I_t;
+
+    if (real)
+    {
+        compute_cifft2d_real(I_t, rows, columns, job->layout);
+        compact_fvector_rows_to(raw, (float *)I_t, lines, length);
+    }
+    else
+    {
+        compute_cifft2d(I_t, rows, columns, job->layout);
+        copy_cvector_to_real_fvector(I_t, raw, size);
+    }
+    return raw;
+}
+
+static void stream_cframe(opsd_stream *stream, int slot)
+{
+    profile_frame_begin();
+    stream->out[slot] = compute_cframe(stream->job, stream->raw[slot], stream->I_t[slot], stream->W[slot], stream->R, stream->C);
+    profile_frame_end();
+}
+
+void run_cstream(const opsd_job *job)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns, spectral_size, centered_size;
+    frame_sizes(job, &spectral_size, &centered_size);
+
+    opsd_stream stream = {0};
+    stream.job = job;
+    stream.compute = stream_cframe;
+    stream.frame_bytes = size * sizeof(float);
+    stream.out_bytes = job->products & OPSD_FILTERED ? size * sizeof(float) : spectral_size * sizeof(MKL_Complex8);
+
+    MKL_Complex8 *R = NULL, *C = NULL;
+    init_cvector(&R, columns);
+    init_cvector(&C, rows);
+    stream.R = R;
+    stream.C = C;
+
+    for (int slot = 0; slot < OPSD_STREAM_SLOTS; slot++)
+    {
+        float *raw = NULL;
+        MKL_Complex8 *I_t = NULL, *W = NULL;
+        init_fvector(&raw, size);
+        init_cvector(&I_t, spectral_size);
+        if (centered_size)
+            init_cvector(&W, centered_size);
+
+        stream.raw[slot] = raw;
+        stream.I_t[slot] = I_t;
+        stream.W[slot] = W;
+    }
+
+    run_stream(&stream);
+
+    for (int slot = 0; slot < OPSD_STREAM_SLOTS; slot++)
+    {
+        if (stream.W[slot] != NULL)
+            free_cvector(stream.W[slot]);
+        free_cvector(stream.I_t[slot]);
+        free_fvector(stream.raw[slot]);
+    }
+    free_cvector(C);
+    free_cvector(R);
+}
+
+//ZVECTOR STREAM
+
+void *compute_zframe(const opsd_job *job, double *raw, MKL_Complex16 *I_t, MKL_Complex16 *W, MKL_Complex16 *R, MKL_Complex16 *C)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns;
+    size_t lines = job->layout == OPSD_ROW_MAJOR ? rows : columns, length = size / lines;
+    int real = job->domain == OPSD_REAL;
+    int centered_in_place = real ? lines % 2 == 0 : rows % 2 == 0 && columns % 2 == 0;
+    int modulated = !(job->products & OPSD_PLAIN_PRODUCTS) && centered_in_place;
+
+
+    if (real && modulated)
+    {
+        pad_dvector_rows_from_modulated((double *)I_t, raw, lines, length);
+        compute_zborder_edges_real_modulated(I_t, R, C, rows, columns, job->layout);
+    }
+    else if (real)
+    {
+        pad_dvector_rows_from((double *)I_t, raw, lines, length);
+        compute_zborder_edges_real(I_t, R, C, rows, columns, job->layout);
+    }
+    else if (modulated)
+    {
+        copy_dvector_to_zvector_modulated(I_t, raw, lines, length);
+        compute_zborder_edges_modulated(I_t, R, C, rows, columns, job->layout);
+    }
+    else
+    {
+        copy_dvector_to_zvector(I_t, raw, size);
+        compute_zborder_edges(I_t, R, C, rows, columns, job->layout);
+    }
+
+    if (modulated)
+    {
+        if (real)
+        {
+            compute_zfft2d_real_modulated(I_t, rows, columns, job->layout);
+            compute_zperiodic_component_P_fused_real_shifted(I_t, R, C, NULL, rows, columns, job->layout);
+        }
+        else
+        {
+            compute_zfft2d_modulated(I_t, rows, columns, job->layout);
+            compute_zperiodic_component_P_fused_shifted(I_t, R, C, NULL, rows, columns, job->layout);
+        }
+        return I_t;
+    }
+
+    if (!(job->products & OPSD_PLAIN_PRODUCTS))
+    {
+        MKL_Complex16 *I_w = NULL;
+        if (real)
+        {
+            I_w = compute_zfft2d_real_shifted(I_t, W, rows, columns, job->layout);
+            compute_zperiodic_component_P_fused_real_shifted(I_w, R, C, NULL, rows, columns, job->layout);
+        }
+        else
+        {
+            I_w = compute_zfft2d_shifted(I_t, W, rows, columns, job->layout);
+            compute_zperiodic_component_P_fused_shifted(I_w, R, C, NULL, rows, columns, job->layout);
+        }
+        return I_w;
+    }
+
+    if (real)
+    {
+        compute_zfft2d_real(I_t, rows, columns, job->layout);
+        compute_zperiodic_component_P_fused_real(I_t, R, C, NULL, rows, columns, job->layout);
+    }
+    else
+    {
+        compute_zfft2d(I_t, rows, columns, job->layout);
+        compute_zperiodic_component_P_fused(I_t, R, C, NULL, rows, columns, job->layout);
+    }
+
+    if (!(job->products & OPSD_FILTERED))
+        return I_t;
+
+    if (real)
+    {
+        compute_zifft2d_real(I_t, rows, columns, job->layout);
+        compact_dvector_rows_to(raw, (double *)I_t, lines, length);
+    }
+    else
+    {
+        compute_zifft2d(I_t, rows, columns, job->layout);
+        copy_zvector_to_real_dvector(I_t, raw, size);
+    }
+    return raw;
+}
+
+static void stream_zframe(opsd_stream *stream, int slot)
+{
+    profile_frame_begin();
+    stream->out[slot] = compute_zframe(stream->job, stream->raw[slot], stream->I_t[slot], stream->W[slot], stream->R, stream->C);
+    profile_frame_end();
+}
+
+void run_zstream(const opsd_job *job)
+{
+    size_t rows = job->rows, columns = job->columns, size = rows * columns, spectral_size, centered_size;
+    frame_sizes(job, &spectral_size, &centered_size);
+
+    opsd_stream stream = {0};
+    stream.job = job;
+    stream.compute = stream_zframe;
+    stream.frame_bytes = size * sizeof(double);
+    stream.out_bytes = job->products & OPSD_FILTERED ? size * sizeof(double) : spectral_size * sizeof(MKL_Complex16);
+
+    MKL_Complex16 *R = NULL, *C = NULL;
+    init_zvector(&R, columns);
+    init_zvector(&C, rows);
+    stream.R = R;
+    stream.C = C;
+
+    for (int slot = 0; slot < OPSD_STREAM_SLOTS; slot++)
+    {
+        double *raw = NULL;
+        MKL_Complex16 *I_t = NULL, *W = NULL;
+        init_dvector(&raw, size);
+        init_zvector(&I_t, spectral_size);
+        if (centered_size)
+            init_zvector(&W, centered_size);
+
+        stream.raw[slot] = raw;
+        stream.I_t[slot] = I_t;
+        stream.W[slot] = W;
+    }
+
+    run_stream(&stream);
+
+    for (int slot = 0; slot < OPSD_STREAM_SLOTS; slot++)
+    {
+        if (stream.W[slot] != NULL)
+            free_zvector(stream.W[slot]);
+        free_zvector(stream.I_t[slot]);
+        free_dvector(stream.raw[slot]);
+    }
+    free_zvector(C);
+    free_zvector(R);
+}
@@ -1,31 +1,23 @@
 #include "../include/utils.h"
+#include "../include/profile.h"
 
-int check_args(const char *BIN, const char *ROUTINE, const char *PRECISION, const char *SAVE_VECTORS, const char *INPUT)
+int check_args(const char *BIN, const char *PRECISION, const char *SAVE_VECTORS, const char *INPUT)
 {
-    if(strcmp(ROUTINE, "ccr") && strcmp(ROUTINE, "css") && strcmp(ROUTINE, "cts")){
-        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed>\n", BIN);
-        printf("Options to <routine>: 'ccr', 'cts', 'css'\n");
-        return -2;
-
-        //compute completed routine - ccr
-        //compute shifted spectrums - css
-        //compute tradicional spectrums - cts
-    }
-
+    // <routine> is validated by parse_routines (pipeline.c)
     if(strcmp(PRECISION, "single") && strcmp(PRECISION, "double")){
-        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed>\n", BIN);
+        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed> [layout] [--mmap] [--batch] [--stream] [--connect <socket>] [--profile] [--trace <file>] [--counters] [--out-of-core] [--dry-run [--machine <csv>]] [--budget <GB>]\n", BIN);
         printf("Options to <precision>: 'single', 'double'\n");
         return -3;
     }
 
     if(strcmp(SAVE_VECTORS, "yes") && strcmp(SAVE_VECTORS, "no")){
-        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed>\n", BIN);
+        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed> [layout] [--mmap] [--batch] [--stream] [--connect <socket>] [--profile] [--trace <file>] [--counters] [--out-of-core] [--dry-run [--machine <csv>]] [--budget <GB>]\n", BIN);
         printf("Options to <save_vectors>: 'yes', 'no'\n");
         return -4;
     }
 
     if(strcmp(INPUT, "rb") && strcmp(INPUT, "fm")){
-        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed>\n", BIN);
+        printf("Use: %s <rows> <columns> <routine> <precision> <save_vectors> <input> <directory> <seed> [layout] [--mmap] [--batch] [--stream] [--connect <socket>] [--profile] [--trace <file>] [--counters] [--out-of-core] [--dry-run [--machine <csv>]] [--budget <GB>]\n", BIN);
         printf("Options to <input>: 'rb', 'fm'\n");
         return -5;
 
@@ -50,7 +42,7 @@ void ensure_directory_exists(const char *path) {
 
 void init_cvector(MKL_Complex8 **vector, size_t size)
 {
-    (*vector) = (MKL_Complex8 *)malloc(size * sizeof(MKL_Complex8));
+    (*vector) = (MKL_Complex8 *)opsd_malloc(size * sizeof(MKL_Complex8));
     if ((*vector) == NULL)
     {
         printf("Allocation error!\n");
@@ -67,7 +59,7 @@ void free_cvector(MKL_Complex8 *vector)
         return;
     }
 
-    free(vector);
+    opsd_free(vector);
 }
 
 void show_cmatrix(MKL_Complex8 *matrix, size_t rows, size_t columns)
@@ -117,6 +109,7 @@ void fill_cmatrix(MKL_Complex8 *matrix, size_t rows, size_t columns, unsigned in
 }
 
 void read_cvector_bin(const char *filename, MKL_Complex8 *vector, size_t size){
+    double start = profile_begin(OPSD_STAGE_LOAD);
     FILE *fp = fopen(filename, "rb");
     if (!fp) {
         perror("Error opening file");
@@ -135,9 +128,11 @@ void read_cvector_bin(const char *filename, MKL_Complex8 *vector, size_t size){
     }
 
     fclose(fp);
+    profile_end_io(OPSD_STAGE_LOAD, start, size * sizeof(MKL_Complex8), 0.0);
 }
 
 void save_cvector_on_bin(const char *filename, MKL_Complex8 *vector, size_t size){
+    double start = profile_begin(OPSD_STAGE_SAVE);
     FILE *file = fopen(filename, "wb");
     if (file == NULL) {
         perror("Erro ao abrir o arquivo para escrita");
@@ -145,10 +140,12 @@ void save_cvector_on_bin(const char *filename, MKL_Complex8 *vector, size_t size
     }
     fwrite(vector, sizeof(MKL_Complex8), size, file);
     fclose(file);
+    profile_end_io(OPSD_STAGE_SAVE, start, 0.0, size * sizeof(MKL_Complex8));
 }
 
 void copy_cvector_to_real_fvector(MKL_Complex8 *cvector, float *fvector, size_t size){
-    for (int i = 0; i < size; i++)
+#pragma omp parallel for
+    for (size_t i = 0; i < size; i++)
     {
         fvector[i] = cvector[i].real;
     }
@@ -165,7 +162,7 @@ void copy_cvector_to_real_dvector(MKL_Complex8 *cvector, double *dvector, size_t
 
 void init_zvector(MKL_Complex16 **vector, size_t size)
 {
-    (*vector) = (MKL_Complex16 *)malloc(size * sizeof(MKL_Complex16));
+    (*vector) = (MKL_Complex16 *)opsd_malloc(size * sizeof(MKL_Complex16));
     if ((*vector) == NULL)
     {
         printf("Allocation error!\n");
@@ -182,7 +179,7 @@ void free_zvector(MKL_Complex16 *vector)
         return;
     }
 
-    free(vector);
+    opsd_free(vector);
 }
 
 void show_zmatrix(MKL_Complex16 *matrix, size_t rows, size_t columns)
@@ -232,6 +229,7 @@ void fill_zmatrix(MKL_Complex16 *matrix, size_t rows, size_t columns, unsigned i
 }
 
 void read_zvector_bin(const char *filename, MKL_Complex16 *vector, size_t size){
+    double start = profile_begin(OPSD_STAGE_LOAD);
     FILE *fp = fopen(filename, "rb");
     if (!fp) {
         perror("Error opening file");
@@ -250,9 +248,11 @@ void read_zvector_bin(const char *filename, MKL_Complex16 *vector, size_t size){
     }
 
     fclose(fp);
+    profile_end_io(OPSD_STAGE_LOAD, start, size * sizeof(MKL_Complex16), 0.0);
 }
 
 void save_zvector_on_bin(const char *filename, MKL_Complex16 *vector, size_t size){
+    double start = profile_begin(OPSD_STAGE_SAVE);
     FILE *file = fopen(filename, "wb");
     if (file == NULL) {
         perror("Erro ao abrir o arquivo para escrita");
@@ -260,6 +260,7 @@ void save_zvector_on_bin(const char *filename, MKL_Complex16 *vector, size_t siz
     }
     fwrite(vector, sizeof(MKL_Complex16), size, file);
     fclose(file);
+    profile_end_io(OPSD_STAGE_SAVE, start, 0.0, size * sizeof(MKL_Complex16));
 }
 
 void copy_zvector_to_real_fvector(MKL_Complex16 *zvector, float *fvector, size_t size){
@@ -270,7 +271,8 @@ void copy_zvector_to_real_fvector(MKL_Complex16 *zvector, float *fvector, size_t
 }
 
 void copy_zvector_to_real_dvector(MKL_Complex16 *zvector, double *dvector, size_t size){
-    for (int i = 0; i < size; i++)
+#pragma omp parallel for
+    for (size_t i = 0; i < size; i++)
     {
         dvector[i] = zvector[i].real;
     }
@@ -280,7 +282,7 @@ void copy_zvector_to_real_dvector(MKL_Complex16 *zvector, double *dvector, size_
 
 void init_fvector(float **vector, size_t size)
 {
-    (*vector) = (float *)malloc(size * sizeof(float));
+    (*vector) = (float *)opsd_malloc(size * sizeof(float));
     if ((*vector) == NULL)
     {
         printf("Allocation error!\n");
@@ -296,11 +298,12 @@ void free_fvector(float *vector){
         return;
     }
 
-    free(vector);
+    opsd_free(vector);
 }
 
 void read_fvector_bin(const char *filename, float *vector, size_t size)
 {
+    double start = profile_begin(OPSD_STAGE_LOAD);
     FILE *fp = fopen(filename, "rb");
     if (!fp) {
         perror("Error opening file");
@@ -319,9 +322,11 @@ void read_fvector_bin(const char *filename, float *vector, size_t size)
     }
 
     fclose(fp);
+    profile_end_io(OPSD_STAGE_LOAD, start, size * sizeof(float), 0.0);
 }
 
 void save_fvector_on_bin(const char *filename, float *vector, size_t size){
+    double start = profile_begin(OPSD_STAGE_SAVE);
     FILE *file = fopen(filename, "wb");
     if (file == NULL) {
         perror("Erro ao abrir o arquivo para escrita");
@@ -329,13 +334,124 @@ void save_fvector_on_bin(const char *filename, float *vector, size_t size){
     }
     fwrite(vector, sizeof(float), size, file);
     fclose(file);
+    profile_end_io(OPSD_STAGE_SAVE, start, 0.0, size * sizeof(float));
+}
+
+void fill_fmatrix(float *matrix, size_t rows, size_t columns, unsigned int seed)
+{
+    if (matrix == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    // Same sequence and positions as fill_cmatrix, so both paths see the same image
+    srand(seed);
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < columns; j++)
+        {
+            float random_real = (float)rand() / RAND_MAX_F;
+            matrix[i + j * rows] = random_real * 4 + 1;
+        }
+    }
+}
+
+// Spreads a contiguous rows x columns image over rows of 2 * (columns / 2 + 1)
+// floats, the layout of the in-place R2C transform.
+void pad_fvector_rows(float *vector, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+    for (size_t i = rows; i-- > 1;)
+    {
+        memmove(&vector[i * ld], &vector[i * columns], columns * sizeof(float));
+    }
+}
+
+void compact_fvector_rows(float *vector, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+    for (size_t i = 1; i < rows; i++)
+    {
+        memmove(&vector[i * columns], &vector[i * ld], columns * sizeof(float));
+    }
+}
+
+// pad_fvector_rows reading the image from 'source' (e.g. a mapped file)
+// instead of moving it in place
+void pad_fvector_rows_from(float *vector, const float *source, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+#pragma omp parallel for
+    for (size_t i = 0; i < rows; i++)
+    {
+        memcpy(&vector[i * ld], &source[i * columns], columns * sizeof(float));
+    }
+}
+
+// pad_fvector_rows negating the odd rows: the sign (-1)^i that centers the
+// rows of the R2C spectrum of an even row count, applied while the rows move
+void pad_fvector_rows_modulated(float *vector, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+    for (size_t i = rows; i-- > 0;)
+    {
+        if (i % 2 == 0)
+            memmove(&vector[i * ld], &vector[i * columns], columns * sizeof(float));
+        else
+            for (size_t j = columns; j-- > 0;)
+                vector[i * ld + j] = -vector[i * columns + j];
+    }
+}
+
+void pad_fvector_rows_from_modulated(float *vector, const float *source, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+#pragma omp parallel for
+    for (size_t i = 0; i < rows; i++)
+    {
+        if (i % 2 == 0)
+            memcpy(&vector[i * ld], &source[i * columns], columns * sizeof(float));
+        else
+            for (size_t j = 0; j < columns; j++)
+                vector[i * ld + j] = -source[i * columns + j];
+    }
+}
+
+void compact_fvector_rows_to(float *target, const float *vector, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+#pragma omp parallel for
+    for (size_t i = 0; i < rows; i++)
+    {
+        memcpy(&target[i * columns], &vector[i * ld], columns * sizeof(float));
+    }
 }
 
 void copy_fvector_to_cvector(MKL_Complex8 *cvector, float *fvector, size_t size)
 {
-    for (int i = 0; i < size; i++)
+#pragma omp parallel for
+    for (size_t i = 0; i < size; i++)
     {
         cvector[i].real = fvector[i];
+        cvector[i].imag = 0;
+    }
+}
+
+// copy_fvector_to_cvector of a rows x columns image times (-1)^(i + j), the
+// sign whose spectrum is the centered one for even sizes. Symmetric in i and
+// j, so rows and columns are those of the memory whatever the layout.
+void copy_fvector_to_cvector_modulated(MKL_Complex8 *cvector, const float *fvector, size_t rows, size_t columns)
+{
+#pragma omp parallel for
+    for (size_t i = 0; i < rows; i++)
+    {
+        float sign = i % 2 == 0 ? 1 : -1;
+        for (size_t j = 0; j < columns; j++, sign = -sign)
+        {
+            cvector[i * columns + j].real = sign * fvector[i * columns + j];
+            cvector[i * columns + j].imag = 0;
+        }
     }
 }
 
@@ -344,6 +460,7 @@ void copy_fvector_to_zvector(MKL_Complex16 *zvector, float *fvector, size_t size
     for (int i = 0; i < size; i++)
     {
         zvector[i].real = fvector[i];
+        zvector[i].imag = 0;
     }
 }
 
@@ -351,7 +468,7 @@ void copy_fvector_to_zvector(MKL_Complex16 *zvector, float *fvector, size_t size
 
 void init_dvector(double **vector, size_t size)
 {
-    (*vector) = (double *)malloc(size * sizeof(double));
+    (*vector) = (double *)opsd_malloc(size * sizeof(double));
     if ((*vector) == NULL)
     {
         printf("Allocation error!\n");
@@ -367,11 +484,12 @@ void free_dvector(double *vector){
         return;
     }
 
-    free(vector);
+    opsd_free(vector);
 }
 
 void read_dvector_bin(const char *filename, double *vector, size_t size)
 {
+    double start = profile_begin(OPSD_STAGE_LOAD);
     FILE *fp = fopen(filename, "rb");
     if (!fp) {
         perror("Error opening file");
@@ -390,9 +508,11 @@ void read_dvector_bin(const char *filename, double *vector, size_t size)
     }
 
     fclose(fp);
+    profile_end_io(OPSD_STAGE_LOAD, start, size * sizeof(double), 0.0);
 }
 
 void save_dvector_on_bin(const char *filename, double *vector, size_t size){
+    double start = profile_begin(OPSD_STAGE_SAVE);
     FILE *file = fopen(filename, "wb");
     if (file == NULL) {
         perror("Erro ao abrir o arquivo para escrita");
@@ -400,6 +520,92 @@ void save_dvector_on_bin(const char *filename, double *vector, size_t size){
     }
     fwrite(vector, sizeof(double), size, file);
     fclose(file);
+    profile_end_io(OPSD_STAGE_SAVE, start, 0.0, size * sizeof(double));
+}
+
+void fill_dmatrix(double *matrix, size_t rows, size_t columns, unsigned int seed)
+{
+    if (matrix == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    // Same sequence and positions as fill_zmatrix, so both paths see the same image
+    srand(seed);
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < columns; j++)
+        {
+            double random_real = (double)rand() / RAND_MAX_D;
+            matrix[i + j * rows] = random_real * 4 + 1;
+        }
+    }
+}
+
+void pad_dvector_rows(double *vector, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+    for (size_t i = rows; i-- > 1;)
+    {
+        memmove(&vector[i * ld], &vector[i * columns], columns * sizeof(double));
+    }
+}
+
+void compact_dvector_rows(double *vector, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+    for (size_t i = 1; i < rows; i++)
+    {
+        memmove(&vector[i * columns], &vector[i * ld], columns * sizeof(double));
+    }
+}
+
+void pad_dvector_rows_from(double *vector, const double *source, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+#pragma omp parallel for
+    for (size_t i = 0; i < rows; i++)
+    {
+        memcpy(&vector[i * ld], &source[i * columns], columns * sizeof(double));
+    }
+}
+
+void pad_dvector_rows_modulated(double *vector, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+    for (size_t i = rows; i-- > 0;)
+    {
+        if (i % 2 == 0)
+            memmove(&vector[i * ld], &vector[i * columns], columns * sizeof(double));
+        else
+            for (size_t j = columns; j-- > 0;)
+                vector[i * ld + j] = -vector[i * columns + j];
+    }
+}
+
+void pad_dvector_rows_from_modulated(double *vector, const double *source, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+#pragma omp parallel for
+    for (size_t i = 0; i < rows; i++)
+    {
+        if (i % 2 == 0)
+            memcpy(&vector[i * ld], &source[i * columns], columns * sizeof(double));
+        else
+            for (size_t j = 0; j < columns; j++)
+                vector[i * ld + j] = -source[i * columns + j];
+    }
+}
+
+void compact_dvector_rows_to(double *target, const double *vector, size_t rows, size_t columns)
+{
+    size_t ld = 2 * (columns / 2 + 1);
+#pragma omp parallel for
+    for (size_t i = 0; i < rows; i++)
+    {
+        memcpy(&target[i * columns], &vector[i * ld], columns * sizeof(double));
+    }
 }
 
 void copy_dvector_to_cvector(MKL_Complex8 *cvector, double *dvector, size_t size)
@@ -407,13 +613,96 @@ void copy_dvector_to_cvector(MKL_Complex8 *cvector, double *dvector, size_t size
     for (int i = 0; i < size; i++)
     {
         cvector[i].real = dvector[i];
+        cvector[i].imag = 0;
     }
 }
 
 void copy_dvector_to_zvector(MKL_Complex16 *zvector, double *dvector, size_t size)
 {
-    for (int i = 0; i < size; i++)
+#pragma omp parallel for
+    for (size_t i = 0; i < size; i++)
     {
         zvector[i].real = dvector[i];
+        zvector[i].imag = 0;
     }
-}
\ No newline at end of file
+}
+
+void copy_dvector_to_zvector_modulated(MKL_Complex16 *zvector, const double *dvector, size_t rows, size_t columns)
+{
+#pragma omp parallel for
+    for (size_t i = 0; i < rows; i++)
+    {
+        double sign = i % 2 == 0 ? 1 : -1;
+        for (size_t j = 0; j < columns; j++, sign = -sign)
+        {
+            zvector[i * columns + j].real = sign * dvector[i * columns + j];
+            zvector[i * columns + j].imag = 0;
+        }
+    }
+}
+
+//MAPPED FILES
+
+// Read-only mapping of the first 'bytes' bytes of an input file
+void *map_input_file(const char *filename, size_t bytes)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        perror("Error opening file");
+        exit(1);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < bytes) {
+        fprintf(stderr, "Error: unexpected end of file\n");
+        close(fd);
+        exit(1);
+    }
+
+    void *map = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+
+    madvise(map, bytes, MADV_SEQUENTIAL);
+    return map;
+}
+
+// Shared mapping of a new 'bytes'-long output file: whatever is stored in the
+// mapping becomes the file contents, without a write() of the whole matrix
+void *map_output_file(const char *filename, size_t bytes)
+{
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        perror("Erro ao abrir o arquivo para escrita");
+        exit(EXIT_FAILURE);
+    }
+
+    if (ftruncate(fd, bytes) == -1) {
+        perror("ftruncate");
+        close(fd);
+        exit(EXIT_FAILURE);
+    }
+
+    void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+
+    return map;
+}
+
+void unmap_file(void *map, size_t bytes)
+{
+    if (map == NULL)
+    {
+        printf("Matrix not found!\n");
+        return;
+    }
+
+    munmap(map, bytes);
+}
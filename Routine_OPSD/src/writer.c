@@ -0,0 +1,185 @@
+#include "../include/writer.h"
+
+// fsync before reporting the write: the barrier promises the products are on disk
+static void write_file(const opsd_write *write)
+{
+    FILE *file = fopen(write->filename, "wb");
+    if (file == NULL) {
+        perror("Erro ao abrir o arquivo para escrita");
+        exit(EXIT_FAILURE);
+    }
+
+    if (fwrite(write->data, 1, write->bytes, file) != write->bytes || fflush(file) || fsync(fileno(file))) {
+        perror("Erro ao escrever o arquivo");
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+}
+
+static void *writer_loop(void *arg)
+{
+    opsd_writer *writer = arg;
+
+    pthread_mutex_lock(&writer->lock);
+    while (1)
+    {
+        while (writer->head == NULL && !writer->stop)
+            pthread_cond_wait(&writer->queued, &writer->lock);
+        if (writer->head == NULL)
+            break;
+
+        opsd_write *write = writer->head;
+        pthread_mutex_unlock(&writer->lock);
+
+        profile_task_begin(OPSD_STAGE_SAVE);
+        double start = omp_get_wtime();
+        write_file(write);
+        double elapsed = omp_get_wtime() - start;
+        profile_end_io(OPSD_STAGE_SAVE, start, 0.0, write->bytes);
+
+        pthread_mutex_lock(&writer->lock);
+        writer->head = write->next;
+        if (writer->head == NULL)
+            writer->tail = NULL;
+        writer->pending--;
+        writer->bytes += write->bytes;
+        writer->write_time += elapsed;
+        pthread_cond_broadcast(&writer->written);
+
+        if (writer->spares < OPSD_WRITER_DEPTH)
+        {
+            write->next = writer->spare;
+            writer->spare = write;
+            writer->spares++;
+        }
+        else
+        {
+            opsd_free(write->snapshot);
+            opsd_free(write);
+        }
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+void writer_start(opsd_writer *writer)
+{
+    memset(writer, 0, sizeof(*writer));
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->queued, NULL);
+    pthread_cond_init(&writer->written, NULL);
+
+    if (pthread_create(&writer->thread, NULL, writer_loop, writer)) {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// A spare whose snapshot holds bytes, otherwise any spare. Under the lock.
+static opsd_write *take_spare(opsd_writer *writer, size_t bytes)
+{
+    opsd_write **link = &writer->spare;
+    while (*link != NULL && (*link)->capacity != bytes)
+        link = &(*link)->next;
+    if (*link == NULL)
+        link = &writer->spare;
+
+    opsd_write *write = *link;
+    if (write != NULL)
+    {
+        *link = write->next;
+        writer->spares--;
+    }
+    return write;
+}
+
+// Products of the same size as earlier ones reuse their entries and snapshot
+// buffers: in steady state a submit does not allocate
+void writer_submit(opsd_writer *writer, const char *filename, void *data, size_t bytes, int flags)
+{
+    int snapshot = flags & OPSD_WRITE_SNAPSHOT;
+
+    pthread_mutex_lock(&writer->lock);
+    double start = omp_get_wtime();
+    while (writer->pending >= OPSD_WRITER_DEPTH)
+        pthread_cond_wait(&writer->written, &writer->lock);
+    writer->wait_time += omp_get_wtime() - start;
+    opsd_write *write = take_spare(writer, snapshot ? bytes : 0);
+    pthread_mutex_unlock(&writer->lock);
+
+    if (write == NULL)
+    {
+        write = opsd_calloc(1, sizeof(opsd_write));
+        if (write == NULL)
+        {
+            printf("Allocation error!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    snprintf(write->filename, sizeof(write->filename), "%s", filename);
+    write->bytes = bytes;
+    write->next = NULL;
+    write->data = data;
+
+    if (snapshot)
+    {
+        if (write->capacity != bytes)
+        {
+            opsd_free(write->snapshot);
+            write->snapshot = opsd_malloc(bytes);
+            if (write->snapshot == NULL)
+            {
+                printf("Allocation error!\n");
+                exit(EXIT_FAILURE);
+            }
+            write->capacity = bytes;
+        }
+        memcpy(write->snapshot, data, bytes);
+        write->data = write->snapshot;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    if (writer->tail != NULL)
+        writer->tail->next = write;
+    else
+        writer->head = write;
+    writer->tail = write;
+    writer->pending++;
+    pthread_cond_signal(&writer->queued);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+// Barrier: every submitted product is on disk and no borrowed buffer is in use
+void writer_drain(opsd_writer *writer)
+{
+    pthread_mutex_lock(&writer->lock);
+    double start = omp_get_wtime();
+    while (writer->pending > 0)
+        pthread_cond_wait(&writer->written, &writer->lock);
+    writer->wait_time += omp_get_wtime() - start;
+    pthread_mutex_unlock(&writer->lock);
+}
+
+void writer_stop(opsd_writer *writer)
+{
+    writer_drain(writer);
+
+    pthread_mutex_lock(&writer->lock);
+    writer->stop = 1;
+    pthread_cond_signal(&writer->queued);
+    pthread_mutex_unlock(&writer->lock);
+
+    pthread_join(writer->thread, NULL);
+    while (writer->spare != NULL)
+    {
+        opsd_write *write = writer->spare;
+        writer->spare = write->next;
+        opsd_free(write->snapshot);
+        opsd_free(write);
+    }
+    pthread_cond_destroy(&writer->written);
+    pthread_cond_destroy(&writer->queued);
+    pthread_mutex_destroy(&writer->lock);
+}
@@ -1,7 +1,5 @@
 #include "aux.h"
 
-#define RAND_MAX_F 2147483647.0f
-
 int main(int argc, char const *argv[])
 {
     if (argc != 3)
@@ -22,24 +20,34 @@ int main(int argc, char const *argv[])
 
     // show_matrix(I_t, rows, columns);
 
-    MKL_Complex8 *B_t = NULL;
-    init_complex_matrix(&B_t, rows, columns);
+    // O motor do Routine_OPSD roda direto sobre os traços column-major: a
+    // borda só sobrevive como os espectros das suas duas arestas
+    MKL_Complex8 *R = (MKL_Complex8 *)opsd_malloc(columns * sizeof(MKL_Complex8));
+    MKL_Complex8 *C = (MKL_Complex8 *)opsd_malloc(rows * sizeof(MKL_Complex8));
+    if (R == NULL || C == NULL)
+    {
+        printf("Allocation error!\n");
+        return 1;
+    }
 
+    // Tempo por etapa: OPSD_PROFILE=1 ./main <M> <N> imprime a tabela da
+    // instrumentação do Routine_OPSD ao final
     double start_ = omp_get_wtime();
 
-    compute_periodic_border_B(I_t, B_t, rows, columns);
-    compute_fft2D_column_row(I_t, rows, columns);
+    compute_cborder_edges(I_t, R, C, rows, columns, OPSD_COLUMN_MAJOR);
+    compute_cfft2d(I_t, rows, columns, OPSD_COLUMN_MAJOR);
     // show_matrix(I_t, rows, columns);
-    compute_fft2D_of_B(B_t, rows, columns);
-    compute_smooth_component_S_2(B_t, rows, columns);
-    compute_periodic_component_P(I_t, B_t, rows, columns);
+    compute_cperiodic_component_P_fused(I_t, R, C, NULL, rows, columns, OPSD_COLUMN_MAJOR);
 
     double end_ = omp_get_wtime();
     double time_spent_ = (end_ - start_);
     printf("Tempo total gasto: %f s\n", time_spent_);
+    show_ram_allocation();
 
     //show_matrix(I_t, rows, columns);
 
-    free_matrix(B_t);
+    opsd_free(C);
+    opsd_free(R);
     free_matrix(I_t);
-}
\ No newline at end of file
+    destroy_plans();
+}
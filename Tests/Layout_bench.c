@@ -0,0 +1,70 @@
+// Escolhe o layout mais rápido para uma forma: roda a rotina completa (edges,
+// FFT 2D, Steps C-E fundidos e IFFT) sobre a mesma matriz em row-major e em
+// column-major e imprime o tempo médio de cada uma.
+// Em Routine_OPSD: make tests && ./bin/Layout_bench <M> <N>
+
+#include "../Routine_OPSD/include/utils.h"
+#include "../Routine_OPSD/include/fourier.h"
+
+#define REPEAT 10
+
+static double run_routine(MKL_Complex8 *I_t, MKL_Complex8 *input, MKL_Complex8 *R, MKL_Complex8 *C,
+                          size_t M, size_t N, opsd_layout layout)
+{
+    // A primeira chamada cria os planos e fica fora da média
+    double total = 0.0;
+    for (int r = 0; r <= REPEAT; r++)
+    {
+        cblas_ccopy(M * N, input, 1, I_t, 1);
+
+        double start = omp_get_wtime();
+        compute_cborder_edges(I_t, R, C, M, N, layout);
+        compute_cfft2d(I_t, M, N, layout);
+        compute_cperiodic_component_P_fused(I_t, R, C, NULL, M, N, layout);
+        compute_cifft2d(I_t, M, N, layout);
+        if (r > 0)
+            total += omp_get_wtime() - start;
+    }
+    return total / REPEAT;
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc != 3)
+    {
+        printf("Use: %s <M> <N>\n", argv[0]);
+        return -1;
+    }
+
+    size_t M = atoi(argv[1]);
+    size_t N = atoi(argv[2]);
+
+    MKL_Complex8 *I_t = NULL, *row_major = NULL, *column_major = NULL, *R = NULL, *C = NULL;
+    init_cvector(&I_t, M * N);
+    init_cvector(&row_major, M * N);
+    init_cvector(&column_major, M * N);
+    init_cvector(&R, N);
+    init_cvector(&C, M);
+
+    fill_cmatrix(row_major, M, N, 1);
+    for (size_t i = 0; i < M; i++)
+        for (size_t j = 0; j < N; j++)
+            column_major[i + j * M] = row_major[j + i * N];
+
+    double t_row = run_routine(I_t, row_major, R, C, M, N, OPSD_ROW_MAJOR);
+    double t_column = run_routine(I_t, column_major, R, C, M, N, OPSD_COLUMN_MAJOR);
+
+    printf("%zu x %zu, %d threads\n", M, N, omp_get_max_threads());
+    printf("Row-major:    %10.6f s\n", t_row);
+    printf("Column-major: %10.6f s\n", t_column);
+    printf("Layout: %s\n", t_row <= t_column ? "row" : "column");
+
+    free_cvector(C);
+    free_cvector(R);
+    free_cvector(column_major);
+    free_cvector(row_major);
+    free_cvector(I_t);
+    destroy_plans();
+
+    return 0;
+}
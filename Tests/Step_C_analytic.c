@@ -0,0 +1,56 @@
+// Confere o Step C analítico (compute_cfft2d_of_border_B) com a versão em lote
+// (compute_cfft2d_of_border_B_batch).
+// Em Routine_OPSD: make tests && ./bin/Step_C_analytic <M> <N>
+
+#include "../Routine_OPSD/include/utils.h"
+#include "../Routine_OPSD/include/fourier.h"
+
+int main(int argc, char const *argv[])
+{
+    if (argc != 3)
+    {
+        printf("Use: %s <M> <N>\n", argv[0]);
+        return -1;
+    }
+
+    size_t M = atoi(argv[1]);
+    size_t N = atoi(argv[2]);
+
+    MKL_Complex8 *I_t = NULL, *B_analytic = NULL, *B_batch = NULL;
+    init_cvector(&I_t, M * N);
+    init_cvector(&B_analytic, M * N);
+    init_cvector(&B_batch, M * N);
+
+    fill_cmatrix(I_t, M, N, 1);
+    compute_cperiodic_border_B(I_t, B_analytic, M, N, OPSD_ROW_MAJOR);
+    compute_cperiodic_border_B(I_t, B_batch, M, N, OPSD_ROW_MAJOR);
+
+    double start = omp_get_wtime();
+    compute_cfft2d_of_border_B_batch(B_batch, M, N, OPSD_ROW_MAJOR);
+    double time_batch = omp_get_wtime() - start;
+
+    start = omp_get_wtime();
+    compute_cfft2d_of_border_B(B_analytic, M, N, OPSD_ROW_MAJOR);
+    double time_analytic = omp_get_wtime() - start;
+
+    double max_err = 0.0, max_ref = 0.0;
+    for (size_t k = 0; k < M * N; k++)
+    {
+        double dr = B_analytic[k].real - B_batch[k].real;
+        double di = B_analytic[k].imag - B_batch[k].imag;
+        double err = sqrt(dr * dr + di * di);
+        double ref = sqrt(B_batch[k].real * B_batch[k].real + B_batch[k].imag * B_batch[k].imag);
+        max_err = err > max_err ? err : max_err;
+        max_ref = ref > max_ref ? ref : max_ref;
+    }
+
+    printf("Lote: %f s, analítico: %f s\n", time_batch, time_analytic);
+    printf("Erro relativo máximo: %e\n", max_err / max_ref);
+
+    free_cvector(B_batch);
+    free_cvector(B_analytic);
+    free_cvector(I_t);
+    destroy_plans();
+
+    return max_err / max_ref < 1e-4 ? 0 : 1;
+}